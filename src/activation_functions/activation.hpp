@@ -0,0 +1,59 @@
+#ifndef FEEDFORWARDNEURALNET_ACTIVATION_H
+#define FEEDFORWARDNEURALNET_ACTIVATION_H
+
+#include "functions_enum.hpp"
+#include "fast_sigmoid.hpp"
+#include "identity.hpp"
+#include "relu.hpp"
+#include "sigmoid.hpp"
+#include "softmax.hpp"
+#include <exception>
+#include <type_traits>
+#include <variant>
+
+class WrongActivationFunction : public std::exception {
+};
+
+/**
+ * Activation function of a layer. The network dispatches on it with std::visit, so the functions
+ * are known at compile time and get inlined into the loops using them.
+ * The alternatives are in the order of ActivationFunction, so index() is the enum value.
+ */
+using Activation_t = std::variant<class Identity, class Sigmoid, class FastSigmoid, class SoftMax, class ReLU>;
+
+static_assert(std::is_same_v<std::variant_alternative_t<ActivationFunction::ReLU, Activation_t>, class ReLU>,
+              "Activation_t alternatives must follow the order of ActivationFunction");
+
+class Activation {
+public:
+    /**
+     * @param activationFunction - activation function type
+     * @return activation function
+     */
+    static Activation_t create(ActivationFunction activationFunction) {
+        switch (activationFunction) {
+            case Identity:
+                return Activation_t{std::in_place_index<Identity>};
+            case Sigmoid:
+                return Activation_t{std::in_place_index<Sigmoid>};
+            case FastSigmoid:
+                return Activation_t{std::in_place_index<FastSigmoid>};
+            case SoftMax:
+                return Activation_t{std::in_place_index<SoftMax>};
+            case ReLU:
+                return Activation_t{std::in_place_index<ReLU>};
+            default:
+                throw WrongActivationFunction();
+        }
+    }
+
+    /**
+     * @param activation - activation function
+     * @return activation function type
+     */
+    static ActivationFunction type(const Activation_t &activation) {
+        return static_cast<ActivationFunction>(activation.index());
+    }
+};
+
+#endif //FEEDFORWARDNEURALNET_ACTIVATION_H
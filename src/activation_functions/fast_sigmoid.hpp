@@ -14,19 +14,21 @@
  */
 class FastSigmoid : public ActivationFunctionTemplate {
 public:
+    static type apply(type x) {
+        return x / (1 + fabsf(x));
+    }
+
+    static type applyDerivative(type x, type) {
+        type denominator = 1 + fabsf(x);
+        return 1 / (denominator * denominator);
+    }
+
     static void normal(Matrix<type> &matrix) {
-        auto fn = [](type x) {
-            return x / (1 + abs(x));
-        };
-        matrix.applyFunction(fn);
+        matrix.applyFunction([](type x) { return apply(x); });
     }
 
     static void derivative(Matrix<type> &matrix) {
-        auto fn = [](type x) {
-            return x / (1 + abs(x));
-        };
-
-        matrix.applyFunction(fn);
+        matrix.applyFunction([](type x) { return applyDerivative(x, apply(x)); });
     }
 };
 
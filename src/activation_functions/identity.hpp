@@ -0,0 +1,23 @@
+#ifndef FEEDFORWARDNEURALNET_IDENTITY_H
+#define FEEDFORWARDNEURALNET_IDENTITY_H
+
+#include "template.hpp"
+
+class Identity : public ActivationFunctionTemplate {
+public:
+    static type apply(type x) {
+        return x;
+    }
+
+    static type applyDerivative(type, type) {
+        return 1;
+    }
+
+    static void normal(Matrix<type> &) {}
+
+    static void derivative(Matrix<type> &matrix) {
+        matrix.applyFunction([](type) { return type{1}; });
+    }
+};
+
+#endif //FEEDFORWARDNEURALNET_IDENTITY_H
@@ -0,0 +1,196 @@
+#ifndef FEEDFORWARDNEURALNET_LAYER_EPILOGUE_H
+#define FEEDFORWARDNEURALNET_LAYER_EPILOGUE_H
+
+#include "activation.hpp"
+#include "../data_structures/gemm.hpp"
+#include <cstdint>
+#include <immintrin.h>
+#include <type_traits>
+#include <variant>
+
+/**
+ * Finishes a layer inside the GEMM computing input * weights: adds the bias, applies the activation
+ * function and stores its derivative while the result tile is still in cache.
+ *
+ * The derivative of ReLU is stored as a bit mask, one 16 bit word per row and 16 columns
+ * (a GEMM tile is exactly Gemm::NR = 16 columns wide, so each tile writes whole words).
+ * The derivatives of the other activation functions are stored as a float matrix.
+ * SoftMax needs whole rows, so only the bias is added here and SoftMax is applied afterwards.
+ */
+class LayerEpilogue {
+    static_assert(Gemm::NR == 16, "ReLU mask words must match the GEMM tile width");
+
+public:
+    using type = float;
+    using Mask_t = uint16_t;
+
+    static constexpr size_t MASK_BITS = 16;
+
+    const type *bias = nullptr;
+    type *derivative = nullptr;  // Derivative matrix (not stored if nullptr)
+    size_t derivativeStride = 0;
+    Mask_t *reluMask = nullptr;  // ReLU derivative bit mask (not stored if nullptr)
+    size_t reluMaskStride = 0;
+
+    /**
+     * Creates the GEMM epilogue for a layer
+     * @param activation - activation function of the layer
+     * @param context - bias and derivative buffers, must outlive the GEMM call
+     * @return epilogue
+     */
+    static GemmEpilogue create(const Activation_t &activation, const LayerEpilogue &context) {
+        return std::visit([&context](const auto &function) -> GemmEpilogue {
+            using Function_t = std::decay_t<decltype(function)>;
+
+            if constexpr (std::is_same_v<Function_t, class ReLU>) {
+                return {.function=reluEpilogue, .context=&context};
+            } else if constexpr (std::is_same_v<Function_t, class Identity> || !Function_t::ELEMENTWISE) {
+                // SoftMax is applied to whole rows afterwards
+                return {.function=biasEpilogue, .context=&context};
+            } else {
+                return {.function=elementwiseEpilogue<Function_t>, .context=&context};
+            }
+        }, activation);
+    }
+
+    /**
+     * Multiplies delta by the derivative stored by the epilogue of the layer
+     * @param activation - activation function of the layer
+     * @param delta - delta of the layer
+     * @param derivative - derivative matrix of the layer (unused for ReLU and Identity)
+     * @param mask - ReLU derivative mask of the layer (unused for other functions)
+     */
+    static void applyDerivative(const Activation_t &activation, Matrix<type> &delta, const Matrix<type> &derivative,
+                                const Mask_t *mask) {
+        std::visit([&](const auto &function) {
+            using Function_t = std::decay_t<decltype(function)>;
+
+            if constexpr (std::is_same_v<Function_t, class ReLU>) {
+                applyReluMask(delta, mask, maskStride(delta.getNumCols()));
+            } else if constexpr (std::is_same_v<Function_t, class Identity>) {
+                // Derivative is one
+            } else if constexpr (Function_t::ELEMENTWISE) {
+                delta *= derivative;
+            } else {
+                // SoftMax derivative is only implemented together with cross entropy in the last layer
+                throw WrongActivationFunction();
+            }
+        }, activation);
+    }
+
+    /**
+     * @param numCols - number of neurons of the layer
+     * @return number of mask words per row
+     */
+    static size_t maskStride(size_t numCols) {
+        return (numCols + MASK_BITS - 1) / MASK_BITS;
+    }
+
+    /**
+     * Multiplies delta by the ReLU derivative stored in the mask (zeroes inactive neurons)
+     * @param delta - delta of the layer
+     * @param mask - mask stored by the epilogue
+     * @param stride - number of mask words per row
+     */
+    static void applyReluMask(Matrix<type> &delta, const Mask_t *mask, size_t stride) {
+        size_t cols = delta.getNumCols();
+        type *row = delta.data();
+
+        for (size_t i = 0; i < delta.getNumRows(); ++i) {
+            const Mask_t *maskRow = mask + i * stride;
+#pragma omp simd
+            for (size_t j = 0; j < cols; ++j) {
+                bool active = (maskRow[j / MASK_BITS] >> (j % MASK_BITS)) & 1;
+                row[j] = active ? row[j] : 0;
+            }
+            row += cols;
+        }
+    }
+
+private:
+    static void biasEpilogue(const void *context, size_t, size_t col, size_t rows, size_t cols,
+                             float *c, size_t ldc) {
+        const auto *ctx = static_cast<const LayerEpilogue *>(context);
+        const type *bias = ctx->bias + col;
+
+        for (size_t i = 0; i < rows; ++i) {
+#pragma omp simd
+            for (size_t j = 0; j < cols; ++j) {
+                c[i * ldc + j] += bias[j];
+            }
+        }
+    }
+
+    static void reluEpilogue(const void *context, size_t row, size_t col, size_t rows, size_t cols,
+                             float *c, size_t ldc) {
+        const auto *ctx = static_cast<const LayerEpilogue *>(context);
+        const type *bias = ctx->bias + col;
+
+        for (size_t i = 0; i < rows; ++i) {
+            float *cRow = c + i * ldc;
+            Mask_t bits;
+
+#ifdef __AVX2__
+            if (cols == MASK_BITS) {
+                __m256 lo = _mm256_add_ps(_mm256_loadu_ps(cRow), _mm256_loadu_ps(bias));
+                __m256 hi = _mm256_add_ps(_mm256_loadu_ps(cRow + 8), _mm256_loadu_ps(bias + 8));
+                __m256 zero = _mm256_setzero_ps();
+                bits = static_cast<Mask_t>(_mm256_movemask_ps(_mm256_cmp_ps(lo, zero, _CMP_GT_OQ)) |
+                                           _mm256_movemask_ps(_mm256_cmp_ps(hi, zero, _CMP_GT_OQ)) << 8);
+                _mm256_storeu_ps(cRow, _mm256_max_ps(lo, zero));
+                _mm256_storeu_ps(cRow + 8, _mm256_max_ps(hi, zero));
+            } else
+#endif
+            {
+                bits = reluRow(cRow, bias, cols);
+            }
+
+            if (ctx->reluMask != nullptr) {
+                ctx->reluMask[(row + i) * ctx->reluMaskStride + col / MASK_BITS] = bits;
+            }
+        }
+    }
+
+    static Mask_t reluRow(float *cRow, const type *bias, size_t cols) {
+        uint32_t bits = 0;
+
+#pragma omp simd reduction(|:bits)
+        for (size_t j = 0; j < cols; ++j) {
+            type x = cRow[j] + bias[j];
+            bits |= static_cast<uint32_t>(x > 0) << j;
+            cRow[j] = ReLU::apply(x);
+        }
+
+        return static_cast<Mask_t>(bits);
+    }
+
+    template<typename ACTIVATION>
+    static void elementwiseEpilogue(const void *context, size_t row, size_t col, size_t rows, size_t cols,
+                                    float *c, size_t ldc) {
+        const auto *ctx = static_cast<const LayerEpilogue *>(context);
+        const type *bias = ctx->bias + col;
+
+        for (size_t i = 0; i < rows; ++i) {
+            float *cRow = c + i * ldc;
+
+            if (ctx->derivative == nullptr) {
+#pragma omp simd
+                for (size_t j = 0; j < cols; ++j) {
+                    cRow[j] = ACTIVATION::apply(cRow[j] + bias[j]);
+                }
+                continue;
+            }
+
+            type *derivRow = ctx->derivative + (row + i) * ctx->derivativeStride + col;
+#pragma omp simd
+            for (size_t j = 0; j < cols; ++j) {
+                type x = cRow[j] + bias[j];
+                type y = ACTIVATION::apply(x);
+                cRow[j] = y;
+                derivRow[j] = ACTIVATION::applyDerivative(x, y);
+            }
+        }
+    }
+};
+
+#endif //FEEDFORWARDNEURALNET_LAYER_EPILOGUE_H
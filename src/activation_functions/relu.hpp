@@ -10,18 +10,20 @@
 
 class ReLU : public ActivationFunctionTemplate {
 public:
+    static type apply(type x) {
+        return std::max(type{}, x);
+    }
+
+    static type applyDerivative(type x, type) {
+        return x > 0 ? 1 : 0;
+    }
+
     static void normal(Matrix<type> &matrix) {
-        auto fn = [](type x) {
-            return std::max(type{}, x);
-        };
-        matrix.applyFunction(fn);
+        matrix.applyFunction([](type x) { return apply(x); });
     }
 
     static void derivative(Matrix<type> &matrix) {
-        auto fn = [](type x) {
-            return x > 0 ? 1 : 0;
-        };
-        matrix.applyFunction(fn);
+        matrix.applyFunction([](type x) { return applyDerivative(x, apply(x)); });
     }
 };
 
@@ -2,22 +2,24 @@
 #define FEEDFORWARDNEURALNET_SIGMOID_H
 
 #include "template.hpp"
+#include "../utils/vector_math.hpp"
 
 class Sigmoid : public ActivationFunctionTemplate {
 public:
+    static type apply(type x) {
+        return 1 / (1 + VectorMath::exp(-x));
+    }
+
+    static type applyDerivative(type, type y) {
+        return y * (1 - y);
+    }
+
     static void normal(Matrix<type> &matrix) {
-        auto fn = [](type x) {
-            return 1 / (1 + expf(-x));
-        };
-        matrix.applyFunction(fn);
+        matrix.applyFunction([](type x) { return apply(x); });
     }
 
     static void derivative(Matrix<type> &matrix) {
-        auto fn = [](type x) {
-            type y = 1 / (1 + expf(-x));
-            return y * (1 - y);
-        };
-        matrix.applyFunction(fn);
+        matrix.applyFunction([](type x) { return applyDerivative(x, apply(x)); });
     }
 };
 
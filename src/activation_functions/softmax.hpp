@@ -6,24 +6,14 @@
 #define FEEDFORWARDNEURALNET_SOFTMAX_H
 
 #include "template.hpp"
+#include "../utils/vector_math.hpp"
 
 class SoftMax : public ActivationFunctionTemplate {
 public:
-    static void normal(Matrix<type> &matrix) {
-        for (size_t i = 0; i < matrix.getNumRows(); ++i) {
-            type rowSum = 0;
-            type rowMax = matrix.getMaxRowElement(i);
-
-            for (size_t j = 0; j < matrix.getNumCols(); ++j) {
-                float item = expf(matrix.getItem(i, j) - rowMax);
-                rowSum += item;
-                matrix.setItem(i, j, item);
-            }
+    static constexpr bool ELEMENTWISE = false;
 
-            for (size_t j = 0; j < matrix.getNumCols(); ++j) {
-                matrix.setItem(i, j, matrix.getItem(i, j) / rowSum);
-            }
-        }
+    static void normal(Matrix<type> &matrix) {
+        VectorMath::softmax(matrix.data(), matrix.getNumRows(), matrix.getNumCols());
     }
 
     // Derivative is implemented ih the cross entropy delta.
@@ -15,18 +15,37 @@ class ActivationFunctionTemplate {
 public:
     using type = float;
 
+    /**
+     * True if the function is applied to each element separately (so it can be fused into the GEMM epilogue),
+     * false if it needs whole rows.
+     */
+    static constexpr bool ELEMENTWISE = true;
+
     /**
      * Computes function at the point x.
      * @param x - point at which we want to compute the function.
      * @return computed value
      */
-    static void normal(Matrix<type> &) {};
+    static type apply(type x) { return x; }
 
     /**
      * Computes function derivative at the point x.
      * @param x - point at which we want to compute the derivative.
+     * @param y - apply(x), so that the derivative can reuse it.
      * @return computed derivative at the point x.
      */
+    static type applyDerivative(type, type) { return 1; }
+
+    /**
+     * Applies the function to each element of the matrix.
+     * @param matrix - matrix to apply the function to.
+     */
+    static void normal(Matrix<type> &) {};
+
+    /**
+     * Replaces each element of the matrix by the function derivative at that point.
+     * @param matrix - matrix to compute the derivative on.
+     */
     static void derivative(Matrix<type> &) {};
 };
 
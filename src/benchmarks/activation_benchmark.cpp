@@ -0,0 +1,136 @@
+#include "benchmark_utils.hpp"
+#include "../activation_functions/layer_epilogue.hpp"
+#include "../data_structures/matrix.hpp"
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Compares the activation dispatch through std::function (the way LayerConfig used to store
+ * the activation functions) with the static dispatch through Activation_t, which fuses the bias add,
+ * the activation function and its derivative into one loop of the GEMM epilogue.
+ */
+
+using ActivationFunction_t = std::function<void(Matrix<float> &)>;
+
+struct DynamicActivation_t {
+    std::string name;
+    ActivationFunction activationType;
+    ActivationFunction_t function;
+    ActivationFunction_t derivative;
+};
+
+/**
+ * Bias add and activation the way the network used to compute them: a bias loop followed by
+ * the std::function activation and derivative passes over the whole matrix.
+ */
+static void dynamicEpilogue(Matrix<float> &output, Matrix<float> &derivative, const std::vector<float> &bias,
+                            const DynamicActivation_t &activation) {
+    for (size_t i = 0; i < output.getNumRows(); ++i) {
+        for (size_t j = 0; j < output.getNumCols(); ++j) {
+            output.setItem(i, j, output.getItem(i, j) + bias[j]);
+        }
+    }
+
+    derivative = output;
+    activation.derivative(derivative);
+    activation.function(output);
+}
+
+/**
+ * Calls the fused epilogue on NR column wide tiles, the way Gemm::sgemm does.
+ */
+static void staticEpilogue(Matrix<float> &output, const GemmEpilogue &epilogue) {
+    for (size_t col = 0; col < output.getNumCols(); col += Gemm::NR) {
+        size_t cols = std::min(Gemm::NR, output.getNumCols() - col);
+        epilogue.function(epilogue.context, 0, col, output.getNumRows(), cols, output.data() + col,
+                          output.getNumCols());
+    }
+}
+
+/**
+ * Creates the epilogue context storing the derivative into derivative (or mask for ReLU).
+ */
+static LayerEpilogue epilogueContext(ActivationFunction activationType, const std::vector<float> &bias,
+                                     Matrix<float> &derivative, std::vector<LayerEpilogue::Mask_t> &mask) {
+    LayerEpilogue context{.bias=bias.data()};
+    if (activationType == ActivationFunction::ReLU) {
+        context.reluMask = mask.data();
+        context.reluMaskStride = LayerEpilogue::maskStride(derivative.getNumCols());
+    } else {
+        context.derivative = derivative.data();
+        context.derivativeStride = derivative.getNumCols();
+    }
+    return context;
+}
+
+int main() {
+    const size_t numInputs = 784;
+    const size_t numNeurons = 900;
+    const std::vector<size_t> batchSizes = {13, 64, 256};
+
+    const std::vector<DynamicActivation_t> activations = {
+            {"ReLU",        ActivationFunction::ReLU,        ReLU::normal,        ReLU::derivative},
+            {"Sigmoid",     ActivationFunction::Sigmoid,     Sigmoid::normal,     Sigmoid::derivative},
+            {"FastSigmoid", ActivationFunction::FastSigmoid, FastSigmoid::normal, FastSigmoid::derivative},
+    };
+
+    std::vector<float> bias(numNeurons);
+    for (size_t j = 0; j < numNeurons; ++j) {
+        bias[j] = 0.01f * static_cast<float>(j % 7) - 0.03f;
+    }
+    auto weights = Matrix<float>::generateRandomUniformMatrix(numInputs, numNeurons, -0.1, 0.1);
+
+    std::cout << "Hidden layer " << numInputs << "x" << numNeurons
+              << ", bias + activation + derivative (std::function = separate passes, static = fused)" << std::endl;
+    std::cout << std::left << std::setw(14) << "activation" << std::setw(8) << "rows"
+              << std::setw(18) << "std::function" << std::setw(12) << "static" << std::setw(10) << "speedup"
+              << std::setw(20) << "layer std::function" << std::setw(14) << "layer static" << "speedup" << std::endl;
+
+    for (const auto &activation: activations) {
+        Activation_t staticActivation = Activation::create(activation.activationType);
+
+        for (size_t rows: batchSizes) {
+            auto input = Matrix<float>::generateRandomUniformMatrix(rows, numInputs, -1, 1);
+            Matrix<float> output(rows, numNeurons);
+            Matrix<float> derivative(rows, numNeurons);
+            std::vector<LayerEpilogue::Mask_t> mask(rows * LayerEpilogue::maskStride(numNeurons));
+
+            auto context = epilogueContext(activation.activationType, bias, derivative, mask);
+            auto epilogue = LayerEpilogue::create(staticActivation, context);
+
+            // Activation only, on a precomputed product
+            auto product = input.matmul(weights);
+            double dynamicTime = BenchmarkUtils::measure([&]() {
+                output = product;
+                dynamicEpilogue(output, derivative, bias, activation);
+            });
+            double staticTime = BenchmarkUtils::measure([&]() {
+                output = product;
+                staticEpilogue(output, epilogue);
+            });
+
+            // Whole layer: GEMM followed by the passes above vs GEMM with the fused epilogue
+            double dynamicLayerTime = BenchmarkUtils::measure([&]() {
+                input.matmul(weights, output);
+                dynamicEpilogue(output, derivative, bias, activation);
+            });
+            double staticLayerTime = BenchmarkUtils::measure([&]() {
+                input.matmul(weights, output, epilogue);
+            });
+
+            std::cout << std::left << std::setw(14) << activation.name << std::setw(8) << rows
+                      << std::fixed << std::setprecision(1)
+                      << std::setw(18) << dynamicTime * 1e6 << std::setw(12) << staticTime * 1e6
+                      << std::setprecision(2) << std::setw(10) << dynamicTime / staticTime
+                      << std::setprecision(1)
+                      << std::setw(20) << dynamicLayerTime * 1e6 << std::setw(14) << staticLayerTime * 1e6
+                      << std::setprecision(2) << dynamicLayerTime / staticLayerTime << std::endl;
+        }
+    }
+
+    std::cout << "(us per call)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include "benchmark_utils.hpp"
+#include "../network/network.hpp"
+#include "../optimizers/adam.hpp"
+#include "../optimizers/sgd.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+/**
+ * Counts heap allocations done by steady-state training steps and by the small batch prediction.
+ * Exits with a non-zero status if either allocates.
+ */
+
+static std::atomic<size_t> numAllocations{0};
+
+void *operator new(size_t size) {
+    ++numAllocations;
+    void *ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+/**
+ * Runs a few warm-up steps and then counts the allocations of the measured steps.
+ * @return number of allocations done by the measured steps
+ */
+static size_t countStepAllocations(Optimizer &optimizer, const TrainValSplit_t &dataset, size_t batchSize) {
+    Config config;
+    config.addLayer(784)
+            .addLayer(900, ActivationFunction::ReLU)
+            .addLayer(450, ActivationFunction::ReLU)
+            .addLayer(10, ActivationFunction::SoftMax);
+
+    Network network(config, &optimizer);
+    size_t numThreads = network.getNumThreads();
+
+    auto batches = DataManager::generateBatches(dataset.trainData, batchSize);
+    auto batchLabels = DataManager::generateVectorBatches(dataset.trainLabels, batchSize);
+    std::vector<std::vector<Matrix<float>>> subBatches;
+    std::vector<std::vector<std::vector<unsigned int>>> subBatchLabels;
+    for (size_t i = 0; i < batches.size(); ++i) {
+        subBatches.push_back(DataManager::generateBatches(batches[i], (batchSize + numThreads - 1) / numThreads));
+        subBatchLabels.push_back(
+                DataManager::generateVectorBatches(batchLabels[i], (batchSize + numThreads - 1) / numThreads));
+    }
+
+    network.reserveWorkspace(batchSize);
+
+    const size_t warmUpSteps = 3;
+    for (size_t i = 0; i < warmUpSteps; ++i) {
+        network.trainStep(subBatches[i], subBatchLabels[i], batchSize, 0.001, 1e-6);
+    }
+
+    size_t before = numAllocations.load();
+    for (size_t i = warmUpSteps; i < subBatches.size(); ++i) {
+        network.trainStep(subBatches[i], subBatchLabels[i], batchSize, 0.001, 1e-6);
+    }
+
+    return numAllocations.load() - before;
+}
+
+/**
+ * Predicts a few rows to warm up the scratch buffers and then counts the allocations of single row predictions.
+ * @return number of allocations done by the measured predictions
+ */
+static size_t countSmallBatchAllocations(Optimizer &optimizer, const TrainValSplit_t &dataset) {
+    Config config;
+    config.addLayer(784)
+            .addLayer(900, ActivationFunction::ReLU)
+            .addLayer(450, ActivationFunction::ReLU)
+            .addLayer(10, ActivationFunction::SoftMax);
+
+    Network network(config, &optimizer);
+    const float *rows = dataset.validationData.data();
+    float output[Gemm::SMALL_M * 10];
+
+    network.predictSmallBatch(rows, Gemm::SMALL_M, output);
+
+    size_t before = numAllocations.load();
+    for (size_t i = 0; i < 100; ++i) {
+        network.predictSmallBatch(rows + i * 784, 1, output);
+    }
+
+    return numAllocations.load() - before;
+}
+
+int main() {
+    const size_t batchSize = 64;
+    auto dataset = BenchmarkUtils::syntheticDataset(1000);
+
+    AdamOptimizer adam;
+    SGDOptimizer sgd;
+    size_t adamAllocations = countStepAllocations(adam, dataset, batchSize);
+    size_t sgdAllocations = countStepAllocations(sgd, dataset, batchSize);
+
+    std::cout << "Allocations in steady-state training steps (Adam): " << adamAllocations << std::endl;
+    std::cout << "Allocations in steady-state training steps (SGD):  " << sgdAllocations << std::endl;
+
+    if (adamAllocations != 0 || sgdAllocations != 0) {
+        std::cout << "FAILED: training step allocates" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    size_t predictAllocations = countSmallBatchAllocations(sgd, dataset);
+    std::cout << "Allocations in single row predictions:             " << predictAllocations << std::endl;
+    if (predictAllocations != 0) {
+        std::cout << "FAILED: small batch prediction allocates" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "OK" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#ifndef FEEDFORWARDNEURALNET_BENCHMARK_UTILS_H
+#define FEEDFORWARDNEURALNET_BENCHMARK_UTILS_H
+
+#include "../csv/csv_reader.hpp"
+#include "../data_manager/data_manager.hpp"
+#include "../data_manager/tensor_file.hpp"
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Helpers shared by the benchmark executables
+ */
+class BenchmarkUtils {
+public:
+    /**
+     * Runs fn repeatedly (at least once) until minSeconds have passed.
+     * @param fn - function to measure
+     * @param minSeconds - minimal measured time
+     * @return average time of a single run in seconds
+     */
+    template<typename F>
+    static double measure(F &&fn, double minSeconds = 0.5) {
+        // Warm up caches, packing buffers, ...
+        fn();
+
+        size_t runs = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        double elapsed = 0;
+
+        do {
+            fn();
+            ++runs;
+            elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        } while (elapsed < minSeconds);
+
+        return elapsed / static_cast<double>(runs);
+    }
+
+    /**
+     * Generates a Fashion-MNIST shaped classification dataset (each class is a gaussian blob
+     * around its own random center), so that the benchmarks do not depend on the CSV files.
+     * @param numSamples - number of samples
+     * @param numFeatures - number of features per sample
+     * @param numClasses - number of classes
+     * @param trainRatio - ratio of the training part
+     * @return split dataset
+     */
+    static TrainValSplit_t syntheticDataset(size_t numSamples = 6000, size_t numFeatures = 784,
+                                            size_t numClasses = 10, float trainRatio = 9.f / 10) {
+        std::mt19937 generator(42);
+        std::normal_distribution<float> distribution(0, 1);
+
+        Matrix<float> centers(numClasses, numFeatures);
+        for (size_t i = 0; i < numClasses; ++i) {
+            for (size_t j = 0; j < numFeatures; ++j) {
+                centers.setItem(i, j, distribution(generator) * 0.3f);
+            }
+        }
+
+        Matrix<float> data(numSamples, numFeatures);
+        std::vector<unsigned int> labels(numSamples);
+        for (size_t i = 0; i < numSamples; ++i) {
+            labels[i] = i % numClasses;
+            for (size_t j = 0; j < numFeatures; ++j) {
+                data.setItem(i, j, centers.getItem(labels[i], j) + distribution(generator));
+            }
+        }
+
+        return DataManager::trainValidateSplit(std::move(data), std::move(labels), trainRatio);
+    }
+
+    /**
+     * Loads a part of Fashion-MNIST (the .bin tensor files if present, the CSV files otherwise)
+     * @param directory - directory with the dataset files
+     * @param part - "train" or "test"
+     * @param vectors - the normalized data vectors
+     * @param labels - the labels
+     * @return false if the part is not in the directory
+     */
+    static bool fashionMnistPart(const std::string &directory, const std::string &part, Matrix<float> &vectors,
+                                 std::vector<unsigned int> &labels) {
+        std::string vectorsPath = directory + "/fashion_mnist_" + part + "_vectors";
+        std::string labelsPath = directory + "/fashion_mnist_" + part + "_labels";
+        Matrix<unsigned int> labelsMatrix;
+
+        if (std::filesystem::exists(vectorsPath + ".bin") && std::filesystem::exists(labelsPath + ".bin")) {
+            vectors = TensorFile::map<float>((vectorsPath + ".bin").c_str());
+            labelsMatrix = TensorFile::map<unsigned int>((labelsPath + ".bin").c_str());
+        } else if (std::filesystem::exists(vectorsPath + ".csv") && std::filesystem::exists(labelsPath + ".csv")) {
+            CsvReader<float> vectorsReader((vectorsPath + ".csv").c_str(), 784);
+            vectorsReader.normalize();
+            vectors = vectorsReader.getDataMatrixRvalRef();
+            CsvReader<unsigned int> labelsReader((labelsPath + ".csv").c_str(), 1);
+            labelsMatrix = labelsReader.getDataMatrixRvalRef();
+        } else {
+            return false;
+        }
+
+        labels = labelsMatrix.getMatrixCol(0);
+        return true;
+    }
+
+    /**
+     * Loads the Fashion-MNIST training set (the .bin tensor files if present, the CSV files otherwise)
+     * @param directory - directory with the dataset files
+     * @param split - the normalized dataset, split into training and validation set
+     * @param trainRatio - ratio of the training part
+     * @return false if the dataset is not in the directory
+     */
+    static bool fashionMnist(const std::string &directory, TrainValSplit_t &split, float trainRatio = 9.f / 10) {
+        Matrix<float> vectors;
+        std::vector<unsigned int> labels;
+        if (!fashionMnistPart(directory, "train", vectors, labels)) {
+            return false;
+        }
+
+        split = DataManager::trainValidateSplit(std::move(vectors), std::move(labels), trainRatio);
+        return true;
+    }
+};
+
+#endif //FEEDFORWARDNEURALNET_BENCHMARK_UTILS_H
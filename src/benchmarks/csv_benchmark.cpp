@@ -0,0 +1,113 @@
+#include "benchmark_utils.hpp"
+#include "../csv/csv_reader.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Parsing throughput of CsvReader on the Fashion-MNIST CSV files, compared with the original
+ * getline + istringstream + std::stof parser (kept here as the baseline).
+ *
+ * Usage: CsvBenchmark [dataDirectory] (./data by default). If the Fashion-MNIST files are not there,
+ * a synthetic file of the same shape is generated.
+ */
+
+template<typename ELEMENT_TYPE>
+static Matrix<ELEMENT_TYPE> getlineParse(const char *path, int numCols) {
+    std::vector<std::vector<ELEMENT_TYPE>> data;
+    std::ifstream f(path);
+    std::string line;
+    std::string elem;
+
+    while (std::getline(f, line)) {
+        data.emplace_back(numCols, 0);
+        auto &currentRow = data[data.size() - 1];
+        size_t currentIndex = 0;
+
+        std::istringstream ss(line);
+        while (std::getline(ss, elem, ',')) {
+            currentRow[currentIndex++] = std::stof(elem);
+        }
+    }
+
+    return Matrix<ELEMENT_TYPE>(std::move(data));
+}
+
+/**
+ * Writes a CSV file shaped like the Fashion-MNIST vectors (pixel values 0-255)
+ */
+static void writeSyntheticVectors(const std::string &path, size_t rows, size_t cols) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    std::ofstream file(path);
+
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            // Fashion-MNIST images are mostly background
+            file << (distribution(generator) < 128 ? 0 : distribution(generator)) << (j + 1 < cols ? ',' : '\n');
+        }
+    }
+}
+
+template<typename ELEMENT_TYPE>
+static void benchmarkFile(const std::string &path, int numCols) {
+    double megabytes = static_cast<double>(std::filesystem::file_size(path)) / 1e6;
+
+    // The baseline takes seconds, it is measured only once (after the warm-up run)
+    Matrix<ELEMENT_TYPE> baseline;
+    double getlineTime = BenchmarkUtils::measure([&]() {
+        baseline = getlineParse<ELEMENT_TYPE>(path.c_str(), numCols);
+    }, 0);
+    Matrix<ELEMENT_TYPE> parsed;
+    double readerTime = BenchmarkUtils::measure([&]() {
+        CsvReader<ELEMENT_TYPE> reader(path.c_str(), numCols);
+        parsed = reader.getDataMatrixRvalRef();
+    }, 1);
+
+    bool same = parsed.getNumRows() == baseline.getNumRows() && parsed.getNumCols() == baseline.getNumCols();
+    for (size_t i = 0; same && i < parsed.getNumRows(); ++i) {
+        for (size_t j = 0; j < parsed.getNumCols(); ++j) {
+            same = same && parsed.getItem(i, j) == baseline.getItem(i, j);
+        }
+    }
+
+    std::cout << std::left << std::setw(40) << std::filesystem::path(path).filename().string() << std::fixed
+              << std::setprecision(1) << std::setw(10) << megabytes << std::setw(16) << megabytes / getlineTime
+              << std::setw(16) << megabytes / readerTime << std::setw(10) << getlineTime / readerTime
+              << (same ? "same" : "DIFFERENT") << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::string directory = argc > 1 ? argv[1] : "./data";
+    std::string vectorsPath = directory + "/fashion_mnist_train_vectors.csv";
+    std::string labelsPath = directory + "/fashion_mnist_train_labels.csv";
+    std::string syntheticPath;
+
+    if (!std::filesystem::exists(vectorsPath)) {
+        syntheticPath = (std::filesystem::temp_directory_path() / "ffnn_csv_benchmark.csv").string();
+        std::cout << "Fashion-MNIST not found in " << directory << ", using synthetic 60000x784 vectors" << std::endl;
+        writeSyntheticVectors(syntheticPath, 60000, 784);
+        vectorsPath = syntheticPath;
+    }
+
+    std::cout << "Threads: " << omp_get_max_threads() << std::endl;
+    std::cout << std::left << std::setw(40) << "file" << std::setw(10) << "MB" << std::setw(16) << "getline MB/s"
+              << std::setw(16) << "CsvReader MB/s" << std::setw(10) << "speedup" << "result" << std::endl;
+
+    benchmarkFile<float>(vectorsPath, 784);
+    if (std::filesystem::exists(labelsPath)) {
+        benchmarkFile<unsigned int>(labelsPath, 1);
+    }
+
+    if (!syntheticPath.empty()) {
+        std::remove(syntheticPath.c_str());
+    }
+    return 0;
+}
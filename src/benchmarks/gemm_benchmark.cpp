@@ -0,0 +1,130 @@
+#include "benchmark_utils.hpp"
+#include "../data_structures/gemm.hpp"
+#include "../data_structures/matrix.hpp"
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * The original Matrix::matmul loop, kept here as the baseline.
+ */
+static Matrix<float> naiveMatmul(const Matrix<float> &lhs, const Matrix<float> &rhs) {
+    Matrix<float> res(lhs.getNumRows(), rhs.getNumCols(), 0);
+    float *out = res.data();
+
+    for (size_t i = 0; i < lhs.getNumRows(); ++i) {
+        for (size_t k = 0; k < lhs.getNumCols(); ++k) {
+            float x = lhs.getItem(i, k);
+#pragma omp simd
+            for (size_t j = 0; j < rhs.getNumCols(); ++j) {
+                out[i * res.getNumCols() + j] += x * rhs.getItem(k, j);
+            }
+        }
+    }
+
+    return res;
+}
+
+static float maxAbsDiff(const Matrix<float> &lhs, const Matrix<float> &rhs) {
+    float diff = 0;
+    for (size_t i = 0; i < lhs.getNumRows(); ++i) {
+        for (size_t j = 0; j < lhs.getNumCols(); ++j) {
+            diff = std::max(diff, std::fabs(lhs.getItem(i, j) - rhs.getItem(i, j)));
+        }
+    }
+    return diff;
+}
+
+struct GemmShape {
+    std::string name;
+    size_t m;
+    size_t k;
+    size_t n;
+    bool transA = false;
+    bool transB = false;
+};
+
+/**
+ * Computes op(a) * op(b) with the fused transposed variants of matmul.
+ */
+static Matrix<float> fusedMatmul(const Matrix<float> &a, const Matrix<float> &b, bool transA, bool transB) {
+    if (transA && transB) return a.matmulTT(b);
+    if (transA) return a.matmulTN(b);
+    if (transB) return a.matmulNT(b);
+    return a.matmul(b);
+}
+
+/**
+ * Computes op(a) * op(b) the way the network used to, transposing explicitly.
+ */
+static Matrix<float> explicitMatmul(Matrix<float> a, Matrix<float> b, bool transA, bool transB) {
+    if (transA) a = a.transpose();
+    if (transB) b = b.transpose();
+    return naiveMatmul(a, b);
+}
+
+int main() {
+    // Topology 784x900x450x10, batch of 64 split between 5 threads (13 rows per thread)
+    // and prediction over the 10000 test samples.
+    const size_t subBatch = 13;
+    const std::vector<GemmShape> shapes = {
+            {"forward  L1",            subBatch, 784, 900},
+            {"forward  L2",            subBatch, 900, 450},
+            {"forward  L3",            subBatch, 450, 10},
+            {"backward delta L3 NT",   subBatch, 10,  450, false, true},
+            {"backward delta L2 NT",   subBatch, 450, 900, false, true},
+            {"backward grad L1 TN",    784,      subBatch, 900, true, false},
+            {"backward grad L2 TN",    900,      subBatch, 450, true, false},
+            {"backward grad L3 TN",    450,      subBatch, 10, true, false},
+            {"predict  L1",            10000,    784, 900},
+            {"predict  L2",            10000,    900, 450},
+    };
+
+    std::vector<Gemm::Kernel> kernels = {Gemm::Kernel::Scalar};
+    if (Gemm::isSupported(Gemm::Kernel::Avx2)) {
+        kernels.push_back(Gemm::Kernel::Avx2);
+    }
+    auto defaultKernel = Gemm::getKernel();
+
+    std::cout << "Selected kernel: " << Gemm::kernelName(defaultKernel) << std::endl;
+    std::cout << "naive = original loop with explicit transposes, scalar/avx2+fma = blocked GEMM" << std::endl;
+    std::cout << std::left << std::setw(24) << "shape" << std::setw(18) << "m x k x n"
+              << std::setw(12) << "naive" << std::setw(12) << "scalar" << std::setw(12) << "avx2+fma"
+              << "max err" << std::endl;
+
+    for (const auto &shape: shapes) {
+        auto a = shape.transA ? Matrix<float>::generateRandomUniformMatrix(shape.k, shape.m, -1, 1)
+                              : Matrix<float>::generateRandomUniformMatrix(shape.m, shape.k, -1, 1);
+        auto b = shape.transB ? Matrix<float>::generateRandomUniformMatrix(shape.n, shape.k, -1, 1)
+                              : Matrix<float>::generateRandomUniformMatrix(shape.k, shape.n, -1, 1);
+        double flops = 2.0 * static_cast<double>(shape.m * shape.k * shape.n);
+
+        auto reference = explicitMatmul(a, b, shape.transA, shape.transB);
+        double naiveTime = BenchmarkUtils::measure(
+                [&]() { explicitMatmul(a, b, shape.transA, shape.transB); });
+
+        std::cout << std::left << std::setw(24) << shape.name
+                  << std::setw(18) << (std::to_string(shape.m) + "x" + std::to_string(shape.k) + "x" +
+                                       std::to_string(shape.n))
+                  << std::setw(12) << std::fixed << std::setprecision(2) << flops / naiveTime * 1e-9;
+
+        float err = 0;
+        for (auto kernel: kernels) {
+            Gemm::setKernel(kernel);
+            err = std::max(err, maxAbsDiff(reference, fusedMatmul(a, b, shape.transA, shape.transB)));
+            double time = BenchmarkUtils::measure([&]() { fusedMatmul(a, b, shape.transA, shape.transB); });
+            std::cout << std::setw(12) << flops / time * 1e-9;
+        }
+        if (kernels.size() == 1) {
+            std::cout << std::setw(12) << "-";
+        }
+
+        std::cout << std::scientific << std::setprecision(2) << err << std::endl;
+    }
+
+    std::cout << "(GFLOP/s)" << std::endl;
+    Gemm::setKernel(defaultKernel);
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "benchmark_utils.hpp"
+#include "../network/inference_model.hpp"
+#include "../optimizers/sgd.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/**
+ * Throughput of one InferenceModel shared by 1..N threads, each predicting batches with its own scratch,
+ * on the 784x900x450x10 topology. Prints the samples per second and the speedup for single samples and
+ * for batches, and the largest difference from Network::predict.
+ * Usage: InferenceScalingBenchmark [maxThreads] [seconds]
+ */
+
+/**
+ * Predicts batches of the samples on the given number of threads for the given time
+ * @return predicted samples per second
+ */
+static double measureThroughput(const InferenceModel &model, const Matrix<float> &samples, size_t rows,
+                                size_t numThreads, double seconds) {
+    size_t numBatches = samples.getNumRows() / rows;
+    size_t batchSize = rows * samples.getNumCols();
+    std::atomic<size_t> numPredicted = 0;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::duration<double>(seconds);
+
+    for (size_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            auto scratch = model.createScratch();
+            std::vector<float> output(rows * model.getNumOutputs());
+            size_t predicted = 0;
+
+            for (size_t i = t; std::chrono::steady_clock::now() < end; i += numThreads) {
+                model.predict(samples.data() + i % numBatches * batchSize, rows, output.data(), scratch);
+                predicted += rows;
+            }
+            numPredicted += predicted;
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(numPredicted) / elapsed;
+}
+
+int main(int argc, char **argv) {
+    size_t maxThreads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    double seconds = argc > 2 ? std::strtod(argv[2], nullptr) : 2;
+
+    auto dataset = BenchmarkUtils::syntheticDataset(2000);
+    const auto &samples = dataset.validationData;
+
+    Config config;
+    config.addLayer(784)
+            .addLayer(900, ActivationFunction::ReLU)
+            .addLayer(450, ActivationFunction::ReLU)
+            .addLayer(10, ActivationFunction::SoftMax);
+
+    SGDOptimizer sgd;
+    Network network(config, &sgd, 1);
+    InferenceModel model(network);
+
+    auto scratch = model.createScratch();
+    auto expected = network.predict(samples);
+    auto predicted = model.predict(samples, scratch);
+    float maxDifference = 0;
+    for (size_t i = 0; i < samples.getNumRows() * model.getNumOutputs(); ++i) {
+        maxDifference = std::max(maxDifference, std::abs(expected.data()[i] - predicted.data()[i]));
+    }
+    std::cout << "Max difference from Network::predict: " << maxDifference << std::endl;
+
+    std::cout << std::left << std::setw(8) << "rows" << std::setw(10) << "threads" << std::setw(16) << "samples/s"
+              << "speedup" << std::endl;
+
+    for (size_t rows: {size_t(1), InferenceModel::ROW_BLOCK}) {
+        double singleThread = 0;
+        for (size_t threads = 1; threads <= maxThreads; ++threads) {
+            double throughput = measureThroughput(model, samples, rows, threads, seconds);
+            if (threads == 1) {
+                singleThread = throughput;
+            }
+
+            std::cout << std::left << std::setw(8) << rows << std::setw(10) << threads << std::setw(16) << std::fixed
+                      << std::setprecision(0) << throughput << std::setprecision(2) << throughput / singleThread
+                      << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "benchmark_utils.hpp"
+#include "../network/network.hpp"
+#include "../optimizers/adam.hpp"
+#include "../optimizers/lamb.hpp"
+#include "../schedulers/schedules.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Time-to-accuracy of small batch training with Adam against large batch training: Adam with the learning rate
+ * scaled with the batch size and LAMB with a learning rate warmup. Each run trains the 784x900x450x10 network
+ * epoch by epoch until the test accuracy reaches the target (or maxEpochs pass) and reports the training time
+ * it took, excluding the evaluation.
+ *
+ * Usage: LargeBatchBenchmark [dataDirectory] [targetAccuracy] [maxEpochs] (./data, 85 and 20 by default).
+ * If Fashion-MNIST is not in the directory, a synthetic dataset of the same shape is used (its validation
+ * part is the test set then).
+ */
+
+/**
+ * One way of training the network
+ */
+struct Approach_t {
+    const char *name;
+    Optimizer *optimizer;
+    size_t batchSize;
+    float eta;
+    unsigned int warmupSamples;  // Learning rate warmup (number of samples), 0 for none
+};
+
+/**
+ * Trains the network with the approach until the accuracy on the test set reaches the target
+ */
+static void timeToAccuracy(const TrainValSplit_t &dataset, const Matrix<float> &testData,
+                           const std::vector<unsigned int> &testLabels, const Approach_t &approach,
+                           float targetAccuracy, size_t maxEpochs) {
+    Config config;
+    config.addLayer(784)
+            .addLayer(900, ActivationFunction::ReLU)
+            .addLayer(450, ActivationFunction::ReLU)
+            .addLayer(10, ActivationFunction::SoftMax);
+
+    Network network(config, approach.optimizer);
+    ExponentialScheduler exponential(approach.eta / 100, 0.85, 30000);
+    WarmupScheduler sched(exponential, approach.warmupSamples);
+
+    double trainSeconds = 0;
+    double secondsToTarget = 0;
+    size_t epochsToTarget = 0;
+    float bestAccuracy = 0;
+    for (size_t epoch = 1; epoch <= maxEpochs && epochsToTarget == 0; ++epoch) {
+        auto start = std::chrono::high_resolution_clock::now();
+        network.fit(dataset, 1, approach.batchSize, approach.eta, 1e-6, 0, &sched);
+        trainSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        float accuracy = Stats::getStats(network.predict(testData), testLabels).accuracy;
+        bestAccuracy = std::max(bestAccuracy, accuracy);
+        if (accuracy >= targetAccuracy) {
+            epochsToTarget = epoch;
+            secondsToTarget = trainSeconds;
+        }
+    }
+
+    const auto &timings = network.getTimings();
+    std::cout << std::left << std::setw(28) << approach.name << std::setw(8) << approach.batchSize << std::fixed
+              << std::setprecision(3) << std::setw(10) << approach.eta << std::setw(12) << std::setprecision(2)
+              << static_cast<double>(timings.stepUs) / static_cast<double>(timings.numSteps) / 1000;
+    if (epochsToTarget != 0) {
+        std::cout << std::setw(10) << epochsToTarget << std::setw(14) << secondsToTarget;
+    } else {
+        std::cout << std::setw(10) << "-" << std::setw(14) << "-";
+    }
+    std::cout << bestAccuracy << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::string directory = argc > 1 ? argv[1] : "./data";
+    float targetAccuracy = argc > 2 ? std::strtof(argv[2], nullptr) : 85;
+    size_t maxEpochs = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 20;
+
+    TrainValSplit_t dataset;
+    Matrix<float> testData;
+    std::vector<unsigned int> testLabels;
+    if (BenchmarkUtils::fashionMnist(directory, dataset) &&
+        BenchmarkUtils::fashionMnistPart(directory, "test", testData, testLabels)) {
+        std::cout << "Fashion-MNIST";
+    } else {
+        dataset = BenchmarkUtils::syntheticDataset(12000);
+        testData = dataset.validationData;
+        testLabels = dataset.validationLabels;
+        std::cout << "Fashion-MNIST not found in " << directory << ", synthetic dataset";
+    }
+    std::cout << ", " << dataset.trainData.getNumRows() << " training samples, target test accuracy "
+              << targetAccuracy << "%" << std::endl;
+
+    AdamOptimizer smallBatchAdam, largeBatchAdam;
+    LambOptimizer lamb1024, lamb4096;
+    std::vector<Approach_t> approaches = {
+            {"adam",                     &smallBatchAdam, 64,   0.1,  0},
+            {"adam, scaled eta",         &largeBatchAdam, 1024, 1.6,  0},
+            {"lamb, warmup",             &lamb1024,       1024, 0.02, 20000},
+            {"lamb, warmup",             &lamb4096,       4096, 0.05, 40000}};
+
+    std::cout << std::left << std::setw(28) << "approach" << std::setw(8) << "batch" << std::setw(10) << "eta"
+              << std::setw(12) << "step [ms]" << std::setw(10) << "epochs" << std::setw(14) << "time [s]"
+              << "best accuracy [%]" << std::endl;
+    for (const auto &approach: approaches) {
+        timeToAccuracy(dataset, testData, testLabels, approach, targetAccuracy, maxEpochs);
+    }
+
+    return 0;
+}
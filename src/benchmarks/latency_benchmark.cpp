@@ -0,0 +1,95 @@
+#include "benchmark_utils.hpp"
+#include "../network/network.hpp"
+#include "../optimizers/sgd.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+/**
+ * Latency of predicting single samples and small batches: Network::predict (blocked GEMM, matrices per layer)
+ * against Network::predictSmallBatch (GEMV kernels, per-thread scratch). Prints the median and the 99th
+ * percentile of the individual calls and the largest difference of the outputs.
+ */
+
+static constexpr size_t NUM_CALLS = 5000;
+static constexpr size_t NUM_WARM_UP_CALLS = 100;
+
+struct Latency_t {
+    double p50Us;
+    double p99Us;
+};
+
+/**
+ * Times the individual calls of fn
+ * @param fn - function called with the index of the call
+ * @return median and 99th percentile of the call durations
+ */
+template<typename F>
+static Latency_t measureCalls(F &&fn) {
+    for (size_t i = 0; i < NUM_WARM_UP_CALLS; ++i) {
+        fn(i);
+    }
+
+    std::vector<double> durations(NUM_CALLS);
+    for (size_t i = 0; i < NUM_CALLS; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn(i);
+        durations[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::sort(durations.begin(), durations.end());
+    return {.p50Us=durations[NUM_CALLS / 2], .p99Us=durations[NUM_CALLS * 99 / 100]};
+}
+
+int main() {
+    auto dataset = BenchmarkUtils::syntheticDataset(2000);
+    const auto &samples = dataset.validationData;
+    size_t numSamples = samples.getNumRows();
+    size_t numInputs = samples.getNumCols();
+
+    Config config;
+    config.addLayer(784)
+            .addLayer(900, ActivationFunction::ReLU)
+            .addLayer(450, ActivationFunction::ReLU)
+            .addLayer(10, ActivationFunction::SoftMax);
+
+    SGDOptimizer sgd;
+    Network network(config, &sgd);
+
+    std::cout << "Gemm kernel: " << Gemm::kernelName(Gemm::getKernel()) << std::endl;
+    std::cout << std::left << std::setw(8) << "rows" << std::setw(14) << "predict p50" << std::setw(14)
+              << "predict p99" << std::setw(12) << "small p50" << std::setw(12) << "small p99" << "max difference"
+              << std::endl;
+
+    for (size_t rows: {1, 2, 4, 8}) {
+        size_t numBatches = numSamples / rows;
+        std::vector<Matrix<float>> batches;
+        for (size_t i = 0; i < numBatches; ++i) {
+            batches.push_back(DataManager::rowRange(samples, i * rows, rows));
+        }
+        std::vector<float> output(rows * 10);
+
+        auto predict = measureCalls([&](size_t i) { network.predict(batches[i % numBatches]); });
+        auto small = measureCalls([&](size_t i) {
+            network.predictSmallBatch(samples.data() + i % numBatches * rows * numInputs, rows, output.data());
+        });
+
+        float maxDifference = 0;
+        for (size_t i = 0; i < numBatches; ++i) {
+            auto expected = network.predict(batches[i]);
+            network.predictSmallBatch(samples.data() + i * rows * numInputs, rows, output.data());
+            for (size_t j = 0; j < rows * 10; ++j) {
+                maxDifference = std::max(maxDifference, std::abs(expected.data()[j] - output[j]));
+            }
+        }
+
+        std::cout << std::left << std::fixed << std::setprecision(1) << std::setw(8) << rows << std::setw(14)
+                  << predict.p50Us << std::setw(14) << predict.p99Us << std::setw(12) << small.p50Us << std::setw(12)
+                  << small.p99Us << std::scientific << std::setprecision(2) << maxDifference << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "../utils/vector_math.hpp"
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+/**
+ * Compares VectorMath::exp/log (scalar and array versions) with libm evaluated in double precision
+ * over the floats of the tested ranges. Exits with a non-zero status if the error exceeds the bound.
+ */
+
+static const double MAX_ULP = 2;
+static const size_t MAX_INPUTS_PER_RANGE = 1 << 25;
+
+/**
+ * Maps floats to integers of the same order, so that neighbouring floats are neighbouring integers.
+ */
+static int64_t toOrdered(float x) {
+    auto bits = std::bit_cast<int32_t>(x);
+    return bits < 0 ? -static_cast<int64_t>(bits & 0x7fffffff) : bits;
+}
+
+static float fromOrdered(int64_t ordered) {
+    return ordered < 0 ? -std::bit_cast<float>(static_cast<int32_t>(-ordered))
+                       : std::bit_cast<float>(static_cast<int32_t>(ordered));
+}
+
+/**
+ * @param value - computed value
+ * @param reference - exact value
+ * @return error of value in units in the last place of the reference rounded to float
+ */
+static double ulpError(float value, double reference) {
+    auto rounded = static_cast<float>(reference);
+    if (value == rounded) {
+        return 0;
+    }
+    // In double precision, flush-to-zero (-Ofast) would zero the ULP of the smallest normal floats
+    double ulp = std::ldexp(1.0, std::max(std::ilogb(rounded), FLT_MIN_EXP - 1) - (FLT_MANT_DIG - 1));
+    return std::fabs(static_cast<double>(value) - reference) / ulp;
+}
+
+struct Range_t {
+    const char *name;
+    float from;
+    float to;
+};
+
+/**
+ * Checks the floats in the range (every float, or evenly spaced ones if there are too many).
+ * The scalar function is checked both as it is and vectorized by the compiler (as in the GEMM epilogue).
+ * @return maximal error in ULP
+ */
+template<typename SCALAR, typename ARRAY, typename REFERENCE>
+static double checkRange(const Range_t &range, SCALAR scalar, ARRAY array, REFERENCE reference) {
+    const size_t chunkSize = 1 << 20;
+    std::vector<float> inputs;
+    std::vector<float> outputs(chunkSize);
+    std::vector<float> simdOutputs(chunkSize);
+    inputs.reserve(chunkSize);
+
+    double maxError = 0;
+    float worstInput = 0;
+    size_t numInputs = 0;
+    int64_t from = toOrdered(range.from);
+    int64_t to = toOrdered(range.to);
+    int64_t stride = std::max<int64_t>(1, (to - from) / static_cast<int64_t>(MAX_INPUTS_PER_RANGE));
+
+    for (int64_t ordered = from; ordered < to;) {
+        inputs.clear();
+        for (; ordered < to && inputs.size() < chunkSize; ordered += stride) {
+            inputs.push_back(fromOrdered(ordered));
+        }
+        array(inputs.data(), outputs.data(), inputs.size());
+#pragma omp simd
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            simdOutputs[i] = scalar(inputs[i]);
+        }
+
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            double exact = reference(static_cast<double>(inputs[i]));
+            double error = std::max({ulpError(scalar(inputs[i]), exact), ulpError(outputs[i], exact),
+                                     ulpError(simdOutputs[i], exact)});
+            if (error > maxError) {
+                maxError = error;
+                worstInput = inputs[i];
+            }
+        }
+        numInputs += inputs.size();
+    }
+
+    std::cout << range.name << ": " << numInputs << " inputs, max error " << maxError << " ULP (at "
+              << worstInput << ")" << std::endl;
+    return maxError;
+}
+
+int main() {
+    double maxError = 0;
+
+    // Results in the normal float range
+    for (const auto &range: {Range_t{"exp [-87.3, -1]", -87.3f, -1.f}, Range_t{"exp [-1, 1]", -1.f, 1.f},
+                             Range_t{"exp [1, 88.7]", 1.f, 88.7f}}) {
+        maxError = std::max(maxError, checkRange(
+                range, [](float x) { return VectorMath::exp(x); },
+                [](const float *x, float *y, size_t n) { VectorMath::exp(x, y, n); },
+                [](double x) { return std::exp(x); }));
+    }
+
+    for (const auto &range: {Range_t{"log [FLT_MIN, 1e-3]", FLT_MIN, 1e-3f}, Range_t{"log [1e-3, 2]", 1e-3f, 2.f},
+                             Range_t{"log [2, 1e6]", 2.f, 1e6f}}) {
+        maxError = std::max(maxError, checkRange(
+                range, [](float x) { return VectorMath::log(x); },
+                [](const float *x, float *y, size_t n) { VectorMath::log(x, y, n); },
+                [](double x) { return std::log(x); }));
+    }
+
+    // Special values (compared bitwise, the library is built with -ffast-math)
+    const uint32_t positiveInfinity = 0x7f800000;
+    const uint32_t negativeInfinity = 0xff800000;
+    bool specialOk = VectorMath::exp(-200.f) == 0 && VectorMath::exp(0.f) == 1 && VectorMath::log(1.f) == 0 &&
+                     std::bit_cast<uint32_t>(VectorMath::exp(100.f)) == positiveInfinity &&
+                     std::bit_cast<uint32_t>(VectorMath::log(0.f)) == negativeInfinity;
+
+    if (maxError > MAX_ULP || !specialOk) {
+        std::cout << "FAILED: error bound " << MAX_ULP << " ULP exceeded or wrong special values" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "OK" << std::endl;
+    return EXIT_SUCCESS;
+}
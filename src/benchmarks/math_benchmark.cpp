@@ -0,0 +1,131 @@
+#include "benchmark_utils.hpp"
+#include "../activation_functions/sigmoid.hpp"
+#include "../activation_functions/softmax.hpp"
+#include "../statistics/crossentropy.hpp"
+#include "../utils/vector_math.hpp"
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Throughput of VectorMath and of the activation and loss functions using it, compared with
+ * the original libm based implementations (kept here as the baseline).
+ */
+
+// Results of the benchmarked functions returning a value, so that the calls are not optimized out
+static volatile float sink;
+
+static void libmSoftMax(Matrix<float> &matrix) {
+    for (size_t i = 0; i < matrix.getNumRows(); ++i) {
+        float rowSum = 0;
+        float rowMax = matrix.getMaxRowElement(i);
+
+        for (size_t j = 0; j < matrix.getNumCols(); ++j) {
+            float item = expf(matrix.getItem(i, j) - rowMax);
+            rowSum += item;
+            matrix.setItem(i, j, item);
+        }
+
+        for (size_t j = 0; j < matrix.getNumCols(); ++j) {
+            matrix.setItem(i, j, matrix.getItem(i, j) / rowSum);
+        }
+    }
+}
+
+static void libmSigmoid(Matrix<float> &matrix) {
+    matrix.applyFunction([](float x) { return 1 / (1 + expf(-x)); });
+}
+
+static float libmCrossentropy(const Matrix<float> &predicted, const std::vector<unsigned int> &expected) {
+    const float zeroCorrection = 1e-7;
+    float crossEntropyRes = 0;
+
+    for (size_t i = 0; i < predicted.getNumRows(); i++) {
+        for (size_t j = 0; j < predicted.getNumCols(); j++) {
+            float expectedValue = expected[i] == j ? 1.f : 0.f;
+            float calculatedValue = predicted.getItem(i, j);
+            crossEntropyRes -= expectedValue * logf(calculatedValue + zeroCorrection) +
+                               (1 - expectedValue) * logf(1 - calculatedValue + zeroCorrection);
+        }
+    }
+    return crossEntropyRes / static_cast<float>(expected.size());
+}
+
+/**
+ * Prints a line of the table, throughput in millions of elements per second.
+ */
+static void printResult(const std::string &name, size_t numElements, double libmTime, double vectorTime) {
+    auto n = static_cast<double>(numElements);
+    std::cout << std::left << std::setw(28) << name << std::fixed << std::setprecision(1)
+              << std::setw(14) << n / libmTime * 1e-6 << std::setw(14) << n / vectorTime * 1e-6
+              << std::setprecision(2) << libmTime / vectorTime << std::endl;
+}
+
+int main() {
+    const size_t arraySize = 4096;
+    auto input = Matrix<float>::generateRandomUniformMatrix(1, arraySize, -20, 20);
+    auto positiveInput = Matrix<float>::generateRandomUniformMatrix(1, arraySize, 1e-6, 1);
+    std::vector<float> output(arraySize);
+
+    std::cout << std::left << std::setw(28) << "function" << std::setw(14) << "libm" << std::setw(14)
+              << "VectorMath" << "speedup" << std::endl;
+
+    double libmTime = BenchmarkUtils::measure([&]() {
+        for (size_t i = 0; i < arraySize; ++i) {
+            output[i] = expf(input.data()[i]);
+        }
+    });
+    double vectorTime = BenchmarkUtils::measure([&]() { VectorMath::exp(input.data(), output.data(), arraySize); });
+    printResult("exp", arraySize, libmTime, vectorTime);
+
+    libmTime = BenchmarkUtils::measure([&]() {
+        for (size_t i = 0; i < arraySize; ++i) {
+            output[i] = logf(positiveInput.data()[i]);
+        }
+    });
+    vectorTime = BenchmarkUtils::measure([&]() { VectorMath::log(positiveInput.data(), output.data(), arraySize); });
+    printResult("log", arraySize, libmTime, vectorTime);
+
+    // Output layer of the network (10 classes) for a sub-batch and for the whole test set
+    for (size_t rows: {13, 10000}) {
+        auto logits = Matrix<float>::generateRandomUniformMatrix(rows, 10, -10, 10);
+        Matrix<float> tmp;
+        libmTime = BenchmarkUtils::measure([&]() {
+            tmp = logits;
+            libmSoftMax(tmp);
+        });
+        vectorTime = BenchmarkUtils::measure([&]() {
+            tmp = logits;
+            SoftMax::normal(tmp);
+        });
+        printResult("SoftMax " + std::to_string(rows) + "x10", rows * 10, libmTime, vectorTime);
+
+        std::vector<unsigned int> labels(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            labels[i] = i % 10;
+        }
+        libmTime = BenchmarkUtils::measure([&]() { sink = libmCrossentropy(tmp, labels); });
+        vectorTime = BenchmarkUtils::measure([&]() { sink = CrossentropyFunction::crossentropy(tmp, labels); });
+        printResult("cross-entropy " + std::to_string(rows) + "x10", rows * 10, libmTime, vectorTime);
+    }
+
+    // Hidden layer of 900 neurons
+    for (size_t rows: {13, 256}) {
+        auto activations = Matrix<float>::generateRandomUniformMatrix(rows, 900, -5, 5);
+        Matrix<float> tmp;
+        libmTime = BenchmarkUtils::measure([&]() {
+            tmp = activations;
+            libmSigmoid(tmp);
+        });
+        vectorTime = BenchmarkUtils::measure([&]() {
+            tmp = activations;
+            Sigmoid::normal(tmp);
+        });
+        printResult("Sigmoid " + std::to_string(rows) + "x900", rows * 900, libmTime, vectorTime);
+    }
+
+    std::cout << "(millions of elements per second)" << std::endl;
+    return 0;
+}
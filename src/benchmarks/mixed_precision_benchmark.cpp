@@ -0,0 +1,85 @@
+#include "benchmark_utils.hpp"
+#include "../network/network.hpp"
+#include "../optimizers/adam.hpp"
+#include "../schedulers/schedules.hpp"
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+
+/**
+ * Compares mixed precision training (bfloat16 weight copies in the GEMMs) with float training:
+ * the time of the layer GEMMs, the time of a training step and the convergence on Fashion-MNIST
+ * (progress line of every epoch, validation accuracy and loss at the end).
+ *
+ * Usage: MixedPrecisionBenchmark [dataDirectory] [numEpochs] (./data and 10 by default). If Fashion-MNIST
+ * is not in the directory, a synthetic dataset of the same shape is used.
+ */
+
+/**
+ * Time of the forward GEMM of a layer (batchRows x inputs times inputs x outputs), float and bfloat16 weights
+ */
+static void benchmarkLayerGemm(size_t batchRows, size_t inputs, size_t outputs) {
+    auto input = Matrix<float>::generateRandomUniformMatrix(batchRows, inputs, -1, 1);
+    auto weights = Matrix<float>::generateRandomUniformMatrix(inputs, outputs, -1, 1);
+    Matrix<BFloat16_t> weightsBf16;
+    weightsBf16.resize(inputs, outputs);
+    BFloat16::fromFloat(std::as_const(weights).data(), weightsBf16.data(), inputs * outputs);
+
+    Matrix<float> output;
+    double floatTime = BenchmarkUtils::measure([&]() { input.matmul(weights, output); });
+    double bf16Time = BenchmarkUtils::measure([&]() { input.matmul(weightsBf16, output); });
+    double backwardFloatTime = BenchmarkUtils::measure([&]() { output.matmulNT(weights, input); });
+    double backwardBf16Time = BenchmarkUtils::measure([&]() { output.matmulNT(weightsBf16, input); });
+
+    std::cout << std::left << std::setw(20)
+              << (std::to_string(batchRows) + "x" + std::to_string(inputs) + "x" + std::to_string(outputs))
+              << std::fixed << std::setprecision(1) << std::setw(14) << floatTime * 1e6 << std::setw(14)
+              << bf16Time * 1e6 << std::setw(18) << backwardFloatTime * 1e6 << backwardBf16Time * 1e6 << std::endl;
+}
+
+static void train(const TrainValSplit_t &dataset, bool mixedPrecision, size_t numEpochs) {
+    Config config;
+    config.addLayer(784)
+            .addLayer(900, ActivationFunction::ReLU)
+            .addLayer(450, ActivationFunction::ReLU)
+            .addLayer(10, ActivationFunction::SoftMax)
+            .setMixedPrecision(mixedPrecision);
+
+    AdamOptimizer adam;
+    Network network(config, &adam);
+    ExponentialScheduler sched(0.001, 0.85, 30000);
+
+    std::cout << (mixedPrecision ? "bfloat16 weights" : "float weights") << std::endl;
+    network.fit(dataset, numEpochs, 64, 0.1, 1e-6, 1, &sched);
+
+    auto predicted = network.predict(dataset.validationData);
+    auto stats = Stats::getStats(predicted, dataset.validationLabels);
+    const auto &timings = network.getTimings();
+    std::cout << "Validation accuracy " << stats.accuracy << "%, loss " << stats.crossEntropy
+              << ", step " << static_cast<double>(timings.stepUs) / static_cast<double>(timings.numSteps) << " us"
+              << std::endl << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::string directory = argc > 1 ? argv[1] : "./data";
+    size_t numEpochs = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10;
+
+    std::cout << "Layer GEMM times [us] (sub-batch of one thread)" << std::endl;
+    std::cout << std::left << std::setw(20) << "shape" << std::setw(14) << "float" << std::setw(14) << "bfloat16"
+              << std::setw(18) << "backward float" << "backward bfloat16" << std::endl;
+    benchmarkLayerGemm(64, 784, 900);
+    benchmarkLayerGemm(64, 900, 450);
+    benchmarkLayerGemm(16, 784, 900);
+    std::cout << std::endl;
+
+    TrainValSplit_t dataset;
+    if (!BenchmarkUtils::fashionMnist(directory, dataset)) {
+        std::cout << "Fashion-MNIST not found in " << directory << ", using a synthetic dataset" << std::endl;
+        dataset = BenchmarkUtils::syntheticDataset(12000);
+    }
+
+    train(dataset, false, numEpochs);
+    train(dataset, true, numEpochs);
+    return 0;
+}
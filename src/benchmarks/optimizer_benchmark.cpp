@@ -0,0 +1,280 @@
+#include "benchmark_utils.hpp"
+#include "../network/network.hpp"
+#include "../optimizers/adam.hpp"
+#include "../optimizers/sgd.hpp"
+#include "../schedulers/schedules.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <omp.h>
+#include <random>
+#include <vector>
+
+/**
+ * Time of an optimizer update of the 784x900x450x10 network parameters: the fused AdamOptimizer over a
+ * ParameterBuffer against the per-layer reference loop it replaced (parallel across the layers only, bias
+ * corrections divided per element), and the Adam and SGD updates with the weight decay as a separate pass
+ * over the weights against the decay fused into the update, and the SGD updates with momentum.
+ * Prints the time per update, the memory traffic and achieved bandwidth of an update and the largest differences
+ * of the updated weights. Then trains the network for an epoch of synthetic data with each optimizer
+ * and prints the training steps per second.
+ * Usage: OptimizerBenchmark [numUpdates] [numSamples]
+ */
+
+static constexpr float BETA1 = 0.9;
+static constexpr float BETA2 = 0.999;
+static constexpr float EPS = 1e-7;
+static constexpr float LAMBDA = 1e-4;
+static constexpr float MOMENTUM = 0.9;
+
+/**
+ * Adam state of the reference implementation
+ */
+struct ReferenceAdam_t {
+    std::vector<Matrix<float>> mw;
+    std::vector<Matrix<float>> vw;
+    std::vector<std::vector<float>> mb;
+    std::vector<std::vector<float>> vb;
+    float beta1Power = BETA1;
+    float beta2Power = BETA2;
+};
+
+/**
+ * The Adam update before it was fused
+ */
+static void referenceUpdate(ReferenceAdam_t &adam, std::vector<Matrix<float>> &weights,
+                            std::vector<std::vector<float>> &biases, const std::vector<Matrix<float>> &weightDeltas,
+                            const std::vector<std::vector<float>> &deltaBiases, size_t batchSize, float eta) {
+    float batchEta = eta / static_cast<float>(batchSize);
+    float beta1PrimePower = 1 - adam.beta1Power;
+    float beta2PrimePower = 1 - adam.beta2Power;
+
+#pragma omp parallel for default(none) shared(adam, weights, biases, weightDeltas, deltaBiases, batchEta, \
+        beta1PrimePower, beta2PrimePower)
+    for (size_t layer = 0; layer < weights.size(); ++layer) {
+        for (size_t i = 0; i < weights[layer].getNumRows(); ++i) {
+            for (size_t j = 0; j < weights[layer].getNumCols(); ++j) {
+                float g = weightDeltas[layer].getItem(i, j);
+                adam.mw[layer].setItem(i, j, BETA1 * adam.mw[layer].getItem(i, j) + (1 - BETA1) * g);
+                adam.vw[layer].setItem(i, j, BETA2 * adam.vw[layer].getItem(i, j) + (1 - BETA2) * powf(g, 2));
+                float mCorr = adam.mw[layer].getItem(i, j) / beta1PrimePower;
+                float vCorr = adam.vw[layer].getItem(i, j) / beta2PrimePower;
+                weights[layer].setItem(i, j, weights[layer].getItem(i, j) - batchEta * (mCorr / (sqrtf(vCorr) + EPS)));
+            }
+        }
+        for (size_t j = 0; j < biases[layer].size(); ++j) {
+            float g = deltaBiases[layer][j];
+            adam.mb[layer][j] = BETA1 * adam.mb[layer][j] + (1 - BETA1) * g;
+            adam.vb[layer][j] = BETA2 * adam.vb[layer][j] + (1 - BETA2) * powf(g, 2);
+            float mCorr = adam.mb[layer][j] / beta1PrimePower;
+            float vCorr = adam.vb[layer][j] / beta2PrimePower;
+            biases[layer][j] -= batchEta * (mCorr / (sqrtf(vCorr) + EPS));
+        }
+    }
+
+    adam.beta1Power *= BETA1;
+    adam.beta2Power *= BETA2;
+}
+
+/**
+ * The weight decay pass before it was fused into the optimizers
+ */
+static void decayPass(ParameterBuffer &parameters, float lambda) {
+    float decayCoeff = 1.f - lambda;
+    float *w = parameters.data();
+    size_t numWeights = parameters.getWeightsSize();
+
+#pragma omp parallel for simd schedule(static) default(none) shared(decayCoeff, w, numWeights)
+    for (size_t i = 0; i < numWeights; ++i) {
+        w[i] *= decayCoeff;
+    }
+}
+
+/**
+ * @return largest difference of the weights of the buffers
+ */
+static float maxWeightDifference(const ParameterBuffer &lhs, const ParameterBuffer &rhs) {
+    float maxDifference = 0;
+    for (size_t i = 0; i < lhs.getWeightsSize(); ++i) {
+        maxDifference = std::max(maxDifference, std::abs(lhs.data()[i] - rhs.data()[i]));
+    }
+    return maxDifference;
+}
+
+/**
+ * Trains the network for an epoch of synthetic data with each optimizer and prints the training steps per second
+ * @param numSamples - number of samples of the dataset
+ */
+static void trainingSteps(size_t numSamples) {
+    auto dataset = BenchmarkUtils::syntheticDataset(numSamples);
+    const size_t batchSize = 64;
+
+    Config config;
+    config.addLayer(784)
+            .addLayer(900, ActivationFunction::ReLU)
+            .addLayer(450, ActivationFunction::ReLU)
+            .addLayer(10, ActivationFunction::SoftMax);
+
+    AdamOptimizer adam;
+    SGDOptimizer sgd, momentumSgd(MOMENTUM), nesterovSgd(MOMENTUM, true);
+    std::vector<std::pair<const char *, Optimizer *>> optimizers = {
+            {"adam",          &adam},
+            {"sgd",           &sgd},
+            {"sgd, momentum", &momentumSgd},
+            {"sgd, nesterov", &nesterovSgd}};
+
+    std::cout << std::endl << "Training epoch of " << dataset.trainData.getNumRows() << " samples, batch size "
+              << batchSize << std::endl;
+    std::cout << std::left << std::setw(20) << "optimizer" << std::setw(16) << "steps/s" << std::setw(16)
+              << "update [%]" << "val. accuracy [%]" << std::endl;
+
+    for (auto [name, optimizer]: optimizers) {
+        Network network(config, optimizer);
+        ExponentialScheduler sched(0.001, 0.85, 30000);
+        network.fit(dataset, 1, batchSize, 0.1, LAMBDA, 0, &sched);
+
+        const auto &timings = network.getTimings();
+        double stepsPerSecond = static_cast<double>(timings.numSteps) / (static_cast<double>(timings.stepUs) / 1e6);
+        double updateShare = 100.0 * static_cast<double>(timings.updateUs) / static_cast<double>(timings.stepUs);
+        auto stats = Stats::getStats(network.predict(dataset.validationData), dataset.validationLabels);
+
+        std::cout << std::setw(20) << name << std::fixed << std::setprecision(1) << std::setw(16) << stepsPerSecond
+                  << std::setw(16) << updateShare << stats.accuracy << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t numUpdates = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    size_t numSamples = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 6000;
+    const std::vector<size_t> layerSizes = {784, 900, 450, 10};
+    const size_t batchSize = 64;
+    const float eta = 0.001;
+
+    std::mt19937 generator(42);
+    std::normal_distribution<float> distribution(0, 1);
+
+    std::vector<Matrix<float>> weights, weightDeltas;
+    std::vector<std::vector<float>> biases, deltaBiases;
+    ReferenceAdam_t reference;
+    ParameterBuffer parameters(layerSizes);
+    ParameterBuffer gradients = parameters.zerosLike();
+    size_t numParameters = 0;
+    size_t numWeights = 0;
+    for (size_t i = 0; i + 1 < layerSizes.size(); ++i) {
+        size_t rows = layerSizes[i];
+        size_t cols = layerSizes[i + 1];
+        weights.push_back(Matrix<float>::generateRandomUniformMatrix(rows, cols, -0.1, 0.1));
+        weightDeltas.emplace_back(rows, cols);
+        for (size_t j = 0; j < rows * cols; ++j) {
+            weightDeltas.back().data()[j] = distribution(generator);
+        }
+        biases.emplace_back(cols, 0);
+        deltaBiases.emplace_back(cols);
+        for (auto &delta: deltaBiases.back()) {
+            delta = distribution(generator);
+        }
+
+        std::copy(weights.back().data(), weights.back().data() + rows * cols, parameters.weights(i));
+        std::copy(weightDeltas.back().data(), weightDeltas.back().data() + rows * cols, gradients.weights(i));
+        std::copy(deltaBiases.back().begin(), deltaBiases.back().end(), gradients.biases(i));
+
+        reference.mw.emplace_back(rows, cols, 0);
+        reference.vw.emplace_back(rows, cols, 0);
+        reference.mb.emplace_back(cols, 0);
+        reference.vb.emplace_back(cols, 0);
+        numParameters += rows * cols + cols;
+        numWeights += rows * cols;
+    }
+
+    // Each variant updates its own copy of the initial parameters
+    ParameterBuffer decayedAdamParameters = parameters;
+    ParameterBuffer fusedAdamParameters = parameters;
+    ParameterBuffer decayedSgdParameters = parameters;
+    ParameterBuffer fusedSgdParameters = parameters;
+    ParameterBuffer momentumParameters = parameters;
+    ParameterBuffer nesterovParameters = parameters;
+
+    AdamOptimizer adam(BETA1, BETA2), decayedAdam(BETA1, BETA2), fusedAdam(BETA1, BETA2);
+    SGDOptimizer decayedSgd, fusedSgd, momentumSgd(MOMENTUM), nesterovSgd(MOMENTUM, true);
+    adam.setParameters(parameters);
+    decayedAdam.setParameters(decayedAdamParameters);
+    fusedAdam.setParameters(fusedAdamParameters);
+    decayedSgd.setParameters(decayedSgdParameters);
+    fusedSgd.setParameters(fusedSgdParameters);
+    momentumSgd.setParameters(momentumParameters);
+    nesterovSgd.setParameters(nesterovParameters);
+    for (Optimizer *optimizer: std::initializer_list<Optimizer *>{&adam, &decayedAdam, &fusedAdam, &decayedSgd,
+                                                                  &fusedSgd, &momentumSgd, &nesterovSgd}) {
+        optimizer->init();
+    }
+
+    auto timeUpdates = [&](auto &&update) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < numUpdates; ++i) {
+            update();
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+               static_cast<double>(numUpdates);
+    };
+
+    double referenceMs = timeUpdates([&]() {
+        referenceUpdate(reference, weights, biases, weightDeltas, deltaBiases, batchSize, eta);
+    });
+    double fusedMs = timeUpdates([&]() { adam.update(gradients, batchSize, eta, 0); });
+    double decayedAdamMs = timeUpdates([&]() {
+        decayPass(decayedAdamParameters, LAMBDA);
+        decayedAdam.update(gradients, batchSize, eta, 0);
+    });
+    double fusedAdamMs = timeUpdates([&]() { fusedAdam.update(gradients, batchSize, eta, LAMBDA); });
+    double decayedSgdMs = timeUpdates([&]() {
+        decayPass(decayedSgdParameters, LAMBDA);
+        decayedSgd.update(gradients, batchSize, eta, 0);
+    });
+    double fusedSgdMs = timeUpdates([&]() { fusedSgd.update(gradients, batchSize, eta, LAMBDA); });
+    double momentumMs = timeUpdates([&]() { momentumSgd.update(gradients, batchSize, eta, LAMBDA); });
+    double nesterovMs = timeUpdates([&]() { nesterovSgd.update(gradients, batchSize, eta, LAMBDA); });
+
+    float maxDifference = 0;
+    for (size_t layer = 0; layer < weights.size(); ++layer) {
+        for (size_t j = 0; j < weights[layer].getNumRows() * weights[layer].getNumCols(); ++j) {
+            maxDifference = std::max(maxDifference, std::abs(weights[layer].data()[j] - parameters.weights(layer)[j]));
+        }
+    }
+
+    // Adam reads the gradients, moments and parameters and writes the moments and parameters, SGD reads the
+    // gradients and parameters and writes the parameters (and reads and writes the velocities with momentum).
+    // A separate decay pass reads and writes the weights once more.
+    double adamBytes = 7.0 * sizeof(float) * static_cast<double>(numParameters);
+    double sgdBytes = 3.0 * sizeof(float) * static_cast<double>(numParameters);
+    double momentumBytes = 5.0 * sizeof(float) * static_cast<double>(numParameters);
+    double decayBytes = 2.0 * sizeof(float) * static_cast<double>(numWeights);
+
+    std::cout << numParameters << " parameters, " << omp_get_max_threads() << " threads, " << numUpdates
+              << " updates, lambda " << LAMBDA << std::endl;
+    std::cout << std::left << std::setw(20) << "optimizer" << std::setw(16) << "update [ms]" << std::setw(16)
+              << "traffic [MB]" << "bandwidth [GB/s]" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    auto printRow = [](const char *name, double ms, double bytes) {
+        std::cout << std::setw(20) << name << std::setw(16) << ms << std::setw(16) << bytes / 1e6
+                  << bytes / ms / 1e6 << std::endl;
+    };
+    printRow("adam reference", referenceMs, adamBytes);
+    printRow("adam", fusedMs, adamBytes);
+    printRow("adam, decay pass", decayedAdamMs, adamBytes + decayBytes);
+    printRow("adam, fused decay", fusedAdamMs, adamBytes);
+    printRow("sgd, decay pass", decayedSgdMs, sgdBytes + decayBytes);
+    printRow("sgd, fused decay", fusedSgdMs, sgdBytes);
+    printRow("sgd, momentum", momentumMs, momentumBytes);
+    printRow("sgd, nesterov", nesterovMs, momentumBytes);
+
+    std::cout << std::scientific << "Max weight difference (reference, fused): " << maxDifference << std::endl;
+    std::cout << "Max weight difference (decay pass, fused decay): adam "
+              << maxWeightDifference(decayedAdamParameters, fusedAdamParameters) << ", sgd "
+              << maxWeightDifference(decayedSgdParameters, fusedSgdParameters) << std::endl;
+
+    trainingSteps(numSamples);
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "benchmark_utils.hpp"
+#include "../network/network.hpp"
+#include "../network/quantized_network.hpp"
+#include "../optimizers/adam.hpp"
+#include "../schedulers/schedules.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+/**
+ * Compares the INT8 post-training quantized network with the float network it was made from:
+ * accuracy and cross entropy on the test set, share of equal predictions, latency of a single sample
+ * and throughput of a large batch.
+ *
+ * Usage: QuantizationBenchmark [dataDirectory] [numEpochs] (./data and 5 by default). If the Fashion-MNIST
+ * test set is not in the directory, the validation part is used; without Fashion-MNIST, a synthetic dataset
+ * of the same shape is used.
+ */
+
+static constexpr size_t NUM_CALIBRATION_ROWS = 1000;
+
+/**
+ * @return share of the rows with the same predicted class [%]
+ */
+static double agreement(const Matrix<float> &a, const Matrix<float> &b) {
+    size_t equal = 0;
+    for (size_t i = 0; i < a.getNumRows(); ++i) {
+        equal += Stats::argmaxRow(a, i) == Stats::argmaxRow(b, i);
+    }
+    return 100.0 * static_cast<double>(equal) / static_cast<double>(a.getNumRows());
+}
+
+template<typename NETWORK>
+static void report(const char *name, NETWORK &network, const Matrix<float> &testData,
+                   const std::vector<unsigned int> &testLabels, const Matrix<float> &predicted) {
+    auto stats = Stats::getStats(predicted, testLabels);
+    Matrix<float> sample = DataManager::rowRange(testData, 0, 1);
+
+    double latency = BenchmarkUtils::measure([&]() { network.predict(sample); });
+    double batchTime = BenchmarkUtils::measure([&]() { network.predict(testData); }, 2);
+
+    std::cout << std::left << std::setw(8) << name << std::fixed << std::setprecision(2) << std::setw(12)
+              << stats.accuracy << std::setprecision(4) << std::setw(12) << stats.crossEntropy
+              << std::setprecision(1) << std::setw(16) << latency * 1e6
+              << std::setprecision(0) << static_cast<double>(testData.getNumRows()) / batchTime << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::string directory = argc > 1 ? argv[1] : "./data";
+    size_t numEpochs = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+
+    TrainValSplit_t dataset;
+    Matrix<float> testData;
+    std::vector<unsigned int> testLabels;
+    if (!BenchmarkUtils::fashionMnist(directory, dataset)) {
+        std::cout << "Fashion-MNIST not found in " << directory << ", using a synthetic dataset" << std::endl;
+        dataset = BenchmarkUtils::syntheticDataset(12000);
+    }
+    if (!BenchmarkUtils::fashionMnistPart(directory, "test", testData, testLabels)) {
+        testData = dataset.validationData;
+        testLabels = dataset.validationLabels;
+    }
+
+    Config config;
+    config.addLayer(784)
+            .addLayer(900, ActivationFunction::ReLU)
+            .addLayer(450, ActivationFunction::ReLU)
+            .addLayer(10, ActivationFunction::SoftMax);
+
+    AdamOptimizer adam;
+    Network network(config, &adam);
+    ExponentialScheduler sched(0.001, 0.85, 30000);
+    network.fit(dataset, numEpochs, 64, 0.1, 1e-6, 1, &sched);
+
+    size_t calibrationRows = std::min(NUM_CALIBRATION_ROWS, dataset.trainData.getNumRows());
+    QuantizedNetwork quantized(network, DataManager::rowRange(dataset.trainData, 0, calibrationRows));
+
+    std::cout << std::endl << "Test set: " << testData.getNumRows() << " samples, int8 kernel: "
+              << (Int8Gemm::usesAvx2() ? "AVX2" : "scalar") << std::endl;
+    std::cout << std::left << std::setw(8) << "model" << std::setw(12) << "accuracy" << std::setw(12) << "loss"
+              << std::setw(16) << "latency [us]" << "throughput [samples/s]" << std::endl;
+
+    auto floatPredicted = network.predict(testData);
+    auto int8Predicted = quantized.predict(testData);
+    report("float", network, testData, testLabels, floatPredicted);
+    report("int8", quantized, testData, testLabels, int8Predicted);
+
+    std::cout << "Equal predictions: " << std::setprecision(2) << agreement(floatPredicted, int8Predicted) << "%"
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "benchmark_utils.hpp"
+#include "../network/network.hpp"
+#include "../optimizers/adam.hpp"
+#include "../schedulers/schedules.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <omp.h>
+
+/**
+ * Reports the time of one training epoch on the 784x900x450x10 topology for 1..N threads.
+ * Usage: ScalingBenchmark [maxThreads] [numSamples]
+ */
+int main(int argc, char **argv) {
+    size_t maxThreads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : omp_get_max_threads();
+    size_t numSamples = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 12000;
+    const size_t batchSize = 64;
+
+    auto dataset = BenchmarkUtils::syntheticDataset(numSamples);
+
+    Config config;
+    config.addLayer(784)
+            .addLayer(900, ActivationFunction::ReLU)
+            .addLayer(450, ActivationFunction::ReLU)
+            .addLayer(10, ActivationFunction::SoftMax);
+
+    std::cout << "Epoch of " << dataset.trainData.getNumRows() << " samples, batch size " << batchSize << std::endl;
+    std::cout << std::left << std::setw(10) << "threads" << std::setw(16) << "epoch [ms]" << std::setw(10) << "speedup"
+              << std::setw(14) << "step [us]" << std::setw(16) << "reduction [%]" << "update [%]" << std::endl;
+
+    double singleThreadMs = 0;
+    for (size_t threads = 1; threads <= maxThreads; ++threads) {
+        AdamOptimizer adam;
+        Network network(config, &adam, threads);
+        ExponentialScheduler sched(0.001, 0.85, 30000);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        network.fit(dataset, 1, batchSize, 0.01, 1e-6, 0, &sched);
+        auto end = std::chrono::high_resolution_clock::now();
+        double epochMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        if (threads == 1) {
+            singleThreadMs = epochMs;
+        }
+
+        const auto &timings = network.getTimings();
+        double stepUs = static_cast<double>(timings.stepUs) / static_cast<double>(timings.numSteps);
+        double reductionShare = 100.0 * static_cast<double>(timings.reductionUs) / static_cast<double>(timings.stepUs);
+        double updateShare = 100.0 * static_cast<double>(timings.updateUs) / static_cast<double>(timings.stepUs);
+
+        std::cout << std::left << std::setw(10) << threads << std::setw(16) << std::fixed << std::setprecision(1)
+                  << epochMs << std::setw(10) << std::setprecision(2) << singleThreadMs / epochMs
+                  << std::setw(14) << std::setprecision(1) << stepUs
+                  << std::setw(16) << reductionShare << updateShare << std::endl;
+    }
+
+    return 0;
+}
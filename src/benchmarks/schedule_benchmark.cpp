@@ -0,0 +1,132 @@
+#include "benchmark_utils.hpp"
+#include "../network/network.hpp"
+#include "../optimizers/adam.hpp"
+#include "../schedulers/schedules.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Sweep of the learning rate schedules: trains the 784x900x450x10 network (Adam, batch size 64) epoch by epoch
+ * with each schedule until the test accuracy reaches the target (or maxEpochs pass). Reports the epochs and
+ * the training time it took and the epochs saved against the exponential decay used by main.
+ * The schedules with a fixed length (linear, cosine, one-cycle) span maxEpochs.
+ *
+ * Usage: ScheduleBenchmark [dataDirectory] [targetAccuracy] [maxEpochs] (./data, 88 and 15 by default).
+ * If Fashion-MNIST is not in the directory, a synthetic dataset of the same shape is used (its validation
+ * part is the test set then).
+ */
+
+static constexpr size_t BATCH_SIZE = 64;
+static constexpr float ETA = 0.1;
+
+/**
+ * Result of training with a schedule
+ */
+struct SweepResult_t {
+    size_t epochsToTarget = 0;  // 0 if the target was not reached
+    double secondsToTarget = 0;
+    float bestAccuracy = 0;
+};
+
+/**
+ * Trains the network with the schedule until the accuracy on the test set reaches the target
+ */
+static SweepResult_t sweep(const TrainValSplit_t &dataset, const Matrix<float> &testData,
+                           const std::vector<unsigned int> &testLabels, LRScheduler &sched, float targetAccuracy,
+                           size_t maxEpochs) {
+    Config config;
+    config.addLayer(784)
+            .addLayer(900, ActivationFunction::ReLU)
+            .addLayer(450, ActivationFunction::ReLU)
+            .addLayer(10, ActivationFunction::SoftMax);
+
+    AdamOptimizer adam;
+    Network network(config, &adam);
+
+    SweepResult_t result;
+    double trainSeconds = 0;
+    for (size_t epoch = 1; epoch <= maxEpochs && result.epochsToTarget == 0; ++epoch) {
+        auto start = std::chrono::high_resolution_clock::now();
+        network.fit(dataset, 1, BATCH_SIZE, ETA, 1e-6, 0, &sched);
+        trainSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        float accuracy = Stats::getStats(network.predict(testData), testLabels).accuracy;
+        result.bestAccuracy = std::max(result.bestAccuracy, accuracy);
+        if (accuracy >= targetAccuracy) {
+            result.epochsToTarget = epoch;
+            result.secondsToTarget = trainSeconds;
+        }
+    }
+    return result;
+}
+
+int main(int argc, char **argv) {
+    std::string directory = argc > 1 ? argv[1] : "./data";
+    float targetAccuracy = argc > 2 ? std::strtof(argv[2], nullptr) : 88;
+    size_t maxEpochs = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 15;
+
+    TrainValSplit_t dataset;
+    Matrix<float> testData;
+    std::vector<unsigned int> testLabels;
+    if (BenchmarkUtils::fashionMnist(directory, dataset) &&
+        BenchmarkUtils::fashionMnistPart(directory, "test", testData, testLabels)) {
+        std::cout << "Fashion-MNIST";
+    } else {
+        dataset = BenchmarkUtils::syntheticDataset(12000);
+        testData = dataset.validationData;
+        testLabels = dataset.validationLabels;
+        std::cout << "Fashion-MNIST not found in " << directory << ", synthetic dataset";
+    }
+    std::cout << ", " << dataset.trainData.getNumRows() << " training samples, target test accuracy "
+              << targetAccuracy << "%" << std::endl;
+
+    size_t epochSamples = dataset.trainData.getNumRows();
+    size_t totalSamples = maxEpochs * epochSamples;
+
+    ExponentialScheduler exponential(0.001, 0.85, 30000);
+    ConstantScheduler constant, plateauBase, sequentialBase;
+    LinearScheduler linear(totalSamples);
+    CosineScheduler cosine(totalSamples), warmupBase(totalSamples), sequentialCosine(totalSamples / 2);
+    WarmupScheduler warmupCosine(warmupBase, epochSamples / 2);
+    OneCycleScheduler oneCycle(totalSamples);
+    PlateauScheduler plateau(plateauBase);
+    SequentialScheduler constantThenCosine({{&sequentialBase, totalSamples / 2}, {&sequentialCosine, totalSamples}});
+
+    std::vector<std::pair<const char *, LRScheduler *>> schedules = {
+            {"exponential",            &exponential},
+            {"constant",               &constant},
+            {"linear",                 &linear},
+            {"cosine",                 &cosine},
+            {"warmup, cosine",         &warmupCosine},
+            {"one-cycle",              &oneCycle},
+            {"plateau",                &plateau},
+            {"constant, then cosine",  &constantThenCosine}};
+
+    std::cout << std::left << std::setw(24) << "schedule" << std::setw(10) << "epochs" << std::setw(12) << "saved"
+              << std::setw(12) << "time [s]" << "best accuracy [%]" << std::endl;
+
+    size_t baselineEpochs = 0;
+    for (auto [name, sched]: schedules) {
+        auto result = sweep(dataset, testData, testLabels, *sched, targetAccuracy, maxEpochs);
+        if (sched == &exponential) {
+            baselineEpochs = result.epochsToTarget != 0 ? result.epochsToTarget : maxEpochs;
+        }
+
+        std::cout << std::left << std::setw(24) << name << std::fixed << std::setprecision(2);
+        if (result.epochsToTarget != 0) {
+            auto saved = static_cast<long>(baselineEpochs) - static_cast<long>(result.epochsToTarget);
+            std::cout << std::setw(10) << result.epochsToTarget << std::setw(12) << saved << std::setw(12)
+                      << result.secondsToTarget;
+        } else {
+            std::cout << std::setw(10) << "-" << std::setw(12) << "-" << std::setw(12) << "-";
+        }
+        std::cout << result.bestAccuracy << std::endl;
+    }
+
+    return 0;
+}
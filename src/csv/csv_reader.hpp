@@ -6,45 +6,78 @@
 #define FEEDFORWARDNEURALNET_CSV_READER_H
 
 #include "../data_structures/matrix.hpp"
+#include "../utils/mapped_file.hpp"
 #include <algorithm>
+#include <charconv>
+#include <cstdint>
 #include <cstring>
-#include <sstream>
+#include <memory>
+#include <omp.h>
+#include <type_traits>
 #include <vector>
-#include <fstream>
 
 class CsvReadError : std::exception {
 };
 
 template<typename ELEMENT_TYPE>
 class CsvReader {
-    std::vector<std::vector<ELEMENT_TYPE>> data;
     Matrix<ELEMENT_TYPE> dataMatrix;
 
+    // Number of chunks per thread the file is split into (the lines are not equally long)
+    static const size_t CHUNKS_PER_THREAD = 4;
+    // Longest integers parsed without from_chars (they fit into uint32_t)
+    static const long MAX_FAST_DIGITS = 9;
+
 public:
     /**
-     * Constructor reads and parses a CSV file using memory mapping.
+     * Constructor reads and parses a CSV file using memory mapping. The file is split into line-aligned
+     * chunks, which are parsed in parallel directly into the data matrix. Empty lines are skipped,
+     * missing values are zero.
      *
      * @param path - string path of the file we want to read
+     * @param numCols - number of values on a line
      */
     explicit CsvReader(const char *path, int numCols) {
-        std::ifstream f(path);
-        std::string line;
-        std::string elem;
-
-        while (f) {
-            while (std::getline(f, line)) {
-                data.emplace_back(numCols, 0);
-                auto &currentRow = data[data.size() - 1];
-                size_t currentIndex = 0;
-
-                std::istringstream ss(line);
-                while (std::getline(ss, elem, ',')) {
-                    currentRow[currentIndex++] = std::stof(elem);
-                }
-            }
+        std::unique_ptr<MappedFile> file;
+        try {
+            file = std::make_unique<MappedFile>(path);
+        } catch (const FileMappingError &) {
+            throw CsvReadError();
+        }
+        const char *begin = static_cast<const char *>(file->data());
+        const char *end = begin + file->getSize();
+
+        size_t numChunks = std::max(1, omp_get_max_threads()) * CHUNKS_PER_THREAD;
+        std::vector<const char *> chunkStarts(numChunks + 1);
+        for (size_t i = 0; i < numChunks; ++i) {
+            chunkStarts[i] = lineStart(begin, end, begin + file->getSize() * i / numChunks);
+        }
+        chunkStarts[numChunks] = end;
+
+        // Rows of the chunks, their prefix sums are the first rows of the chunks
+        std::vector<size_t> chunkRows(numChunks + 1, 0);
+#pragma omp parallel for schedule(dynamic) default(none) shared(chunkStarts, chunkRows, numChunks)
+        for (size_t i = 0; i < numChunks; ++i) {
+            chunkRows[i + 1] = countLines(chunkStarts[i], chunkStarts[i + 1]);
+        }
+        for (size_t i = 0; i < numChunks; ++i) {
+            chunkRows[i + 1] += chunkRows[i];
         }
 
-        dataMatrix = Matrix<ELEMENT_TYPE>(std::move(data));
+        dataMatrix = Matrix<ELEMENT_TYPE>(chunkRows[numChunks], numCols);
+        ELEMENT_TYPE *matrixData = dataMatrix.data();
+        bool parseError = false;
+
+#pragma omp parallel for schedule(dynamic) default(none) shared(chunkStarts, chunkRows, numChunks, numCols, matrixData) \
+        reduction(||:parseError)
+        for (size_t i = 0; i < numChunks; ++i) {
+            parseError = !parseChunk(chunkStarts[i], chunkStarts[i + 1], numCols,
+                                     matrixData + chunkRows[i] * numCols) || parseError;
+        }
+
+        if (parseError) {
+            throw CsvReadError();
+        }
     }
 
     void normalize() {
@@ -67,6 +100,135 @@ public:
     auto &&getDataMatrixRvalRef() {
         return std::move(dataMatrix);
     }
+
+private:
+    /**
+     * @return start of the line containing position (end if position is end)
+     */
+    static const char *lineStart(const char *begin, const char *end, const char *position) {
+        if (position == begin || position == end) {
+            return position;
+        }
+        // The chunk starts after the end of the previous line
+        auto lineEnd = static_cast<const char *>(std::memchr(position - 1, '\n', end - position + 1));
+        return lineEnd == nullptr ? end : lineEnd + 1;
+    }
+
+    /**
+     * @return end of the line starting at position (its newline or end)
+     */
+    static const char *lineEnd(const char *position, const char *end) {
+        auto newline = static_cast<const char *>(std::memchr(position, '\n', end - position));
+        return newline == nullptr ? end : newline;
+    }
+
+    /**
+     * @return true for whitespace within a line
+     */
+    static bool isBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    /**
+     * @return true if the line contains only whitespace
+     */
+    static bool isEmptyLine(const char *line, const char *end) {
+        return std::all_of(line, end, isBlank);
+    }
+
+    /**
+     * @return number of non-empty lines between begin and end
+     */
+    static size_t countLines(const char *begin, const char *end) {
+        size_t numLines = 0;
+        for (const char *line = begin; line < end;) {
+            const char *next = lineEnd(line, end);
+            numLines += !isEmptyLine(line, next);
+            line = next + 1;
+        }
+        return numLines;
+    }
+
+    /**
+     * Parses the value at position, skipping the whitespace around it
+     * @param position - start of the value, moved to the separator after it (or end)
+     * @param end - end of the line
+     * @param value - parsed value
+     * @return true if the whole value was parsed
+     */
+    static bool parseValue(const char *&position, const char *end, ELEMENT_TYPE &value) {
+        while (position < end && (isBlank(*position) || *position == '+')) {
+            ++position;
+        }
+        const char *start = position;
+
+        // Fast path for non-negative integers (e.g. pixel values), from_chars for everything else
+        uint32_t integer = 0;
+        while (position < end && static_cast<unsigned char>(*position - '0') < 10) {
+            integer = integer * 10 + (*position - '0');
+            ++position;
+        }
+
+        bool isInteger = position > start && position - start <= MAX_FAST_DIGITS &&
+                         (position == end || *position == ',' || isBlank(*position));
+        if (isInteger) {
+            value = static_cast<ELEMENT_TYPE>(integer);
+        } else {
+            position = std::find(start, end, ',');
+            const char *valueEnd = position;
+            while (valueEnd > start && isBlank(valueEnd[-1])) {
+                --valueEnd;
+            }
+
+            auto result = std::from_chars(start, valueEnd, value);
+            if constexpr (std::is_integral_v<ELEMENT_TYPE>) {
+                // Integers written as floats (e.g. 3.0)
+                if (result.ec == std::errc() && result.ptr != valueEnd) {
+                    float floatValue;
+                    result = std::from_chars(start, valueEnd, floatValue);
+                    value = static_cast<ELEMENT_TYPE>(floatValue);
+                }
+            }
+            if (result.ec != std::errc() || result.ptr != valueEnd) {
+                return false;
+            }
+        }
+
+        while (position < end && isBlank(*position)) {
+            ++position;
+        }
+        return position == end || *position == ',';
+    }
+
+    /**
+     * Parses the non-empty lines between begin and end into consecutive rows
+     * @param begin - start of the first line
+     * @param end - end of the chunk
+     * @param numCols - number of values on a line
+     * @param rows - the first row of the chunk in the data matrix
+     * @return false if a value could not be parsed or a line has too many values
+     */
+    static bool parseChunk(const char *begin, const char *end, size_t numCols, ELEMENT_TYPE *rows) {
+        for (const char *line = begin; line < end;) {
+            const char *next = lineEnd(line, end);
+            if (!isEmptyLine(line, next)) {
+                const char *position = line;
+                for (size_t col = 0;; ++col) {
+                    if (col >= numCols || !parseValue(position, next, rows[col])) {
+                        return false;
+                    }
+                    if (position == next) {
+                        break;
+                    }
+                    // Skip the separator
+                    ++position;
+                }
+                rows += numCols;
+            }
+            line = next + 1;
+        }
+        return true;
+    }
 };
 
 
@@ -0,0 +1,122 @@
+#include "batch_prefetcher.hpp"
+#include <algorithm>
+#include <chrono>
+
+BatchPrefetcher::BatchPrefetcher(DataSource &source, size_t batchSize, size_t numParts, size_t numEpochs,
+                                 size_t depth)
+        : source(source), numEpochs(numEpochs), ring(std::max<size_t>(depth, 2)) {
+    if (batchSize == 0 || batchSize > source.getNumTrainSamples()) {
+        throw TrainingSetNotLargeEnoughException();
+    }
+    numBatches = source.getNumTrainSamples() / batchSize;
+    size_t partSize = (batchSize + numParts - 1) / numParts;
+
+    const Matrix<float> *trainData = source.getTrainData();
+    for (auto &slot: ring) {
+        slot.labels.resize(batchSize);
+        if (trainData != nullptr) {
+            slot.rows.resize(batchSize);
+        } else {
+            // The sub-batches point to the parts, they must not be reallocated
+            slot.parts.reserve((batchSize + partSize - 1) / partSize);
+        }
+
+        for (size_t first = 0; first < batchSize; first += partSize) {
+            size_t size = std::min(partSize, batchSize - first);
+            const Matrix<float> *data = trainData;
+            std::span<const unsigned int> rows;
+            if (trainData != nullptr) {
+                rows = std::span<const unsigned int>(slot.rows).subspan(first, size);
+            } else {
+                data = &slot.parts.emplace_back(size, source.getNumCols());
+            }
+            slot.subBatches.push_back({
+                    .data=data,
+                    .rows=rows,
+                    .labels=std::span<const unsigned int>(slot.labels).subspan(first, size)
+            });
+        }
+    }
+
+    producer = std::thread(&BatchPrefetcher::produce, this);
+}
+
+BatchPrefetcher::~BatchPrefetcher() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    slotFree.notify_one();
+    producer.join();
+}
+
+const std::vector<BatchView_t> &BatchPrefetcher::acquire() {
+    auto start = std::chrono::high_resolution_clock::now();
+    std::unique_lock lock(mutex);
+    batchReady.wait(lock, [this]() { return numProduced > numConsumed || error; });
+    if (numProduced == numConsumed) {
+        std::rethrow_exception(error);
+    }
+    waitUs += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start).count();
+
+    return ring[numConsumed % ring.size()].subBatches;
+}
+
+void BatchPrefetcher::release() {
+    {
+        std::lock_guard lock(mutex);
+        ++numConsumed;
+    }
+    slotFree.notify_one();
+}
+
+void BatchPrefetcher::produce() {
+    size_t total = numEpochs * numBatches;
+
+    for (size_t i = 0; i < total; ++i) {
+        {
+            std::unique_lock lock(mutex);
+            slotFree.wait(lock, [this]() { return stopping || numProduced - numConsumed < ring.size(); });
+            if (stopping) {
+                return;
+            }
+        }
+
+        // The slot is not accessed by the consumer until numProduced is increased
+        auto start = std::chrono::high_resolution_clock::now();
+        try {
+            if (i % numBatches == 0) {
+                source.startEpoch();
+            }
+            read(ring[i % ring.size()]);
+        } catch (...) {
+            {
+                std::lock_guard lock(mutex);
+                error = std::current_exception();
+            }
+            batchReady.notify_one();
+            return;
+        }
+        prepUs += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - start).count();
+
+        {
+            std::lock_guard lock(mutex);
+            ++numProduced;
+        }
+        batchReady.notify_one();
+    }
+}
+
+void BatchPrefetcher::read(PreparedBatch_t &slot) {
+    if (!slot.rows.empty()) {
+        source.readRows(slot.rows.size(), slot.rows.data(), slot.labels.data());
+        return;
+    }
+
+    unsigned int *labels = slot.labels.data();
+    for (auto &part: slot.parts) {
+        labels += source.read(part.getNumRows(), part.data(), labels);
+    }
+}
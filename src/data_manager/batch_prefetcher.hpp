@@ -0,0 +1,117 @@
+#ifndef FEEDFORWARDNEURALNET_BATCH_PREFETCHER_H
+#define FEEDFORWARDNEURALNET_BATCH_PREFETCHER_H
+
+#include "data_source.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Batch read from a data source, already split into sub-batches
+ */
+struct PreparedBatch_t {
+    std::vector<Matrix<float>> parts;        // Samples of each sub-batch (empty for in-memory sources)
+    std::vector<unsigned int> rows;          // Rows of the in-memory training set in the batch (empty otherwise)
+    std::vector<unsigned int> labels;        // Labels of the whole batch
+    std::vector<BatchView_t> subBatches;     // Views of the parts (as accepted by Network::trainStep)
+};
+
+/**
+ * Prepares the training batches on a background thread while the previous ones are trained on.
+ *
+ * The producer thread starts a new epoch of the data source when the previous one is used up, reads the
+ * samples of the next batch into a free slot of a bounded ring and splits it into sub-batches. If the source
+ * holds the training set in memory, only the row indices are read and the sub-batches are views of the
+ * training set (the rows are gathered by the training step). The consumer
+ * takes the ready slots in order (acquire) and hands them back when done (release). The slots are allocated
+ * once, the pipeline does not allocate afterwards (unless the data source does).
+ */
+class BatchPrefetcher {
+    DataSource &source;
+    size_t numEpochs;
+    size_t numBatches;  // Per epoch
+
+    std::vector<PreparedBatch_t> ring;
+    size_t numProduced = 0;  // Batches read so far
+    size_t numConsumed = 0;  // Batches released so far
+    bool stopping = false;
+    std::exception_ptr error;  // Thrown by the data source on the producer thread
+    std::mutex mutex;
+    std::condition_variable slotFree;
+    std::condition_variable batchReady;
+
+    std::atomic<long> prepUs = 0;
+    std::atomic<long> waitUs = 0;
+
+    std::thread producer;
+
+public:
+    static constexpr size_t DEFAULT_DEPTH = 3;
+
+    /**
+     * Starts preparing the batches. Only full batches are trained on, the remaining samples of an epoch
+     * are skipped.
+     * @param source    Source of the training samples (must outlive the prefetcher)
+     * @param batchSize Number of samples in a batch
+     * @param numParts  Number of sub-batches a batch is split into
+     * @param numEpochs Number of passes through the training set
+     * @param depth     Number of slots of the ring (at least 2, so that preparing overlaps with training)
+     */
+    BatchPrefetcher(DataSource &source, size_t batchSize, size_t numParts, size_t numEpochs,
+                    size_t depth = DEFAULT_DEPTH);
+
+    BatchPrefetcher(const BatchPrefetcher &) = delete;
+
+    BatchPrefetcher &operator=(const BatchPrefetcher &) = delete;
+
+    /**
+     * Stops the producer (the remaining batches are not prepared)
+     */
+    ~BatchPrefetcher();
+
+    /**
+     * @return Number of batches in an epoch
+     */
+    size_t getNumBatches() const {
+        return numBatches;
+    }
+
+    /**
+     * Waits for the next batch. It stays valid until release is called.
+     * Rethrows the exception of the data source if reading the batch failed.
+     * @return Sub-batches of the next batch
+     */
+    const std::vector<BatchView_t> &acquire();
+
+    /**
+     * Returns the slot of the acquired batch to the producer
+     */
+    void release();
+
+    /**
+     * @return Time the producer spent reading the batches (in microseconds)
+     */
+    long getPrepUs() const {
+        return prepUs.load();
+    }
+
+    /**
+     * @return Time acquire spent waiting for the producer (in microseconds)
+     */
+    long getWaitUs() const {
+        return waitUs.load();
+    }
+
+private:
+    void produce();
+
+    /**
+     * Reads the samples (or their row indices) and labels of the next batch into a slot
+     */
+    void read(PreparedBatch_t &slot);
+};
+
+#endif //FEEDFORWARDNEURALNET_BATCH_PREFETCHER_H
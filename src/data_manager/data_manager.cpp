@@ -4,6 +4,7 @@
 
 #include "data_manager.hpp"
 #include <unordered_map>
+#include <utility>
 
 TrainValSplit_t DataManager::trainValidateSplit(Matrix<elem_type> &&data, std::vector<unsigned int> &&labels,
                                                 float trainRatio) {
@@ -11,15 +12,21 @@ TrainValSplit_t DataManager::trainValidateSplit(Matrix<elem_type> &&data, std::v
         throw WrongInputMatricesException();
     }
 
-    auto shuffled = randomShuffle(std::move(data), std::move(labels));
-    auto numCols = shuffled.data.getNumCols();
+    std::vector<size_t> indexes(data.getNumRows());
+    for (size_t i = 0; i < data.getNumRows(); ++i) indexes[i] = i;
+
+    std::random_device randomDevice;
+    std::mt19937 generator(randomDevice());
+    std::shuffle(indexes.begin(), indexes.end(), generator);
+
+    auto numCols = data.getNumCols();
 
     // Create a map that represents a number of samples in each class and draw
     // n percent of samples from each class randomly.
     // By doing so, we retain the class distribution.
     std::unordered_map<unsigned int, std::vector<size_t>> classDistribution;
-    for (size_t i = 0; i < shuffled.vectorLabels.size(); ++i) {
-        classDistribution[shuffled.vectorLabels[i]].push_back(i);
+    for (size_t index: indexes) {
+        classDistribution[labels[index]].push_back(index);
     }
 
     size_t numOfTrainSamples = 0;
@@ -28,7 +35,7 @@ TrainValSplit_t DataManager::trainValidateSplit(Matrix<elem_type> &&data, std::v
     for (auto &dataClass : classDistribution) {
         numOfTrainSamples += dataClass.second.size() * trainRatio;
     }
-    numOfValSamples = shuffled.data.getNumRows() - numOfTrainSamples;
+    numOfValSamples = data.getNumRows() - numOfTrainSamples;
 
     TrainValSplit_t result {
             .trainData=Matrix<float>(numOfTrainSamples, numCols),
@@ -37,6 +44,8 @@ TrainValSplit_t DataManager::trainValidateSplit(Matrix<elem_type> &&data, std::v
             .validationLabels=std::vector<unsigned int>(numOfValSamples)
     };
 
+    // The samples are copied once, straight from the source rows
+    const elem_type *source = std::as_const(data).data();
     size_t trainStartIndex = 0;
     size_t valStartIndex = 0;
     for (auto &dataClass : classDistribution) {
@@ -45,18 +54,15 @@ TrainValSplit_t DataManager::trainValidateSplit(Matrix<elem_type> &&data, std::v
 
         for (size_t i = 0; i < numOfTrainClassSamples; ++i) {
             size_t index = dataClass.second[i];
-            result.trainLabels[trainStartIndex + i] = shuffled.vectorLabels[index];
-            for (size_t j = 0; j < numCols; ++j) {
-                result.trainData.setItem(trainStartIndex + i, j, shuffled.data.getItem(index, j));
-            }
+            result.trainLabels[trainStartIndex + i] = labels[index];
+            std::copy_n(source + index * numCols, numCols, result.trainData.data() + (trainStartIndex + i) * numCols);
         }
 
         for (size_t i = 0; i < numOfValClassSamples; ++i) {
             size_t index = dataClass.second[numOfTrainClassSamples + i];
-            result.validationLabels[valStartIndex + i] = shuffled.vectorLabels[index];
-            for (size_t j = 0; j < numCols; ++j) {
-                result.validationData.setItem(valStartIndex + i, j, shuffled.data.getItem(index, j));
-            }
+            result.validationLabels[valStartIndex + i] = labels[index];
+            std::copy_n(source + index * numCols, numCols,
+                        result.validationData.data() + (valStartIndex + i) * numCols);
         }
 
         trainStartIndex += numOfTrainClassSamples;
@@ -78,21 +84,22 @@ DataLabelsShuffle_t DataManager::randomShuffle(Matrix<elem_type> &&data, std::ve
     std::mt19937 generator(randomDevice());
     std::shuffle(indexes.begin(), indexes.end(), generator);
 
-    std::vector<std::vector<elem_type>> newData(indexes.size(), std::vector<elem_type>(data.getNumCols(), 0));
+    size_t numCols = data.getNumCols();
+    Matrix<elem_type> newData(indexes.size(), numCols);
     std::vector<unsigned int> newLabels(indexes.size());
+    const elem_type *source = std::as_const(data).data();
+    elem_type *destination = newData.data();
 
-#pragma omp parallel for default(none) shared(indexes, newData, newLabels, labels, data)
+#pragma omp parallel for default(none) shared(indexes, newLabels, labels, source, destination, numCols)
     for (size_t i = 0; i < indexes.size(); ++i) {
         size_t index = indexes[i];
-        for (size_t k = 0; k < data.getNumCols(); ++k) {
-            newData[i][k] = data.matrix[index * data.getNumCols() + k];
-        }
+        std::copy_n(source + index * numCols, numCols, destination + i * numCols);
         newLabels[i] = labels[index];
     }
 
     return {
-            .data=Matrix<elem_type>(std::move(newData)),
-            .vectorLabels=newLabels
+            .data=std::move(newData),
+            .vectorLabels=std::move(newLabels)
     };
 }
 
@@ -137,3 +144,12 @@ DataManager::generateVectorBatches(const std::vector<unsigned int> &vec, size_t
 
     return res;
 }
+
+Matrix<DataManager::elem_type>
+DataManager::rowRange(const Matrix<elem_type> &mat, size_t firstRow, size_t numRows) {
+    if (firstRow + numRows > mat.getNumRows()) {
+        throw WrongInputMatricesException();
+    }
+    return Matrix<elem_type>::createView(mat.data() + firstRow * mat.getNumCols(), numRows, mat.getNumCols(),
+                                         mat.viewOwner);
+}
@@ -10,6 +10,7 @@
 #include <cstdlib>
 #include <exception>
 #include <random>
+#include <span>
 #include <vector>
 
 class TrainingSetNotLargeEnoughException : public std::exception {};
@@ -30,6 +31,16 @@ struct TrainValSplit_t {
     std::vector<label_type> validationLabels;
 };
 
+/**
+ * Samples of a batch: rows of the dataset selected by indices and their labels. Nothing is copied here,
+ * each thread of the training step gathers the rows of its sub-batch once (see BatchPrefetcher).
+ */
+struct BatchView_t {
+    const Matrix<float> *data;
+    std::span<const unsigned int> rows;    // Rows of data in the batch, all of them if empty
+    std::span<const unsigned int> labels;  // Label of each sample of the batch
+};
+
 class DataManager {
     using elem_type = float;
 
@@ -65,6 +76,17 @@ public:
     */
     static std::vector<Matrix<elem_type>> generateBatches(const Matrix<elem_type> &mat, size_t batchSize);
 
+    /**
+     * Creates a read-only view of consecutive rows of a matrix, without copying them.
+     * The view must not outlive the matrix (unless the matrix is a view itself).
+     *
+     * @param mat - source matrix
+     * @param firstRow - first row of the view
+     * @param numRows - number of rows of the view
+     * @return view of the rows
+     */
+    static Matrix<elem_type> rowRange(const Matrix<elem_type> &mat, size_t firstRow, size_t numRows);
+
     /**
      * Generates batch-sized vectors from source vector
      *
@@ -0,0 +1,47 @@
+#include "data_source.hpp"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+InMemoryDataSource::InMemoryDataSource(const TrainValSplit_t &split)
+        : split(split), permutation(split.trainData.getNumRows()), generator(std::random_device()()) {
+    if (split.trainData.getNumRows() != split.trainLabels.size()) {
+        throw WrongInputMatricesException();
+    }
+
+    for (size_t i = 0; i < permutation.size(); ++i) {
+        permutation[i] = i;
+    }
+}
+
+void InMemoryDataSource::startEpoch() {
+    std::shuffle(permutation.begin(), permutation.end(), generator);
+    position = 0;
+}
+
+size_t InMemoryDataSource::read(size_t maxSamples, float *data, unsigned int *labels) {
+    size_t numSamples = std::min(maxSamples, permutation.size() - position);
+    size_t numCols = getNumCols();
+    const float *source = std::as_const(split.trainData).data();
+
+    for (size_t i = 0; i < numSamples; ++i) {
+        unsigned int row = permutation[position + i];
+        std::memcpy(data + i * numCols, source + row * numCols, numCols * sizeof(float));
+        labels[i] = split.trainLabels[row];
+    }
+
+    position += numSamples;
+    return numSamples;
+}
+
+size_t InMemoryDataSource::readRows(size_t maxSamples, unsigned int *rows, unsigned int *labels) {
+    size_t numSamples = std::min(maxSamples, permutation.size() - position);
+
+    for (size_t i = 0; i < numSamples; ++i) {
+        rows[i] = permutation[position + i];
+        labels[i] = split.trainLabels[rows[i]];
+    }
+
+    position += numSamples;
+    return numSamples;
+}
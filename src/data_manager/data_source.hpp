@@ -0,0 +1,122 @@
+#ifndef FEEDFORWARDNEURALNET_DATA_SOURCE_H
+#define FEEDFORWARDNEURALNET_DATA_SOURCE_H
+
+#include "data_manager.hpp"
+#include <exception>
+#include <random>
+#include <vector>
+
+/**
+ * Thrown by DataSource::readRows of a source that exposes its training set (getTrainData) without reading
+ * its row indices
+ */
+class RowIndicesNotSupportedException : public std::exception {
+public:
+    const char *what() const noexcept override {
+        return "the data source has a training set in memory but does not override DataSource::readRows";
+    }
+};
+
+/**
+ * Training samples and validation set consumed by Network::fit.
+ *
+ * The training samples are read sequentially, one epoch after another. A source does not have to hold
+ * the training set in memory (see StreamingDataSource), the validation set is always in memory.
+ */
+class DataSource {
+public:
+    virtual ~DataSource() = default;
+
+    /**
+     * @return Number of features of a sample
+     */
+    virtual size_t getNumCols() const = 0;
+
+    /**
+     * @return Number of training samples read in every epoch
+     */
+    virtual size_t getNumTrainSamples() const = 0;
+
+    /**
+     * Starts a new epoch: the training samples are read again (in a new random order)
+     */
+    virtual void startEpoch() = 0;
+
+    /**
+     * Reads the next training samples of the epoch.
+     * @param maxSamples Maximal number of samples to read
+     * @param data       Row-major buffer for maxSamples x getNumCols() features
+     * @param labels     Buffer for maxSamples labels
+     * @return Number of samples read, less than maxSamples only at the end of the epoch
+     */
+    virtual size_t read(size_t maxSamples, float *data, unsigned int *labels) = 0;
+
+    /**
+     * @return Training set if the source holds it in memory, nullptr otherwise. The batches of such a source
+     *         are read as row indices (readRows), the rows are gathered by the training step.
+     */
+    virtual const Matrix<float> *getTrainData() const {
+        return nullptr;
+    }
+
+    /**
+     * Reads the row indices (into getTrainData()) of the next training samples of the epoch.
+     * Must be overridden by the sources that override getTrainData, the others never read rows.
+     * @param maxSamples Maximal number of samples to read
+     * @param rows       Buffer for maxSamples row indices
+     * @param labels     Buffer for maxSamples labels
+     * @return Number of samples read, less than maxSamples only at the end of the epoch
+     */
+    virtual size_t readRows(size_t /*maxSamples*/, unsigned int * /*rows*/, unsigned int * /*labels*/) {
+        throw RowIndicesNotSupportedException();
+    }
+
+    virtual const Matrix<float> &getValidationData() const = 0;
+
+    virtual const std::vector<unsigned int> &getValidationLabels() const = 0;
+};
+
+/**
+ * Data source of a dataset already split in memory. Every epoch reads the training set in a new
+ * random order.
+ */
+class InMemoryDataSource : public DataSource {
+    const TrainValSplit_t &split;
+    std::vector<unsigned int> permutation;  // Order of the training samples in the current epoch
+    size_t position = 0;                    // Next sample of the permutation to read
+    std::mt19937 generator;
+
+public:
+    /**
+     * @param split Training and validation set (must outlive the source)
+     */
+    explicit InMemoryDataSource(const TrainValSplit_t &split);
+
+    size_t getNumCols() const override {
+        return split.trainData.getNumCols();
+    }
+
+    size_t getNumTrainSamples() const override {
+        return permutation.size();
+    }
+
+    void startEpoch() override;
+
+    size_t read(size_t maxSamples, float *data, unsigned int *labels) override;
+
+    const Matrix<float> *getTrainData() const override {
+        return &split.trainData;
+    }
+
+    size_t readRows(size_t maxSamples, unsigned int *rows, unsigned int *labels) override;
+
+    const Matrix<float> &getValidationData() const override {
+        return split.validationData;
+    }
+
+    const std::vector<unsigned int> &getValidationLabels() const override {
+        return split.validationLabels;
+    }
+};
+
+#endif //FEEDFORWARDNEURALNET_DATA_SOURCE_H
@@ -0,0 +1,192 @@
+#include "streaming_data_source.hpp"
+#include "tensor_file.hpp"
+#include "../csv/csv_reader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * Loads a shard file, memory-mapped if it is a tensor file, parsed otherwise
+ */
+template<typename ELEMENT_TYPE>
+static Matrix<ELEMENT_TYPE> loadShardFile(const std::string &path, size_t numCols) {
+    if (path.ends_with(".bin")) {
+        auto matrix = TensorFile::map<ELEMENT_TYPE>(path.c_str());
+        if (matrix.getNumCols() != numCols) {
+            throw DataSourceError();
+        }
+        return matrix;
+    }
+
+    CsvReader<ELEMENT_TYPE> reader(path.c_str(), static_cast<int>(numCols));
+    return reader.getDataMatrixRvalRef();
+}
+
+StreamingDataSource::StreamingDataSource(std::vector<DataShard_t> shards, size_t numCols, size_t memoryBudget,
+                                         float trainRatio, size_t maxValidationSamples, bool normalize)
+        : shards(std::move(shards)), numCols(numCols), normalize(normalize), generator(std::random_device()()) {
+    size_t bufferCapacity = memoryBudget / (numCols * sizeof(float) + sizeof(unsigned int));
+    if (bufferCapacity == 0) {
+        throw DataSourceError();
+    }
+    buffer = Matrix<float>(bufferCapacity, numCols);
+    bufferLabels.resize(bufferCapacity);
+
+    // Class sizes decide how many samples of each class are held out
+    std::unordered_map<unsigned int, size_t> classSizes;
+    size_t numSamples = 0;
+    for (const auto &shard: this->shards) {
+        auto labels = loadShardFile<unsigned int>(shard.labelsPath, 1);
+        const unsigned int *label = std::as_const(labels).data();
+        for (size_t i = 0; i < labels.getNumRows(); ++i) {
+            ++classSizes[label[i]];
+        }
+        numSamples += labels.getNumRows();
+    }
+
+    std::unordered_map<unsigned int, size_t> classHoldouts;
+    size_t numHoldouts = 0;
+    for (const auto &[label, size]: classSizes) {
+        classHoldouts[label] = size - static_cast<size_t>(static_cast<float>(size) * trainRatio);
+        numHoldouts += classHoldouts[label];
+    }
+    if (maxValidationSamples != 0 && numHoldouts > maxValidationSamples) {
+        for (auto &[label, holdouts]: classHoldouts) {
+            holdouts = holdouts * maxValidationSamples / numHoldouts;
+        }
+    }
+
+    // The j-th sample of a class is held out when it crosses a multiple of size / holdouts,
+    // which spreads the holdouts of the class evenly over the shards
+    std::unordered_map<unsigned int, size_t> classSeen;
+    numHoldouts = 0;
+    holdout.resize(this->shards.size());
+    for (size_t s = 0; s < this->shards.size(); ++s) {
+        auto labels = loadShardFile<unsigned int>(this->shards[s].labelsPath, 1);
+        const unsigned int *label = std::as_const(labels).data();
+        holdout[s].resize(labels.getNumRows());
+
+        for (size_t i = 0; i < labels.getNumRows(); ++i) {
+            size_t seen = classSeen[label[i]]++;
+            size_t size = classSizes[label[i]];
+            size_t holdouts = classHoldouts[label[i]];
+            holdout[s][i] = (seen + 1) * holdouts / size > seen * holdouts / size;
+            numHoldouts += holdout[s][i];
+        }
+    }
+    numTrainSamples = numSamples - numHoldouts;
+
+    validationData = Matrix<float>(numHoldouts, numCols);
+    validationLabels.resize(numHoldouts);
+    size_t validationRow = 0;
+    for (size_t s = 0; s < this->shards.size(); ++s) {
+        if (std::find(holdout[s].begin(), holdout[s].end(), true) == holdout[s].end()) {
+            continue;
+        }
+
+        loadShard(s);
+        const float *rows = std::as_const(shardData).data();
+        const unsigned int *labels = std::as_const(shardLabels).data();
+        for (size_t i = 0; i < shardData.getNumRows(); ++i) {
+            if (holdout[s][i]) {
+                copySample(rows + i * numCols, validationData.data() + validationRow * numCols);
+                validationLabels[validationRow++] = labels[i];
+            }
+        }
+    }
+    shardData = Matrix<float>();
+    shardLabels = Matrix<unsigned int>();
+
+    for (size_t s = 0; s < this->shards.size(); ++s) {
+        shardOrder.push_back(s);
+    }
+}
+
+void StreamingDataSource::startEpoch() {
+    std::shuffle(shardOrder.begin(), shardOrder.end(), generator);
+    nextShard = 0;
+    shardRow = 0;
+    shardData = Matrix<float>();
+    shardLabels = Matrix<unsigned int>();
+    bufferSize = 0;
+}
+
+size_t StreamingDataSource::read(size_t maxSamples, float *data, unsigned int *labels) {
+    float *bufferRows = buffer.data();
+    size_t numSamples = 0;
+    const float *row;
+    unsigned int label;
+
+    while (numSamples < maxSamples) {
+        bool haveSample = nextSample(row, label);
+        if (!haveSample && bufferSize == 0) {
+            break;
+        }
+
+        // Fill the buffer before handing out anything
+        if (haveSample && bufferSize < bufferLabels.size()) {
+            copySample(row, bufferRows + bufferSize * numCols);
+            bufferLabels[bufferSize++] = label;
+            continue;
+        }
+
+        size_t chosen = std::uniform_int_distribution<size_t>(0, bufferSize - 1)(generator);
+        std::memcpy(data + numSamples * numCols, bufferRows + chosen * numCols, numCols * sizeof(float));
+        labels[numSamples++] = bufferLabels[chosen];
+
+        if (haveSample) {
+            copySample(row, bufferRows + chosen * numCols);
+            bufferLabels[chosen] = label;
+        } else {
+            // The shards are exhausted, drain the buffer
+            --bufferSize;
+            std::memcpy(bufferRows + chosen * numCols, bufferRows + bufferSize * numCols, numCols * sizeof(float));
+            bufferLabels[chosen] = bufferLabels[bufferSize];
+        }
+    }
+
+    return numSamples;
+}
+
+void StreamingDataSource::loadShard(size_t index) {
+    shardData = loadShardFile<float>(shards[index].vectorsPath, numCols);
+    shardLabels = loadShardFile<unsigned int>(shards[index].labelsPath, 1);
+    if (shardData.getNumRows() != shardLabels.getNumRows() ||
+        shardLabels.getNumRows() != holdout[index].size()) {
+        throw DataSourceError();
+    }
+
+    currentShard = index;
+    shardRow = 0;
+}
+
+bool StreamingDataSource::nextSample(const float *&row, unsigned int &label) {
+    while (true) {
+        while (shardRow < shardData.getNumRows()) {
+            size_t i = shardRow++;
+            if (!holdout[currentShard][i]) {
+                row = std::as_const(shardData).data() + i * numCols;
+                label = std::as_const(shardLabels).data()[i];
+                return true;
+            }
+        }
+
+        if (nextShard == shardOrder.size()) {
+            return false;
+        }
+        loadShard(shardOrder[nextShard++]);
+    }
+}
+
+void StreamingDataSource::copySample(const float *row, float *destination) const {
+    if (!normalize) {
+        std::memcpy(destination, row, numCols * sizeof(float));
+        return;
+    }
+
+    float maxRowVal = *std::max_element(row, row + numCols);
+    for (size_t j = 0; j < numCols; ++j) {
+        destination[j] = row[j] / maxRowVal;
+    }
+}
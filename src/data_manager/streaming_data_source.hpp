@@ -0,0 +1,110 @@
+#ifndef FEEDFORWARDNEURALNET_STREAMING_DATA_SOURCE_H
+#define FEEDFORWARDNEURALNET_STREAMING_DATA_SOURCE_H
+
+#include "data_source.hpp"
+#include <exception>
+#include <random>
+#include <string>
+#include <vector>
+
+class DataSourceError : public std::exception {
+};
+
+/**
+ * Part of a dataset stored on disk: a file of sample vectors and a file of their labels.
+ * Files ending with .bin are tensor files (see TensorFile) and are memory-mapped, other files are
+ * parsed as CSV (the whole shard at once, so a CSV shard has to fit into memory).
+ */
+struct DataShard_t {
+    std::string vectorsPath;
+    std::string labelsPath;
+};
+
+/**
+ * Data source of a dataset larger than memory, streamed from shards on disk.
+ *
+ * An epoch reads the shards one by one, in a random order, and each shard from its first row to its last.
+ * The samples pass through a shuffle buffer of a fixed capacity: once the buffer is full, every sample read
+ * replaces a randomly chosen sample of the buffer, which is handed out. The order is random only
+ * approximately, samples far apart in the shards rarely meet in the buffer.
+ *
+ * The validation set is a stratified holdout selected when the source is created: the labels are read once
+ * to count the samples of each class, then every k-th sample of each class (in the shard order) is held out
+ * and copied into memory. The held-out samples are skipped by the training epochs.
+ */
+class StreamingDataSource : public DataSource {
+    std::vector<DataShard_t> shards;
+    size_t numCols;
+    bool normalize;
+
+    std::vector<std::vector<bool>> holdout;  // holdout[s][i] - row i of shard s is in the validation set
+    size_t numTrainSamples = 0;
+    Matrix<float> validationData;
+    std::vector<unsigned int> validationLabels;
+
+    // Shard being read
+    std::vector<size_t> shardOrder;
+    size_t nextShard = 0;     // Index into shardOrder of the shard to load next
+    size_t currentShard = 0;
+    Matrix<float> shardData;
+    Matrix<unsigned int> shardLabels;
+    size_t shardRow = 0;
+
+    // Shuffle buffer
+    Matrix<float> buffer;
+    std::vector<unsigned int> bufferLabels;
+    size_t bufferSize = 0;
+
+    std::mt19937 generator;
+
+public:
+    /**
+     * Reads the labels of all shards and the features of the held-out samples.
+     * Throws DataSourceError if the shards do not match numCols or their labels.
+     *
+     * @param shards               Shards of the dataset
+     * @param numCols              Number of features of a sample
+     * @param memoryBudget         Memory for the shuffle buffer (in bytes)
+     * @param trainRatio           Ratio of the samples of each class used for training
+     * @param maxValidationSamples Upper bound of the validation set size, 0 for none
+     * @param normalize            Divide every sample by its maximal feature (like CsvReader::normalize)
+     */
+    StreamingDataSource(std::vector<DataShard_t> shards, size_t numCols, size_t memoryBudget,
+                        float trainRatio = 9.f / 10, size_t maxValidationSamples = 0, bool normalize = false);
+
+    size_t getNumCols() const override {
+        return numCols;
+    }
+
+    size_t getNumTrainSamples() const override {
+        return numTrainSamples;
+    }
+
+    void startEpoch() override;
+
+    size_t read(size_t maxSamples, float *data, unsigned int *labels) override;
+
+    const Matrix<float> &getValidationData() const override {
+        return validationData;
+    }
+
+    const std::vector<unsigned int> &getValidationLabels() const override {
+        return validationLabels;
+    }
+
+private:
+    void loadShard(size_t index);
+
+    /**
+     * Reads the next training sample of the epoch (from the shards, not the buffer)
+     * @return false at the end of the epoch
+     */
+    bool nextSample(const float *&row, unsigned int &label);
+
+    /**
+     * Copies a sample (normalized if requested) to a row-major buffer
+     */
+    void copySample(const float *row, float *destination) const;
+};
+
+#endif //FEEDFORWARDNEURALNET_STREAMING_DATA_SOURCE_H
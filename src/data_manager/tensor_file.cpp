@@ -0,0 +1,39 @@
+#include "tensor_file.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+void TensorFile::write(const char *path, TensorType type, const void *elements, size_t rows, size_t cols) {
+    TensorHeader_t header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.type = type;
+    header.numRows = rows;
+    header.numCols = cols;
+    header.dataOffset = (sizeof(TensorHeader_t) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    std::ofstream file(path, std::ios::binary);
+    const char padding[ALIGNMENT] = {};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(padding, static_cast<std::streamsize>(header.dataOffset - sizeof(header)));
+    file.write(static_cast<const char *>(elements), static_cast<std::streamsize>(rows * cols * ELEMENT_SIZE));
+
+    if (!file) {
+        throw TensorFileError();
+    }
+}
+
+const TensorHeader_t &TensorFile::readHeader(const MappedFile &file) {
+    if (file.getSize() < sizeof(TensorHeader_t)) {
+        throw TensorFileError();
+    }
+
+    const auto &header = *static_cast<const TensorHeader_t *>(file.data());
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.dataOffset % ALIGNMENT != 0 || header.dataOffset > file.getSize() ||
+        (file.getSize() - header.dataOffset) / ELEMENT_SIZE / std::max<uint64_t>(header.numCols, 1) <
+        header.numRows) {
+        throw TensorFileError();
+    }
+    return header;
+}
@@ -0,0 +1,103 @@
+#ifndef FEEDFORWARDNEURALNET_TENSOR_FILE_H
+#define FEEDFORWARDNEURALNET_TENSOR_FILE_H
+
+#include "../data_structures/matrix.hpp"
+#include "../utils/mapped_file.hpp"
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <type_traits>
+
+class TensorFileError : public std::exception {
+};
+
+class WrongTensorTypeException : public std::exception {
+};
+
+/**
+ * Element types a tensor file can store
+ */
+enum class TensorType : uint32_t {
+    Float32 = 0,
+    UInt32 = 1,
+};
+
+/**
+ * Header at the beginning of a tensor file. The elements follow at dataOffset (a multiple of
+ * TensorFile::ALIGNMENT), row-major, in the byte order of the machine that wrote them.
+ */
+struct TensorHeader_t {
+    char magic[8];
+    uint32_t version;
+    TensorType type;
+    uint64_t numRows;
+    uint64_t numCols;
+    uint64_t dataOffset;
+};
+
+/**
+ * Binary tensor files: a 2D matrix stored so that it can be memory-mapped and used without parsing
+ * or copying (see CsvToBinary for converting the CSV datasets).
+ */
+class TensorFile {
+public:
+    static constexpr char MAGIC[8] = {'F', 'F', 'N', 'N', 'T', 'E', 'N', 'S'};
+    static constexpr uint32_t VERSION = 1;
+    // Alignment of the elements in the file (and so in memory, mappings are page aligned)
+    static constexpr size_t ALIGNMENT = 64;
+
+    /**
+     * Writes a matrix into a tensor file
+     * @param path - path of the file
+     * @param matrix - matrix to write
+     */
+    template<typename ELEMENT_TYPE>
+    static void write(const char *path, const Matrix<ELEMENT_TYPE> &matrix) {
+        write(path, tensorType<ELEMENT_TYPE>(), matrix.data(), matrix.getNumRows(), matrix.getNumCols());
+    }
+
+    /**
+     * Maps a tensor file into memory and returns a read-only view of it. The file stays mapped
+     * while the view (or a copy of it) exists. Throws FileMappingError if the file cannot be mapped.
+     * @param path - path of the file
+     * @return matrix viewing the mapped elements
+     */
+    template<typename ELEMENT_TYPE>
+    static Matrix<ELEMENT_TYPE> map(const char *path) {
+        auto file = std::make_shared<const MappedFile>(path);
+        const auto &header = readHeader(*file);
+        if (header.type != tensorType<ELEMENT_TYPE>()) {
+            throw WrongTensorTypeException();
+        }
+
+        auto elements = reinterpret_cast<const ELEMENT_TYPE *>(static_cast<const char *>(file->data()) +
+                                                               header.dataOffset);
+        return Matrix<ELEMENT_TYPE>::createView(elements, header.numRows, header.numCols, std::move(file));
+    }
+
+private:
+    // Size of the elements of both supported types
+    static constexpr size_t ELEMENT_SIZE = 4;
+
+    template<typename ELEMENT_TYPE>
+    static constexpr TensorType tensorType() {
+        if constexpr (std::is_same_v<ELEMENT_TYPE, float>) {
+            return TensorType::Float32;
+        } else {
+            static_assert(std::is_same_v<ELEMENT_TYPE, uint32_t>, "Tensor files store float or uint32_t elements");
+            static_assert(sizeof(float) == ELEMENT_SIZE && sizeof(uint32_t) == ELEMENT_SIZE);
+            return TensorType::UInt32;
+        }
+    }
+
+    static void write(const char *path, TensorType type, const void *elements, size_t rows, size_t cols);
+
+    /**
+     * Checks the header of a mapped tensor file
+     * @param file - mapped file
+     * @return header of the file
+     */
+    static const TensorHeader_t &readHeader(const MappedFile &file);
+};
+
+#endif //FEEDFORWARDNEURALNET_TENSOR_FILE_H
@@ -0,0 +1,46 @@
+#ifndef FEEDFORWARDNEURALNET_ALIGNED_ALLOCATOR_H
+#define FEEDFORWARDNEURALNET_ALIGNED_ALLOCATOR_H
+
+#include <cstdlib>
+#include <new>
+
+/**
+ * Allocator returning memory aligned to ALIGNMENT bytes (a cache line by default),
+ * so that SIMD kernels can use aligned loads on the buffers.
+ */
+template<typename T, size_t ALIGNMENT = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, ALIGNMENT>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, ALIGNMENT> &) {}
+
+    T *allocate(size_t n) {
+        // aligned_alloc requires the size to be a multiple of the alignment
+        size_t bytes = (n * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        void *ptr = std::aligned_alloc(ALIGNMENT, bytes);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(ptr);
+    }
+
+    void deallocate(T *ptr, size_t) {
+        std::free(ptr);
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, ALIGNMENT> &) const { return true; }
+
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, ALIGNMENT> &) const { return false; }
+};
+
+#endif //FEEDFORWARDNEURALNET_ALIGNED_ALLOCATOR_H
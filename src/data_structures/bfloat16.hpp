@@ -0,0 +1,87 @@
+#ifndef FEEDFORWARDNEURALNET_BFLOAT16_H
+#define FEEDFORWARDNEURALNET_BFLOAT16_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+/**
+ * bfloat16 number: the upper half of a float (sign, 8 bit exponent, 7 bit mantissa). It has the range
+ * of float, so values converted from float do not overflow, only the precision is lower.
+ */
+struct BFloat16_t {
+    uint16_t bits;
+};
+
+/**
+ * Conversions between float and bfloat16
+ */
+class BFloat16 {
+public:
+    static float toFloat(BFloat16_t value) {
+        return std::bit_cast<float>(static_cast<uint32_t>(value.bits) << 16);
+    }
+
+    /**
+     * Rounds a float to the nearest bfloat16 (ties to even), NaNs stay NaNs.
+     */
+    static BFloat16_t fromFloat(float value) {
+        uint32_t bits = std::bit_cast<uint32_t>(value);
+        if ((bits & 0x7fffffff) > 0x7f800000) {
+            return {static_cast<uint16_t>((bits >> 16) | 0x40)};
+        }
+        bits += 0x7fff + ((bits >> 16) & 1);
+        return {static_cast<uint16_t>(bits >> 16)};
+    }
+
+    /**
+     * Rounds an array of floats to bfloat16 (see fromFloat)
+     * @param src - floats
+     * @param dst - bfloat16 numbers (n of them)
+     * @param n - number of elements
+     */
+    static void fromFloat(const float *src, BFloat16_t *dst, size_t n) {
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i roundingBias = _mm256_set1_epi32(0x7fff);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i quietBit = _mm256_set1_epi32(0x400000);
+
+        for (; i + 16 <= n; i += 16) {
+            __m256i rounded[2];
+            for (size_t h = 0; h < 2; ++h) {
+                __m256 value = _mm256_loadu_ps(src + i + 8 * h);
+                __m256i bits = _mm256_castps_si256(value);
+                __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+                __m256i nearest = _mm256_add_epi32(bits, _mm256_add_epi32(roundingBias, lsb));
+                __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(value, value, _CMP_UNORD_Q));
+                __m256i result = _mm256_blendv_epi8(nearest, _mm256_or_si256(bits, quietBit), nan);
+                rounded[h] = _mm256_srli_epi32(result, 16);
+            }
+            // packus works within 128 bit lanes, the permute puts the halves back in order
+            __m256i packed = _mm256_packus_epi32(rounded[0], rounded[1]);
+            packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] = fromFloat(src[i]);
+        }
+    }
+
+    /**
+     * Widens an array of bfloat16 numbers to floats (exact)
+     * @param src - bfloat16 numbers
+     * @param dst - floats (n of them)
+     * @param n - number of elements
+     */
+    static void toFloat(const BFloat16_t *src, float *dst, size_t n) {
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i) {
+            dst[i] = toFloat(src[i]);
+        }
+    }
+};
+
+#endif //FEEDFORWARDNEURALNET_BFLOAT16_H
@@ -0,0 +1,592 @@
+#include "gemm.hpp"
+#include "aligned_allocator.hpp"
+#include "bfloat16.hpp"
+#include <algorithm>
+#include <immintrin.h>
+#include <omp.h>
+#include <vector>
+
+using PackBuffer_t = std::vector<float, AlignedAllocator<float>>;
+
+namespace {
+    using MicroKernel_t = void (*)(size_t kc, const float *a, const float *b, float *c, size_t ldc, float beta);
+
+    // Below this amount of multiply-adds it is not worth waking up other threads.
+    constexpr size_t PARALLEL_THRESHOLD = 1 << 22;
+
+    // Rows of B read together by sgemv
+    constexpr size_t GEMV_KC = 32;
+
+    // Operands stored as bfloat16 are widened to float while they are packed
+    inline float load(float value) {
+        return value;
+    }
+
+    inline float load(BFloat16_t value) {
+        return BFloat16::toFloat(value);
+    }
+
+    /**
+     * Packs an mc x kc block of A into MR-row panels. Within a panel the elements are stored
+     * column by column, i.e. the micro-kernel reads MR consecutive values for each k.
+     * Element (i, p) of the block is a[i * rs + p * cs]. Rows past mc are zero padded.
+     */
+    template<typename ELEMENT_TYPE>
+    void packA(size_t mc, size_t kc, const ELEMENT_TYPE *a, size_t rs, size_t cs, float *buf) {
+        for (size_t ir = 0; ir < mc; ir += Gemm::MR) {
+            size_t mr = std::min(Gemm::MR, mc - ir);
+            const ELEMENT_TYPE *panel = a + ir * rs;
+
+            if (cs == 1) {
+                // Rows are contiguous, walk along them
+                for (size_t i = 0; i < Gemm::MR; ++i) {
+                    for (size_t p = 0; p < kc; ++p) {
+                        buf[p * Gemm::MR + i] = i < mr ? load(panel[i * rs + p]) : 0;
+                    }
+                }
+            } else {
+                // Transposed A, columns of op(A) are contiguous
+                for (size_t p = 0; p < kc; ++p) {
+                    size_t i = 0;
+                    for (; i < mr; ++i) {
+                        buf[p * Gemm::MR + i] = load(panel[i * rs + p * cs]);
+                    }
+                    for (; i < Gemm::MR; ++i) {
+                        buf[p * Gemm::MR + i] = 0;
+                    }
+                }
+            }
+            buf += Gemm::MR * kc;
+        }
+    }
+
+    /**
+     * packA for an A whose stored rows are selected by indices. Element (i, p) of op(A) is
+     * a[rows[i] * rs + p] (cs == 1), or a[rows[p] * cs + i] if op(A) is the transposition (rs == 1).
+     * The block starts at row i0 and column p0 of op(A).
+     */
+    template<typename ELEMENT_TYPE>
+    void packAGathered(size_t mc, size_t kc, const ELEMENT_TYPE *a, size_t rs, size_t cs, const unsigned int *rows,
+                       size_t i0, size_t p0, float *buf) {
+        for (size_t ir = 0; ir < mc; ir += Gemm::MR) {
+            size_t mr = std::min(Gemm::MR, mc - ir);
+
+            if (cs == 1) {
+                for (size_t i = 0; i < Gemm::MR; ++i) {
+                    if (i < mr) {
+                        const ELEMENT_TYPE *row = a + rows[i0 + ir + i] * rs + p0;
+                        for (size_t p = 0; p < kc; ++p) {
+                            buf[p * Gemm::MR + i] = load(row[p]);
+                        }
+                    } else {
+                        for (size_t p = 0; p < kc; ++p) {
+                            buf[p * Gemm::MR + i] = 0;
+                        }
+                    }
+                }
+            } else {
+                // Transposed A, the gathered rows are the columns of op(A)
+                for (size_t p = 0; p < kc; ++p) {
+                    const ELEMENT_TYPE *row = a + rows[p0 + p] * cs + i0 + ir;
+                    size_t i = 0;
+                    for (; i < mr; ++i) {
+                        buf[p * Gemm::MR + i] = load(row[i]);
+                    }
+                    for (; i < Gemm::MR; ++i) {
+                        buf[p * Gemm::MR + i] = 0;
+                    }
+                }
+            }
+            buf += Gemm::MR * kc;
+        }
+    }
+
+    /**
+     * Packs a kc x nc block of B into NR-column panels stored row by row.
+     * Element (p, j) of the block is b[p * rs + j * cs]. Columns past nc are zero padded.
+     */
+    template<typename ELEMENT_TYPE>
+    void packB(size_t kc, size_t nc, const ELEMENT_TYPE *b, size_t rs, size_t cs, float *buf) {
+        for (size_t jr = 0; jr < nc; jr += Gemm::NR) {
+            size_t nr = std::min(Gemm::NR, nc - jr);
+            const ELEMENT_TYPE *panel = b + jr * cs;
+
+            if (cs == 1) {
+                for (size_t p = 0; p < kc; ++p) {
+                    if (nr == Gemm::NR) {
+#pragma omp simd
+                        for (size_t j = 0; j < Gemm::NR; ++j) {
+                            buf[p * Gemm::NR + j] = load(panel[p * rs + j]);
+                        }
+                    } else {
+                        for (size_t j = 0; j < Gemm::NR; ++j) {
+                            buf[p * Gemm::NR + j] = j < nr ? load(panel[p * rs + j]) : 0;
+                        }
+                    }
+                }
+            } else {
+                // Transposed B, walk along the rows of the stored matrix
+                for (size_t j = 0; j < Gemm::NR; ++j) {
+                    for (size_t p = 0; p < kc; ++p) {
+                        buf[p * Gemm::NR + j] = j < nr ? load(panel[j * cs + p * rs]) : 0;
+                    }
+                }
+            }
+            buf += Gemm::NR * kc;
+        }
+    }
+
+    /**
+     * Portable micro-kernel, C[MR x NR] = A_panel * B_panel + beta * C.
+     */
+    void microKernelScalar(size_t kc, const float *a, const float *b, float *c, size_t ldc, float beta) {
+        float acc[Gemm::MR][Gemm::NR] = {};
+
+        for (size_t p = 0; p < kc; ++p) {
+            for (size_t i = 0; i < Gemm::MR; ++i) {
+                float ai = a[p * Gemm::MR + i];
+#pragma omp simd
+                for (size_t j = 0; j < Gemm::NR; ++j) {
+                    acc[i][j] += ai * b[p * Gemm::NR + j];
+                }
+            }
+        }
+
+        for (size_t i = 0; i < Gemm::MR; ++i) {
+            float *cRow = c + i * ldc;
+            if (beta == 0) {
+#pragma omp simd
+                for (size_t j = 0; j < Gemm::NR; ++j) {
+                    cRow[j] = acc[i][j];
+                }
+            } else {
+#pragma omp simd
+                for (size_t j = 0; j < Gemm::NR; ++j) {
+                    cRow[j] = acc[i][j] + beta * cRow[j];
+                }
+            }
+        }
+    }
+
+    /**
+     * AVX2/FMA micro-kernel, keeps the whole 6x16 tile in 12 ymm registers.
+     */
+    __attribute__((target("avx2,fma")))
+    void microKernelAvx2(size_t kc, const float *a, const float *b, float *c, size_t ldc, float beta) {
+        __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+        __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+        __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+        __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+        __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+        __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+        for (size_t p = 0; p < kc; ++p) {
+            __m256 b0 = _mm256_load_ps(b);
+            __m256 b1 = _mm256_load_ps(b + 8);
+            __m256 ai;
+
+            ai = _mm256_broadcast_ss(a + 0);
+            c00 = _mm256_fmadd_ps(ai, b0, c00);
+            c01 = _mm256_fmadd_ps(ai, b1, c01);
+            ai = _mm256_broadcast_ss(a + 1);
+            c10 = _mm256_fmadd_ps(ai, b0, c10);
+            c11 = _mm256_fmadd_ps(ai, b1, c11);
+            ai = _mm256_broadcast_ss(a + 2);
+            c20 = _mm256_fmadd_ps(ai, b0, c20);
+            c21 = _mm256_fmadd_ps(ai, b1, c21);
+            ai = _mm256_broadcast_ss(a + 3);
+            c30 = _mm256_fmadd_ps(ai, b0, c30);
+            c31 = _mm256_fmadd_ps(ai, b1, c31);
+            ai = _mm256_broadcast_ss(a + 4);
+            c40 = _mm256_fmadd_ps(ai, b0, c40);
+            c41 = _mm256_fmadd_ps(ai, b1, c41);
+            ai = _mm256_broadcast_ss(a + 5);
+            c50 = _mm256_fmadd_ps(ai, b0, c50);
+            c51 = _mm256_fmadd_ps(ai, b1, c51);
+
+            a += Gemm::MR;
+            b += Gemm::NR;
+        }
+
+        __m256 acc[Gemm::MR][2] = {{c00, c01},
+                                   {c10, c11},
+                                   {c20, c21},
+                                   {c30, c31},
+                                   {c40, c41},
+                                   {c50, c51}};
+
+        if (beta == 0) {
+            for (size_t i = 0; i < Gemm::MR; ++i) {
+                _mm256_storeu_ps(c + i * ldc, acc[i][0]);
+                _mm256_storeu_ps(c + i * ldc + 8, acc[i][1]);
+            }
+        } else {
+            __m256 vBeta = _mm256_set1_ps(beta);
+            for (size_t i = 0; i < Gemm::MR; ++i) {
+                float *cRow = c + i * ldc;
+                _mm256_storeu_ps(cRow, _mm256_fmadd_ps(vBeta, _mm256_loadu_ps(cRow), acc[i][0]));
+                _mm256_storeu_ps(cRow + 8, _mm256_fmadd_ps(vBeta, _mm256_loadu_ps(cRow + 8), acc[i][1]));
+            }
+        }
+    }
+
+    /**
+     * Portable GEMV kernel, C[rows x cols] = A[rows x k] * B[k x cols] (+ C if accumulate) with B read in place.
+     */
+    void gemvKernelScalar(size_t rows, size_t k, const float *a, size_t lda, const float *b, size_t ldb,
+                          float *c, size_t ldc, size_t cols, bool accumulate) {
+        for (size_t i = 0; i < rows; ++i) {
+            float acc[Gemm::NR] = {};
+            if (accumulate) {
+                std::copy(c + i * ldc, c + i * ldc + cols, acc);
+            }
+            for (size_t p = 0; p < k; ++p) {
+                float ai = a[i * lda + p];
+                for (size_t j = 0; j < cols; ++j) {
+                    acc[j] += ai * b[p * ldb + j];
+                }
+            }
+            std::copy(acc, acc + cols, c + i * ldc);
+        }
+    }
+
+    /**
+     * AVX2/FMA GEMV kernel, C[ROWS x NR] = A[ROWS x k] * B[k x NR] (+ C if accumulate) with B read in place.
+     * Up to MR rows keep the whole tile in registers, like microKernelAvx2. A partial tile of cols < NR
+     * columns reads and writes only the valid columns.
+     */
+    template<size_t ROWS>
+    __attribute__((target("avx2,fma")))
+    void gemvKernelAvx2(size_t k, const float *a, size_t lda, const float *b, size_t ldb, float *c, size_t ldc,
+                        size_t cols, bool accumulate) {
+        static_assert(ROWS <= Gemm::MR, "The tile must fit into the registers");
+
+        __m256i columns = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i mask0 = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(cols)), columns);
+        __m256i mask1 = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(cols) - 8), columns);
+
+        __m256 acc[ROWS][2];
+        for (size_t i = 0; i < ROWS; ++i) {
+            acc[i][0] = accumulate ? _mm256_maskload_ps(c + i * ldc, mask0) : _mm256_setzero_ps();
+            acc[i][1] = accumulate ? _mm256_maskload_ps(c + i * ldc + 8, mask1) : _mm256_setzero_ps();
+        }
+
+        if (cols == Gemm::NR) {
+            for (size_t p = 0; p < k; ++p) {
+                __m256 b0 = _mm256_loadu_ps(b + p * ldb);
+                __m256 b1 = _mm256_loadu_ps(b + p * ldb + 8);
+                for (size_t i = 0; i < ROWS; ++i) {
+                    __m256 ai = _mm256_broadcast_ss(a + i * lda + p);
+                    acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+                    acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+                }
+            }
+        } else {
+            for (size_t p = 0; p < k; ++p) {
+                __m256 b0 = _mm256_maskload_ps(b + p * ldb, mask0);
+                __m256 b1 = _mm256_maskload_ps(b + p * ldb + 8, mask1);
+                for (size_t i = 0; i < ROWS; ++i) {
+                    __m256 ai = _mm256_broadcast_ss(a + i * lda + p);
+                    acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+                    acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < ROWS; ++i) {
+            _mm256_maskstore_ps(c + i * ldc, mask0, acc[i][0]);
+            _mm256_maskstore_ps(c + i * ldc + 8, mask1, acc[i][1]);
+        }
+    }
+
+    Gemm::Kernel detectKernel() {
+        return Gemm::isSupported(Gemm::Kernel::Avx2) ? Gemm::Kernel::Avx2 : Gemm::Kernel::Scalar;
+    }
+
+    Gemm::Kernel activeKernel = detectKernel();
+
+    /**
+     * Runs the GEMV kernel selected by the active kernel and the number of rows (at most MR)
+     */
+    void gemvKernel(size_t rows, size_t k, const float *a, size_t lda, const float *b, size_t ldb, float *c,
+                    size_t ldc, size_t cols, bool accumulate) {
+        if (activeKernel == Gemm::Kernel::Scalar) {
+            gemvKernelScalar(rows, k, a, lda, b, ldb, c, ldc, cols, accumulate);
+            return;
+        }
+
+        switch (rows) {
+            case 6:
+                gemvKernelAvx2<6>(k, a, lda, b, ldb, c, ldc, cols, accumulate);
+                break;
+            case 5:
+                gemvKernelAvx2<5>(k, a, lda, b, ldb, c, ldc, cols, accumulate);
+                break;
+            case 4:
+                gemvKernelAvx2<4>(k, a, lda, b, ldb, c, ldc, cols, accumulate);
+                break;
+            case 3:
+                gemvKernelAvx2<3>(k, a, lda, b, ldb, c, ldc, cols, accumulate);
+                break;
+            case 2:
+                gemvKernelAvx2<2>(k, a, lda, b, ldb, c, ldc, cols, accumulate);
+                break;
+            default:
+                gemvKernelAvx2<1>(k, a, lda, b, ldb, c, ldc, cols, accumulate);
+                break;
+        }
+    }
+
+    MicroKernel_t getMicroKernel(Gemm::Kernel kernel) {
+        return kernel == Gemm::Kernel::Avx2 ? microKernelAvx2 : microKernelScalar;
+    }
+
+    /**
+     * Per-thread packing buffers. They only grow, so once warmed up sgemm does not allocate.
+     */
+    float *packBufferA(size_t size) {
+        thread_local PackBuffer_t buffer;
+        if (buffer.size() < size) {
+            buffer.resize(size);
+        }
+        return buffer.data();
+    }
+
+    float *packBufferB(size_t size) {
+        thread_local PackBuffer_t buffer;
+        if (buffer.size() < size) {
+            buffer.resize(size);
+        }
+        return buffer.data();
+    }
+
+    /**
+     * Computes C = op(A) * op(B) + beta * C where element (i, p) of op(A) is a[i * rsA + p * csA],
+     * element (p, j) of op(B) is b[p * rsB + j * csB] and element (i, j) of C is c[i * rsC + j * csC].
+     * If an epilogue is given (only allowed for csC == 1), it is applied to every finished tile of C.
+     * If rowsA is given, the stored rows of A are selected by it (see packAGathered).
+     * A and B are stored either as float or as bfloat16, the computation is done in float.
+     * The blocks of A are split across up to numThreads threads (0 for omp_get_max_threads()).
+     */
+    template<typename A_TYPE, typename B_TYPE>
+    void gemmStrided(size_t m, size_t n, size_t k,
+                     const A_TYPE *a, size_t rsA, size_t csA, const unsigned int *rowsA,
+                     const B_TYPE *b, size_t rsB, size_t csB,
+                     float beta, float *c, size_t rsC, size_t csC,
+                     const GemmEpilogue *epilogue, size_t numThreads) {
+        if (m == 0 || n == 0) {
+            return;
+        }
+
+        if (k == 0) {
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    float &dst = c[i * rsC + j * csC];
+                    dst = beta == 0 ? 0 : beta * dst;
+                }
+            }
+            if (epilogue != nullptr) {
+                for (size_t i = 0; i < m; i += Gemm::MR) {
+                    for (size_t j = 0; j < n; j += Gemm::NR) {
+                        epilogue->function(epilogue->context, i, j, std::min(Gemm::MR, m - i),
+                                           std::min(Gemm::NR, n - j), c + i * rsC + j, rsC);
+                    }
+                }
+            }
+            return;
+        }
+
+        // The whole op(B) is packed for only a few rows of A. If op(B) is transposed, its packing
+        // is a strided gather, so compute C^T = op(B)^T * op(A)^T instead, where the large operand
+        // is read row by row and only the small one has to be gathered.
+        if (csB != 1 && m < n && epilogue == nullptr && rowsA == nullptr) {
+            gemmStrided(n, m, k, b, csB, rsB, nullptr, a, csA, rsA, beta, c, csC, rsC, nullptr, numThreads);
+            return;
+        }
+
+        MicroKernel_t kernel = getMicroKernel(activeKernel);
+        // Inside a parallel region the caller already splits the work across its threads. The level
+        // counts inactive regions too, e.g. the training loop of a network with a single thread.
+        if (numThreads == 0) {
+            numThreads = static_cast<size_t>(omp_get_max_threads());
+        }
+        bool useThreads = omp_get_level() == 0 && numThreads > 1 && m > Gemm::MC
+                          && m * n * k >= PARALLEL_THRESHOLD;
+
+        for (size_t jc = 0; jc < n; jc += Gemm::NC) {
+            size_t nc = std::min(Gemm::NC, n - jc);
+            size_t ncPadded = (nc + Gemm::NR - 1) / Gemm::NR * Gemm::NR;
+
+            for (size_t pc = 0; pc < k; pc += Gemm::KC) {
+                size_t kc = std::min(Gemm::KC, k - pc);
+                float blockBeta = pc == 0 ? beta : 1.f;
+                const GemmEpilogue *blockEpilogue = pc + kc == k ? epilogue : nullptr;
+
+                float *bBlock = packBufferB(kc * ncPadded);
+                packB(kc, nc, b + pc * rsB + jc * csB, rsB, csB, bBlock);
+
+#pragma omp parallel for num_threads(numThreads) schedule(static) if(useThreads) default(none) \
+        shared(m, kc, nc, pc, jc, a, rsA, csA, rowsA, c, rsC, csC, blockBeta, blockEpilogue, kernel, bBlock)
+                for (size_t ic = 0; ic < m; ic += Gemm::MC) {
+                    size_t mc = std::min(Gemm::MC, m - ic);
+
+                    float *aBlock = packBufferA(Gemm::MC * Gemm::KC);
+                    if (rowsA == nullptr) {
+                        packA(mc, kc, a + ic * rsA + pc * csA, rsA, csA, aBlock);
+                    } else {
+                        packAGathered(mc, kc, a, rsA, csA, rowsA, ic, pc, aBlock);
+                    }
+
+                    alignas(64) float edge[Gemm::MR * Gemm::NR];
+
+                    for (size_t jr = 0; jr < nc; jr += Gemm::NR) {
+                        size_t nr = std::min(Gemm::NR, nc - jr);
+                        const float *bPanel = bBlock + jr * kc;
+
+                        for (size_t ir = 0; ir < mc; ir += Gemm::MR) {
+                            size_t mr = std::min(Gemm::MR, mc - ir);
+                            const float *aPanel = aBlock + ir * kc;
+                            float *cTile = c + (ic + ir) * rsC + (jc + jr) * csC;
+
+                            if (mr == Gemm::MR && nr == Gemm::NR && csC == 1) {
+                                kernel(kc, aPanel, bPanel, cTile, rsC, blockBeta);
+                            } else {
+                                // Partial or transposed tile, compute into a local buffer and copy only the valid part
+                                kernel(kc, aPanel, bPanel, edge, Gemm::NR, 0);
+                                for (size_t i = 0; i < mr; ++i) {
+                                    for (size_t j = 0; j < nr; ++j) {
+                                        float &dst = cTile[i * rsC + j * csC];
+                                        dst = blockBeta == 0 ? edge[i * Gemm::NR + j]
+                                                             : edge[i * Gemm::NR + j] + blockBeta * dst;
+                                    }
+                                }
+                            }
+
+                            // The tile is final and still in L1, finish it right away
+                            if (blockEpilogue != nullptr) {
+                                blockEpilogue->function(blockEpilogue->context, ic + ir, jc + jr, mr, nr,
+                                                        cTile, rsC);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void Gemm::sgemm(bool transA, bool transB, size_t m, size_t n, size_t k,
+                 const float *a, size_t lda,
+                 const float *b, size_t ldb,
+                 float beta, float *c, size_t ldc, size_t numThreads) {
+    gemmStrided(m, n, k,
+                a, transA ? 1 : lda, transA ? lda : 1, nullptr,
+                b, transB ? 1 : ldb, transB ? ldb : 1,
+                beta, c, ldc, 1, nullptr, numThreads);
+}
+
+void Gemm::sgemm(bool transA, bool transB, size_t m, size_t n, size_t k,
+                 const float *a, size_t lda,
+                 const float *b, size_t ldb,
+                 float beta, float *c, size_t ldc,
+                 const GemmEpilogue &epilogue, size_t numThreads) {
+    gemmStrided(m, n, k,
+                a, transA ? 1 : lda, transA ? lda : 1, nullptr,
+                b, transB ? 1 : ldb, transB ? ldb : 1,
+                beta, c, ldc, 1, epilogue.function != nullptr ? &epilogue : nullptr, numThreads);
+}
+
+void Gemm::sgemm(bool transA, bool transB, size_t m, size_t n, size_t k,
+                 const float *a, size_t lda, const unsigned int *rowsA,
+                 const float *b, size_t ldb,
+                 float beta, float *c, size_t ldc,
+                 const GemmEpilogue &epilogue, size_t numThreads) {
+    gemmStrided(m, n, k,
+                a, transA ? 1 : lda, transA ? lda : 1, rowsA,
+                b, transB ? 1 : ldb, transB ? ldb : 1,
+                beta, c, ldc, 1, epilogue.function != nullptr ? &epilogue : nullptr, numThreads);
+}
+
+void Gemm::sgemm(bool transA, bool transB, size_t m, size_t n, size_t k,
+                 const float *a, size_t lda, const unsigned int *rowsA,
+                 const BFloat16_t *b, size_t ldb,
+                 float beta, float *c, size_t ldc,
+                 const GemmEpilogue &epilogue, size_t numThreads) {
+    gemmStrided(m, n, k,
+                a, transA ? 1 : lda, transA ? lda : 1, rowsA,
+                b, transB ? 1 : ldb, transB ? ldb : 1,
+                beta, c, ldc, 1, epilogue.function != nullptr ? &epilogue : nullptr, numThreads);
+}
+
+void Gemm::sgemv(size_t m, size_t n, size_t k, const float *a, size_t lda, const float *b, size_t ldb,
+                 float *c, size_t ldc, const GemmEpilogue &epilogue) {
+    if (k == 0) {
+        for (size_t i = 0; i < m; ++i) {
+            std::fill(c + i * ldc, c + i * ldc + n, 0.f);
+        }
+    }
+
+    // B is read in blocks of GEMV_KC rows, each walked from left to right: the rows are streamed
+    // sequentially (walking down whole NR-column panels would touch a new page with every row of B)
+    // and the rows of A share every piece of B while it is in L1.
+    for (size_t pc = 0; pc < k; pc += GEMV_KC) {
+        size_t kc = std::min(GEMV_KC, k - pc);
+        bool lastBlock = pc + kc == k;
+
+        for (size_t jr = 0; jr < n; jr += NR) {
+            size_t nr = std::min(NR, n - jr);
+
+            for (size_t ir = 0; ir < m; ir += MR) {
+                size_t mr = std::min(MR, m - ir);
+                float *cTile = c + ir * ldc + jr;
+                gemvKernel(mr, kc, a + ir * lda + pc, lda, b + pc * ldb + jr, ldb, cTile, ldc, nr, pc != 0);
+
+                if (lastBlock && epilogue.function != nullptr) {
+                    epilogue.function(epilogue.context, ir, jr, mr, nr, cTile, ldc);
+                }
+            }
+        }
+    }
+
+    if (k == 0 && epilogue.function != nullptr) {
+        for (size_t ir = 0; ir < m; ir += MR) {
+            for (size_t jr = 0; jr < n; jr += NR) {
+                epilogue.function(epilogue.context, ir, jr, std::min(MR, m - ir), std::min(NR, n - jr),
+                                  c + ir * ldc + jr, ldc);
+            }
+        }
+    }
+}
+
+Gemm::Kernel Gemm::getKernel() {
+    return activeKernel;
+}
+
+void Gemm::setKernel(Kernel kernel) {
+    if (!isSupported(kernel)) {
+        throw UnsupportedGemmKernelException();
+    }
+    activeKernel = kernel;
+}
+
+bool Gemm::isSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar:
+            return true;
+        case Kernel::Avx2:
+            // May run during static initialization, before the CPU model is initialized
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+    return false;
+}
+
+const char *Gemm::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar:
+            return "scalar";
+        case Kernel::Avx2:
+            return "avx2+fma";
+    }
+    return "unknown";
+}
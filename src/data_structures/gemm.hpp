@@ -0,0 +1,164 @@
+#ifndef FEEDFORWARDNEURALNET_GEMM_H
+#define FEEDFORWARDNEURALNET_GEMM_H
+
+#include "bfloat16.hpp"
+#include <cstddef>
+#include <exception>
+
+/**
+ * Function applied to each finished MR x NR tile of the GEMM result while the tile is still in cache.
+ * It gets the position of the tile in C, so it can e.g. add a bias or apply an activation function.
+ */
+struct GemmEpilogue {
+    /**
+     * @param context - GemmEpilogue::context
+     * @param row - first row of the tile in C
+     * @param col - first column of the tile in C (a multiple of Gemm::NR)
+     * @param rows - rows of the tile (at most Gemm::MR)
+     * @param cols - columns of the tile (at most Gemm::NR)
+     * @param c - pointer to the first element of the tile
+     * @param ldc - row stride of C
+     */
+    using Function_t = void (*)(const void *context, size_t row, size_t col, size_t rows, size_t cols,
+                                float *c, size_t ldc);
+
+    Function_t function = nullptr;
+    const void *context = nullptr;
+};
+
+/**
+ * Single precision general matrix multiplication (row-major).
+ *
+ * The implementation follows the usual Goto/BLIS structure: the operands are split into
+ * cache sized blocks (B panel for L3, A block for L2, B micro-panel for L1), the blocks
+ * are packed into contiguous buffers and a register-tiled micro-kernel computes
+ * MR x NR tiles of the result. The micro-kernel is selected at runtime from CPUID
+ * (AVX2 + FMA if available, portable scalar code otherwise).
+ */
+class Gemm {
+public:
+    enum class Kernel {
+        Scalar,
+        Avx2
+    };
+
+    // Register tile of the micro-kernel
+    static constexpr size_t MR = 6;
+    static constexpr size_t NR = 16;
+
+    // Cache blocking (KC x NR B micro-panel in L1, MC x KC A block in L2, KC x NC B panel in L3)
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC = 120;
+    static constexpr size_t NC = 4096;
+
+    // Number of rows up to which sgemv is faster than sgemm
+    static constexpr size_t SMALL_M = 8;
+
+    /**
+     * Computes C = op(A) * op(B) + beta * C, where op(X) is either X or X^T.
+     * Transposed operands are read in place during packing, no transposed copy is made.
+     * If beta is zero, C is not read (it may contain garbage).
+     * @param transA - use A^T instead of A
+     * @param transB - use B^T instead of B
+     * @param m   - rows of op(A) and C
+     * @param n   - columns of op(B) and C
+     * @param k   - columns of op(A), rows of op(B)
+     * @param a   - matrix A (m x k, or k x m if transposed)
+     * @param lda - row stride of A
+     * @param b   - matrix B (k x n, or n x k if transposed)
+     * @param ldb - row stride of B
+     * @param beta - scaling factor of the original C
+     * @param c   - matrix C (m x n)
+     * @param ldc - row stride of C
+     * @param numThreads - maximal number of threads, 0 for omp_get_max_threads(). Called from within
+     *                     a parallel region (even an inactive one), the GEMM runs on the calling thread only.
+     */
+    static void sgemm(bool transA, bool transB, size_t m, size_t n, size_t k,
+                      const float *a, size_t lda,
+                      const float *b, size_t ldb,
+                      float beta, float *c, size_t ldc, size_t numThreads = 0);
+
+    /**
+     * Computes C = op(A) * op(B) + beta * C and applies the epilogue to every tile of the result.
+     * See the overload without the epilogue for the description of the other parameters.
+     * @param epilogue - function applied to the finished tiles of C
+     */
+    static void sgemm(bool transA, bool transB, size_t m, size_t n, size_t k,
+                      const float *a, size_t lda,
+                      const float *b, size_t ldb,
+                      float beta, float *c, size_t ldc,
+                      const GemmEpilogue &epilogue, size_t numThreads = 0);
+
+    /**
+     * Computes C = op(A) * op(B) + beta * C, where the stored rows of A are selected by indices:
+     * row r of the stored A is a + rowsA[r] * lda. The rows are gathered while A is packed, so
+     * a batch of samples does not have to be copied out of the dataset first.
+     * See the overload without the epilogue for the description of the other parameters.
+     * @param rowsA - indices of the rows of the stored A (m of them, k if transA)
+     * @param epilogue - function applied to the finished tiles of C (none if its function is nullptr)
+     */
+    static void sgemm(bool transA, bool transB, size_t m, size_t n, size_t k,
+                      const float *a, size_t lda, const unsigned int *rowsA,
+                      const float *b, size_t ldb,
+                      float beta, float *c, size_t ldc,
+                      const GemmEpilogue &epilogue = {}, size_t numThreads = 0);
+
+    /**
+     * Mixed precision GEMM: computes C = op(A) * op(B) + beta * C, where B is stored as bfloat16. B is widened
+     * to float while it is packed and the products are accumulated in float, so only reading B takes half
+     * of the memory bandwidth. See the overloads above for the description of the parameters.
+     * @param rowsA - indices of the rows of the stored A, nullptr to use all rows in order
+     */
+    static void sgemm(bool transA, bool transB, size_t m, size_t n, size_t k,
+                      const float *a, size_t lda, const unsigned int *rowsA,
+                      const BFloat16_t *b, size_t ldb,
+                      float beta, float *c, size_t ldc,
+                      const GemmEpilogue &epilogue = {}, size_t numThreads = 0);
+
+    /**
+     * Computes C = A * B for a few rows of A (e.g. single samples at inference time). Unlike sgemm it does not
+     * pack the operands, which only pays off once the packed blocks are reused by many rows: the kernel keeps
+     * MR x NR tiles of C in registers and reads B in place, so the cost is a single pass over B. Does not
+     * allocate and does not start threads.
+     * @param m   - rows of A and C (up to about SMALL_M, sgemm is faster for more rows)
+     * @param n   - columns of B and C
+     * @param k   - columns of A, rows of B
+     * @param a   - matrix A (m x k)
+     * @param lda - row stride of A
+     * @param b   - matrix B (k x n)
+     * @param ldb - row stride of B
+     * @param c   - matrix C (m x n), overwritten
+     * @param ldc - row stride of C
+     * @param epilogue - function applied to the finished tiles of C (none if its function is nullptr)
+     */
+    static void sgemv(size_t m, size_t n, size_t k, const float *a, size_t lda, const float *b, size_t ldb,
+                      float *c, size_t ldc, const GemmEpilogue &epilogue = {});
+
+    /**
+     * @return kernel currently used by sgemm
+     */
+    static Kernel getKernel();
+
+    /**
+     * Overrides the kernel picked from CPUID (used for benchmarking the fallback).
+     * @param kernel - kernel to use, must be supported by the CPU
+     */
+    static void setKernel(Kernel kernel);
+
+    /**
+     * @param kernel - kernel to check
+     * @return true if the CPU can run the kernel
+     */
+    static bool isSupported(Kernel kernel);
+
+    /**
+     * @param kernel - kernel
+     * @return human readable kernel name
+     */
+    static const char *kernelName(Kernel kernel);
+};
+
+class UnsupportedGemmKernelException : public std::exception {
+};
+
+#endif //FEEDFORWARDNEURALNET_GEMM_H
@@ -0,0 +1,137 @@
+#include "int8_gemm.hpp"
+#include <algorithm>
+#include <cstring>
+#include <immintrin.h>
+
+namespace {
+    /**
+     * AVX2 micro-kernel, C[ROWS x NR] = A[ROWS x k] * B_block. Each 32 bit lane accumulates the products
+     * of K_GROUP consecutive elements of an A row and of a B column.
+     */
+    template<size_t ROWS>
+    __attribute__((target("avx2")))
+    void microKernelAvx2(size_t kGroups, const uint8_t *a, size_t lda, const int8_t *b, int32_t *c, size_t ldc,
+                         size_t cols) {
+        __m256i acc[ROWS][2];
+        for (size_t r = 0; r < ROWS; ++r) {
+            acc[r][0] = _mm256_setzero_si256();
+            acc[r][1] = _mm256_setzero_si256();
+        }
+        const __m256i ones = _mm256_set1_epi16(1);
+
+        for (size_t g = 0; g < kGroups; ++g) {
+            __m256i b0 = _mm256_load_si256(reinterpret_cast<const __m256i *>(b));
+            __m256i b1 = _mm256_load_si256(reinterpret_cast<const __m256i *>(b + 32));
+            b += Int8Gemm::NR * Int8Gemm::K_GROUP;
+
+            for (size_t r = 0; r < ROWS; ++r) {
+                int32_t group;
+                std::memcpy(&group, a + r * lda + g * Int8Gemm::K_GROUP, sizeof(group));
+                __m256i ar = _mm256_set1_epi32(group);
+                acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_madd_epi16(_mm256_maddubs_epi16(ar, b0), ones));
+                acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_madd_epi16(_mm256_maddubs_epi16(ar, b1), ones));
+            }
+        }
+
+        for (size_t r = 0; r < ROWS; ++r) {
+            if (cols == Int8Gemm::NR) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(c + r * ldc), acc[r][0]);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(c + r * ldc + 8), acc[r][1]);
+            } else {
+                alignas(32) int32_t tile[Int8Gemm::NR];
+                _mm256_store_si256(reinterpret_cast<__m256i *>(tile), acc[r][0]);
+                _mm256_store_si256(reinterpret_cast<__m256i *>(tile + 8), acc[r][1]);
+                std::copy(tile, tile + cols, c + r * ldc);
+            }
+        }
+    }
+
+    /**
+     * Portable micro-kernel with the same packed layout
+     */
+    void microKernelScalar(size_t rows, size_t kGroups, const uint8_t *a, size_t lda, const int8_t *b, int32_t *c,
+                           size_t ldc, size_t cols) {
+        for (size_t r = 0; r < rows; ++r) {
+            int32_t acc[Int8Gemm::NR] = {};
+            const int8_t *block = b;
+
+            for (size_t g = 0; g < kGroups; ++g) {
+                const uint8_t *group = a + r * lda + g * Int8Gemm::K_GROUP;
+                for (size_t j = 0; j < Int8Gemm::NR; ++j) {
+                    for (size_t t = 0; t < Int8Gemm::K_GROUP; ++t) {
+                        acc[j] += static_cast<int32_t>(group[t]) * block[j * Int8Gemm::K_GROUP + t];
+                    }
+                }
+                block += Int8Gemm::NR * Int8Gemm::K_GROUP;
+            }
+
+            std::copy(acc, acc + cols, c + r * ldc);
+        }
+    }
+
+    bool detectAvx2() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }
+
+    const bool useAvx2 = detectAvx2();
+}
+
+void Int8Gemm::packB(const int8_t *b, size_t k, size_t n, Int8Buffer_t &packed) {
+    size_t kGroups = paddedK(k) / K_GROUP;
+    size_t numBlocks = (n + NR - 1) / NR;
+    packed.assign(numBlocks * kGroups * NR * K_GROUP, 0);
+
+    int8_t *dst = packed.data();
+    for (size_t block = 0; block < numBlocks; ++block) {
+        for (size_t g = 0; g < kGroups; ++g) {
+            for (size_t j = 0; j < NR; ++j) {
+                for (size_t t = 0; t < K_GROUP; ++t) {
+                    size_t row = g * K_GROUP + t;
+                    size_t col = block * NR + j;
+                    *dst++ = row < k && col < n ? b[row * n + col] : 0;
+                }
+            }
+        }
+    }
+}
+
+void Int8Gemm::gemm(size_t m, size_t n, size_t k, const uint8_t *a, const int8_t *packedB, int32_t *c, size_t ldc) {
+    size_t lda = paddedK(k);
+    size_t kGroups = lda / K_GROUP;
+
+    for (size_t jb = 0; jb < n; jb += NR) {
+        size_t cols = std::min(NR, n - jb);
+        const int8_t *block = packedB + jb / NR * kGroups * NR * K_GROUP;
+
+        for (size_t i = 0; i < m; i += MR) {
+            size_t rows = std::min(MR, m - i);
+            const uint8_t *aRows = a + i * lda;
+            int32_t *cTile = c + i * ldc + jb;
+
+            if (!useAvx2) {
+                microKernelScalar(rows, kGroups, aRows, lda, block, cTile, ldc, cols);
+                continue;
+            }
+
+            switch (rows) {
+                case 4:
+                    microKernelAvx2<4>(kGroups, aRows, lda, block, cTile, ldc, cols);
+                    break;
+                case 3:
+                    microKernelAvx2<3>(kGroups, aRows, lda, block, cTile, ldc, cols);
+                    break;
+                case 2:
+                    microKernelAvx2<2>(kGroups, aRows, lda, block, cTile, ldc, cols);
+                    break;
+                default:
+                    microKernelAvx2<1>(kGroups, aRows, lda, block, cTile, ldc, cols);
+                    break;
+            }
+        }
+    }
+}
+
+bool Int8Gemm::usesAvx2() {
+    return useAvx2;
+}
@@ -0,0 +1,61 @@
+#ifndef FEEDFORWARDNEURALNET_INT8_GEMM_H
+#define FEEDFORWARDNEURALNET_INT8_GEMM_H
+
+#include "aligned_allocator.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using Int8Buffer_t = std::vector<int8_t, AlignedAllocator<int8_t>>;
+
+/**
+ * Quantized matrix multiplication C = A * B with unsigned 8 bit A, signed 8 bit B and 32 bit C.
+ *
+ * The AVX2 kernel multiplies 4 consecutive bytes of an A row with 4 bytes of a B column per 32 bit lane
+ * (vpmaddubsw + vpmaddwd), so B is packed into blocks of NR columns, each holding K_GROUP consecutive rows
+ * of every column next to each other. vpmaddubsw saturates pairs of products at 16 bits, so A must stay
+ * in [0, A_MAX] (and B in [-127, 127]), which keeps every pair below 2^15.
+ */
+class Int8Gemm {
+public:
+    static constexpr size_t MR = 4;
+    static constexpr size_t NR = 16;
+    static constexpr size_t K_GROUP = 4;
+    static constexpr int A_MAX = 127;
+
+    /**
+     * @param k - rows of B
+     * @return row stride of A (k rounded up to K_GROUP, the padding of A must be zero or any valid value)
+     */
+    static size_t paddedK(size_t k) {
+        return (k + K_GROUP - 1) / K_GROUP * K_GROUP;
+    }
+
+    /**
+     * Packs a row-major k x n matrix B for gemm (zero padded to whole blocks)
+     * @param b - matrix B
+     * @param k - rows of B
+     * @param n - columns of B
+     * @param packed - packed B (resized)
+     */
+    static void packB(const int8_t *b, size_t k, size_t n, Int8Buffer_t &packed);
+
+    /**
+     * Computes C = A * B
+     * @param m - rows of A and C
+     * @param n - columns of B and C
+     * @param k - columns of A, rows of B
+     * @param a - matrix A, row stride paddedK(k), elements in [0, A_MAX]
+     * @param packedB - B packed by packB
+     * @param c - matrix C (m x n)
+     * @param ldc - row stride of C
+     */
+    static void gemm(size_t m, size_t n, size_t k, const uint8_t *a, const int8_t *packedB, int32_t *c, size_t ldc);
+
+    /**
+     * @return true if the AVX2 kernel is used (scalar code otherwise)
+     */
+    static bool usesAvx2();
+};
+
+#endif //FEEDFORWARDNEURALNET_INT8_GEMM_H
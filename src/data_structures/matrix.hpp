@@ -8,11 +8,15 @@
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <span>
 #include <vector>
 #include <omp.h>
 #include <cstring>
 #include <algorithm>
+#include <type_traits>
+#include "gemm.hpp"
 
 class MatrixSizeException : std::exception {};
 
@@ -25,11 +29,57 @@ class Matrix {
     size_t numCols;
     std::vector<ELEMENT_TYPE> matrix;
 
+    // Elements of a view (e.g. of a memory-mapped file), nullptr if the matrix owns its elements
+    const ELEMENT_TYPE *view = nullptr;
+    // Same as view if the view is writable (e.g. a layer of a ParameterBuffer), nullptr otherwise
+    ELEMENT_TYPE *writableView = nullptr;
+    // Keeps the viewed memory alive (shared by the copies of the view)
+    std::shared_ptr<const void> viewOwner;
+
     static const int DECIMAL_PLACES_IN_PRINT = 4;
 
 public:
     Matrix() : numRows(0), numCols(0) {}
 
+    /**
+     * Copies a matrix. The copy of a writable view owns a copy of the elements (it does not write through
+     * to the viewed memory), the copy of a read-only view views the same elements.
+     * @param other - matrix to copy
+     */
+    Matrix(const Matrix &other)
+            : numRows(other.numRows), numCols(other.numCols), matrix(other.matrix), view(other.view),
+              viewOwner(other.viewOwner) {
+        if (other.writableView != nullptr) {
+            matrix.assign(other.view, other.view + numRows * numCols);
+            view = nullptr;
+        }
+    }
+
+    Matrix(Matrix &&other) noexcept = default;
+
+    Matrix &operator=(const Matrix &other) {
+        if (this == &other) {
+            return *this;
+        }
+
+        // Assigned element-wise, so that the storage of this matrix is reused
+        numRows = other.numRows;
+        numCols = other.numCols;
+        writableView = nullptr;
+        if (other.writableView != nullptr) {
+            matrix.assign(other.view, other.view + numRows * numCols);
+            view = nullptr;
+            viewOwner.reset();
+        } else {
+            matrix = other.matrix;
+            view = other.view;
+            viewOwner = other.viewOwner;
+        }
+        return *this;
+    }
+
+    Matrix &operator=(Matrix &&other) noexcept = default;
+
     /**
      * Matrix class constructor, initiates the matrix with zeros
      * @param rows - amount of rows in the matrix
@@ -74,6 +124,50 @@ public:
         }
     }
 
+    /**
+     * Creates a read-only matrix over existing row-major elements, without copying them.
+     * A view is copied into its own storage before it is modified (by the operators, data(), reset, ...).
+     * setItem must not be called on a view.
+     * @param elements - row-major elements
+     * @param rows - amount of rows
+     * @param cols - amount of columns
+     * @param owner - keeps the elements alive for as long as the view (or a copy of it) exists
+     * @return matrix viewing the elements
+     */
+    static Matrix<ELEMENT_TYPE>
+    createView(const ELEMENT_TYPE *elements, size_t rows, size_t cols, std::shared_ptr<const void> owner) {
+        Matrix res;
+        res.numRows = rows;
+        res.numCols = cols;
+        res.view = elements;
+        res.viewOwner = std::move(owner);
+        return res;
+    }
+
+    /**
+     * Creates a matrix over existing row-major elements that writes to them (e.g. a layer of a ParameterBuffer).
+     * Unlike read-only views it is modified in place; its shape cannot change.
+     * @param elements - row-major elements, must outlive the view
+     * @param rows - amount of rows
+     * @param cols - amount of columns
+     * @return matrix viewing the elements
+     */
+    static Matrix<ELEMENT_TYPE> createView(ELEMENT_TYPE *elements, size_t rows, size_t cols) {
+        Matrix res;
+        res.numRows = rows;
+        res.numCols = cols;
+        res.view = elements;
+        res.writableView = elements;
+        return res;
+    }
+
+    /**
+     * @return true if the matrix is a view of elements it does not own (read-only or writable)
+     */
+    bool isView() const {
+        return view != nullptr;
+    }
+
     /**
      * Generates matrix with random values from uniform distribution
      * @param rows - amount of rows
@@ -134,7 +228,7 @@ public:
      * @return item
      */
     auto getItem(size_t row, size_t col) const {
-        return matrix[numCols * row + col];
+        return elements()[numCols * row + col];
     }
 
     /**
@@ -144,15 +238,54 @@ public:
      * @param val - value to set
      */
     void setItem(size_t row, size_t col, ELEMENT_TYPE val) {
-        matrix[numCols * row + col] = val;
+        storage()[numCols * row + col] = val;
     }
 
-    auto getMaxRowElement(size_t row) {
-        auto startIt = matrix.begin() + row * numCols;
+    /**
+     * @return pointer to the row-major element storage
+     */
+    ELEMENT_TYPE *data() {
+        makeWritable();
+        return storage();
+    }
+
+    /**
+     * @return pointer to the row-major element storage
+     */
+    const ELEMENT_TYPE *data() const {
+        return elements();
+    }
+
+    auto getMaxRowElement(size_t row) const {
+        auto startIt = elements() + row * numCols;
         auto endIt = startIt + numCols;
         return *(std::max_element(startIt, endIt));
     }
 
+    /**
+     * Changes the shape of the matrix. The storage is reused, so shrinking a matrix and growing it
+     * back up to its original size does not allocate. The content is not preserved.
+     * A writable view can only be reshaped to the same number of elements (throws MatrixSizeException).
+     * @param rows - new amount of rows
+     * @param cols - new amount of columns
+     */
+    void resize(size_t rows, size_t cols) {
+        if (writableView != nullptr) {
+            if (rows * cols != numRows * numCols) {
+                throw MatrixSizeException();
+            }
+            numRows = rows;
+            numCols = cols;
+            return;
+        }
+
+        view = nullptr;
+        viewOwner.reset();
+        numRows = rows;
+        numCols = cols;
+        matrix.resize(rows * cols);
+    }
+
     /**
      * Gets amount of rows in matrix.
      * @return amount of rows
@@ -177,24 +310,170 @@ public:
      * @return multiplied matrices
      */
     Matrix matmul(const Matrix &rhs, int numRowsToMultiply = -1) const {
+        size_t rowsToMultiply = numRowsToMultiply == -1 ? getNumRows() : numRowsToMultiply;
+        return multiply<false, false>(rhs, rowsToMultiply);
+    }
+
+    /**
+     * Multiplication this^T * rhs, without transposing this
+     * @param rhs - Matrix we are multiplying this^T with
+     * @return multiplied matrices
+     */
+    Matrix matmulTN(const Matrix &rhs) const {
+        return multiply<true, false>(rhs, numCols);
+    }
+
+    /**
+     * Multiplication this * rhs^T, without transposing rhs
+     * @param rhs - Matrix whose transposition we are multiplying this with
+     * @return multiplied matrices
+     */
+    Matrix matmulNT(const Matrix &rhs) const {
+        return multiply<false, true>(rhs, numRows);
+    }
+
+    /**
+     * Multiplication this^T * rhs^T, without transposing any of the matrices
+     * @param rhs - Matrix whose transposition we are multiplying this^T with
+     * @return multiplied matrices
+     */
+    Matrix matmulTT(const Matrix &rhs) const {
+        return multiply<true, true>(rhs, numCols);
+    }
+
+    /**
+     * Matrix multiplication into an existing matrix (its storage is reused, see resize)
+     * @param rhs - Matrix we are multiplying *this with
+     * @param result - Matrix the product is stored to
+     */
+    void matmul(const Matrix &rhs, Matrix &result) const {
+        multiply<false, false>(rhs, numRows, result);
+    }
+
+    /**
+     * Matrix multiplication into an existing matrix, the epilogue is applied to every finished tile
+     * of the result (e.g. bias and activation function of a layer).
+     * @param rhs - Matrix we are multiplying *this with
+     * @param result - Matrix the product is stored to
+     * @param epilogue - Function applied to the tiles of the result
+     * @param numThreads - Maximal number of threads of the GEMM, 0 for omp_get_max_threads() (see Gemm::sgemm)
+     */
+    void matmul(const Matrix &rhs, Matrix &result, const GemmEpilogue &epilogue, size_t numThreads = 0) const {
+        static_assert(std::is_same_v<ELEMENT_TYPE, float>, "GEMM epilogues are only supported for float");
+
+        if (numCols != rhs.numRows) {
+            throw MatrixSizeException();
+        }
+
+        result.resize(numRows, rhs.numCols);
+        Gemm::sgemm(false, false, numRows, rhs.numCols, numCols,
+                    data(), numCols,
+                    rhs.data(), rhs.numCols,
+                    0, result.data(), result.numCols, epilogue, numThreads);
+    }
+
+    /**
+     * Multiplication of the selected rows of this with rhs into an existing matrix. The rows are gathered
+     * by the GEMM packing, no copy of them is made. The epilogue is applied to every finished tile of the result.
+     * @param rows - indices of the rows of this to multiply (rows of the result)
+     * @param rhs - Matrix we are multiplying the rows with
+     * @param result - Matrix the product is stored to
+     * @param epilogue - Function applied to the tiles of the result (none by default)
+     * @param numThreads - Maximal number of threads of the GEMM, 0 for omp_get_max_threads() (see Gemm::sgemm)
+     */
+    void matmulRows(std::span<const unsigned int> rows, const Matrix &rhs, Matrix &result,
+                    const GemmEpilogue &epilogue = {}, size_t numThreads = 0) const {
+        static_assert(std::is_same_v<ELEMENT_TYPE, float>, "Gathered GEMM is only supported for float");
+
         if (numCols != rhs.numRows) {
             throw MatrixSizeException();
         }
 
-        numRowsToMultiply = numRowsToMultiply == -1 ? getNumRows() : numRowsToMultiply;
-        Matrix res(numRowsToMultiply, rhs.numCols, 0);
+        result.resize(rows.size(), rhs.numCols);
+        Gemm::sgemm(false, false, rows.size(), rhs.numCols, numCols,
+                    data(), numCols, rows.data(),
+                    rhs.data(), rhs.numCols,
+                    0, result.data(), result.numCols, epilogue, numThreads);
+    }
 
-        for (size_t i = 0; i < numRowsToMultiply; ++i) {
-            for (size_t k = 0; k < numCols; ++k) {
-                float x = getItem(i, k);
-#pragma omp simd
-                for (size_t j = 0; j < rhs.numCols; ++j) {
-                    res.matrix[i * res.numCols + j] += x * rhs.getItem(k, j);
-                }
-            }
+    /**
+     * Multiplication (selected rows of this)^T * rhs into an existing matrix, without copying the rows
+     * @param rows - indices of the rows of this (rows of rhs correspond to them)
+     * @param rhs - Matrix we are multiplying the transposed rows with
+     * @param result - Matrix the product is stored to
+     * @param numThreads - Maximal number of threads of the GEMM, 0 for omp_get_max_threads() (see Gemm::sgemm)
+     */
+    void matmulRowsTN(std::span<const unsigned int> rows, const Matrix &rhs, Matrix &result,
+                      size_t numThreads = 0) const {
+        static_assert(std::is_same_v<ELEMENT_TYPE, float>, "Gathered GEMM is only supported for float");
+
+        if (rows.size() != rhs.numRows) {
+            throw MatrixSizeException();
         }
 
-        return res;
+        result.resize(numCols, rhs.numCols);
+        Gemm::sgemm(true, false, numCols, rhs.numCols, rows.size(),
+                    data(), numCols, rows.data(),
+                    rhs.data(), rhs.numCols,
+                    0, result.data(), result.numCols, {}, numThreads);
+    }
+
+    /**
+     * Multiplication this^T * rhs into an existing matrix (its storage is reused, see resize)
+     * @param rhs - Matrix we are multiplying this^T with
+     * @param result - Matrix the product is stored to
+     * @param numThreads - Maximal number of threads of the GEMM, 0 for omp_get_max_threads() (see Gemm::sgemm)
+     */
+    void matmulTN(const Matrix &rhs, Matrix &result, size_t numThreads = 0) const {
+        multiply<true, false>(rhs, numCols, result, numThreads);
+    }
+
+    /**
+     * Multiplication this * rhs^T into an existing matrix (its storage is reused, see resize)
+     * @param rhs - Matrix whose transposition we are multiplying this with
+     * @param result - Matrix the product is stored to
+     * @param numThreads - Maximal number of threads of the GEMM, 0 for omp_get_max_threads() (see Gemm::sgemm)
+     */
+    void matmulNT(const Matrix &rhs, Matrix &result, size_t numThreads = 0) const {
+        multiply<false, true>(rhs, numRows, result, numThreads);
+    }
+
+    /**
+     * Mixed precision multiplication this * rhs into an existing matrix, where rhs is stored as bfloat16
+     * (the products are accumulated in float). The epilogue is applied to every finished tile of the result.
+     * @param rhs - Matrix we are multiplying *this with
+     * @param result - Matrix the product is stored to
+     * @param epilogue - Function applied to the tiles of the result (none by default)
+     * @param numThreads - Maximal number of threads of the GEMM, 0 for omp_get_max_threads() (see Gemm::sgemm)
+     */
+    void matmul(const Matrix<BFloat16_t> &rhs, Matrix &result, const GemmEpilogue &epilogue = {},
+                size_t numThreads = 0) const requires std::is_same_v<ELEMENT_TYPE, float> {
+        multiplyMixed(false, nullptr, numRows, rhs, result, epilogue, numThreads);
+    }
+
+    /**
+     * Mixed precision matmulRows, rhs is stored as bfloat16
+     * @param rows - indices of the rows of this to multiply (rows of the result)
+     * @param rhs - Matrix we are multiplying the rows with
+     * @param result - Matrix the product is stored to
+     * @param epilogue - Function applied to the tiles of the result (none by default)
+     * @param numThreads - Maximal number of threads of the GEMM, 0 for omp_get_max_threads() (see Gemm::sgemm)
+     */
+    void matmulRows(std::span<const unsigned int> rows, const Matrix<BFloat16_t> &rhs, Matrix &result,
+                    const GemmEpilogue &epilogue = {}, size_t numThreads = 0) const
+    requires std::is_same_v<ELEMENT_TYPE, float> {
+        multiplyMixed(false, rows.data(), rows.size(), rhs, result, epilogue, numThreads);
+    }
+
+    /**
+     * Mixed precision multiplication this * rhs^T into an existing matrix, rhs is stored as bfloat16
+     * @param rhs - Matrix whose transposition we are multiplying this with
+     * @param result - Matrix the product is stored to
+     * @param numThreads - Maximal number of threads of the GEMM, 0 for omp_get_max_threads() (see Gemm::sgemm)
+     */
+    void matmulNT(const Matrix<BFloat16_t> &rhs, Matrix &result, size_t numThreads = 0) const
+    requires std::is_same_v<ELEMENT_TYPE, float> {
+        multiplyMixed(true, nullptr, numRows, rhs, result, {}, numThreads);
     }
 
     /**
@@ -221,7 +500,8 @@ public:
     }
 
     void reset() {
-        std::fill(matrix.begin(), matrix.end(), 0);
+        makeWritable();
+        std::fill(storage(), storage() + numRows * numCols, 0);
     }
 
     /**
@@ -231,6 +511,7 @@ public:
      */
     template<typename F>
     void applyFunction(F f) {
+        makeWritable();
         for (size_t i = 0; i < getNumRows(); i++) {
 #pragma omp simd
             for (size_t j = 0; j < getNumCols(); j++) {
@@ -248,10 +529,11 @@ public:
             throw MatrixSizeException();
         }
 
+        makeWritable();
         for (size_t i = 0; i < getNumRows(); i++) {
 #pragma omp simd
             for (size_t j = 0; j < getNumCols(); j++) {
-                matrix[i * numCols + j] += rhs.getItem(i, j);
+                storage()[i * numCols + j] += rhs.getItem(i, j);
             }
         }
 
@@ -268,10 +550,11 @@ public:
             throw MatrixSizeException();
         }
 
+        makeWritable();
         for (size_t i = 0; i < getNumRows(); ++i) {
 #pragma omp simd
             for (size_t j = 0; j < getNumCols(); ++j) {
-                matrix[i * numCols + j] += rhs[j];
+                storage()[i * numCols + j] += rhs[j];
             }
         }
 
@@ -284,9 +567,10 @@ public:
      * @return this
      */
     auto &operator+=(ELEMENT_TYPE x) {
+        makeWritable();
         for (size_t i = 0; i < getNumRows(); ++i) {
             for (size_t j = 0; j < getNumCols(); ++j) {
-                matrix[i * numCols + j] += x;
+                storage()[i * numCols + j] += x;
             }
         }
 
@@ -303,10 +587,11 @@ public:
             throw MatrixSizeException();
         }
 
+        makeWritable();
         for (size_t i = 0; i < getNumRows(); i++) {
 #pragma omp simd
             for (size_t j = 0; j < getNumCols(); j++) {
-                matrix[i * numCols + j] -= rhs.getItem(i, j);
+                storage()[i * numCols + j] -= rhs.getItem(i, j);
             }
         }
 
@@ -323,10 +608,11 @@ public:
             throw MatrixSizeException();
         }
 
+        makeWritable();
         for (size_t i = 0; i < getNumRows(); i++) {
 #pragma omp simd
             for (size_t j = 0; j < getNumCols(); j++) {
-                matrix[i * numCols + j] *= rhs.getItem(i, j);
+                storage()[i * numCols + j] *= rhs.getItem(i, j);
             }
         }
 
@@ -339,10 +625,11 @@ public:
      * @return this
      */
     auto &operator*=(ELEMENT_TYPE x) {
+        makeWritable();
         for (size_t i = 0; i < numRows; ++i) {
 #pragma omp simd
             for (size_t j = 0; j < numCols; ++j) {
-                matrix[i * numCols + j] *= x;
+                storage()[i * numCols + j] *= x;
             }
         }
 
@@ -433,6 +720,7 @@ public:
      * @return result matrix
      */
     friend auto operator/(Matrix<ELEMENT_TYPE> lhs, const Matrix<ELEMENT_TYPE> &rhs) {
+        lhs.makeWritable();
         for (size_t i = 0; i < lhs.numRows; ++i) {
 #pragma omp simd
             for (size_t j = 0; j < lhs.numCols; ++j) {
@@ -443,6 +731,109 @@ public:
     }
 
     friend class DataManager;
+
+private:
+    /**
+     * @return pointer to the elements, owned or viewed
+     */
+    const ELEMENT_TYPE *elements() const {
+        return view != nullptr ? view : matrix.data();
+    }
+
+    /**
+     * @return pointer to the modifiable elements (the viewed ones for a writable view)
+     */
+    ELEMENT_TYPE *storage() {
+        return writableView != nullptr ? writableView : matrix.data();
+    }
+
+    /**
+     * Copies the elements of a read-only view into the matrix storage, so that they can be modified.
+     */
+    void makeWritable() {
+        if (view != nullptr && writableView == nullptr) {
+            matrix.assign(view, view + numRows * numCols);
+            view = nullptr;
+            viewOwner.reset();
+        }
+    }
+
+    /**
+     * Computes (rows of this) * op(rhs) into res, where rhs is stored as bfloat16
+     * @param transposeRhs - use rhs^T instead of rhs
+     * @param rows - indices of the rows of this, nullptr for all rows in order
+     * @param numResultRows - number of rows of the result
+     * @param rhs - right operand
+     * @param res - result matrix, resized to the shape of the product
+     * @param epilogue - function applied to the tiles of the result
+     * @param numThreads - maximal number of threads of the GEMM
+     */
+    void multiplyMixed(bool transposeRhs, const unsigned int *rows, size_t numResultRows,
+                       const Matrix<BFloat16_t> &rhs, Matrix &res, const GemmEpilogue &epilogue,
+                       size_t numThreads) const {
+        size_t rhsInnerSize = transposeRhs ? rhs.getNumCols() : rhs.getNumRows();
+        size_t resCols = transposeRhs ? rhs.getNumRows() : rhs.getNumCols();
+        if (numCols != rhsInnerSize) {
+            throw MatrixSizeException();
+        }
+
+        res.resize(numResultRows, resCols);
+        Gemm::sgemm(false, transposeRhs, numResultRows, resCols, numCols,
+                    data(), numCols, rows,
+                    rhs.data(), rhs.getNumCols(),
+                    0, res.data(), res.numCols, epilogue, numThreads);
+    }
+
+    /**
+     * Computes op(this) * op(rhs), where op is either identity or transposition.
+     * @param rhs - right operand
+     * @param rowsToMultiply - number of rows of op(this) used for the multiplication
+     * @return multiplied matrices
+     */
+    template<bool TRANSPOSE_THIS, bool TRANSPOSE_RHS>
+    Matrix multiply(const Matrix &rhs, size_t rowsToMultiply) const {
+        Matrix res;
+        multiply<TRANSPOSE_THIS, TRANSPOSE_RHS>(rhs, rowsToMultiply, res);
+        return res;
+    }
+
+    /**
+     * Computes op(this) * op(rhs) into res, where op is either identity or transposition.
+     * @param rhs - right operand
+     * @param rowsToMultiply - number of rows of op(this) used for the multiplication
+     * @param res - result matrix, resized to the shape of the product
+     * @param numThreads - maximal number of threads of the GEMM, 0 for omp_get_max_threads()
+     */
+    template<bool TRANSPOSE_THIS, bool TRANSPOSE_RHS>
+    void multiply(const Matrix &rhs, size_t rowsToMultiply, Matrix &res, size_t numThreads = 0) const {
+        size_t innerSize = TRANSPOSE_THIS ? numRows : numCols;
+        size_t rhsInnerSize = TRANSPOSE_RHS ? rhs.numCols : rhs.numRows;
+        size_t resCols = TRANSPOSE_RHS ? rhs.numRows : rhs.numCols;
+
+        if (innerSize != rhsInnerSize) {
+            throw MatrixSizeException();
+        }
+
+        res.resize(rowsToMultiply, resCols);
+
+        if constexpr (std::is_same_v<ELEMENT_TYPE, float>) {
+            Gemm::sgemm(TRANSPOSE_THIS, TRANSPOSE_RHS, rowsToMultiply, resCols, innerSize,
+                        data(), numCols,
+                        rhs.data(), rhs.numCols,
+                        0, res.data(), res.numCols, numThreads);
+        } else {
+            res.reset();
+            for (size_t i = 0; i < rowsToMultiply; ++i) {
+                for (size_t k = 0; k < innerSize; ++k) {
+                    ELEMENT_TYPE x = TRANSPOSE_THIS ? getItem(k, i) : getItem(i, k);
+                    for (size_t j = 0; j < resCols; ++j) {
+                        res.storage()[i * res.numCols + j] +=
+                                x * (TRANSPOSE_RHS ? rhs.getItem(j, k) : rhs.getItem(k, j));
+                    }
+                }
+            }
+        }
+    }
 };
 
 #endif //FEEDFORWARDNEURALNET_MATRIX_H
@@ -0,0 +1,36 @@
+#include "parameter_buffer.hpp"
+
+namespace {
+    size_t alignUp(size_t size) {
+        return (size + ParameterBuffer::ALIGNMENT - 1) / ParameterBuffer::ALIGNMENT * ParameterBuffer::ALIGNMENT;
+    }
+}
+
+ParameterBuffer::ParameterBuffer(const std::vector<size_t> &layerSizes) {
+    size_t offset = 0;
+    for (size_t i = 0; i + 1 < layerSizes.size(); ++i) {
+        layerRows.push_back(layerSizes[i]);
+        layerCols.push_back(layerSizes[i + 1]);
+        weightOffsets.push_back(offset);
+        offset += alignUp(layerSizes[i] * layerSizes[i + 1]);
+    }
+
+    weightsSize = offset;
+    for (size_t cols: layerCols) {
+        biasOffsets.push_back(offset);
+        offset += alignUp(cols);
+    }
+
+    elements.resize(offset, 0);
+}
+
+ParameterBuffer ParameterBuffer::zerosLike() const {
+    ParameterBuffer res;
+    res.layerRows = layerRows;
+    res.layerCols = layerCols;
+    res.weightOffsets = weightOffsets;
+    res.biasOffsets = biasOffsets;
+    res.weightsSize = weightsSize;
+    res.elements.resize(elements.size(), 0);
+    return res;
+}
@@ -0,0 +1,132 @@
+#ifndef FEEDFORWARDNEURALNET_PARAMETER_BUFFER_H
+#define FEEDFORWARDNEURALNET_PARAMETER_BUFFER_H
+
+#include "aligned_allocator.hpp"
+#include "matrix.hpp"
+#include <span>
+#include <vector>
+
+/**
+ * One contiguous, cache line aligned arena for the parameters of all layers of a network (or for their
+ * gradients, optimizer moments, ...). The weights of all layers come first, then the biases of all layers;
+ * every layer starts at a multiple of ALIGNMENT elements and the padding between the layers stays zero.
+ *
+ * Buffers created by zerosLike share the layout, so element i of the gradients belongs to element i of the
+ * parameters and element-wise updates (optimizers, weight decay, gradient reduction) are single flat loops
+ * over data() that can be split evenly across threads. Layers are accessed as views (weightsView, biasesView).
+ */
+class ParameterBuffer {
+    std::vector<size_t> layerRows;
+    std::vector<size_t> layerCols;
+    std::vector<size_t> weightOffsets;
+    std::vector<size_t> biasOffsets;
+    size_t weightsSize = 0;
+    std::vector<float, AlignedAllocator<float>> elements;
+
+public:
+    // Alignment of the layers in elements (a cache line)
+    static constexpr size_t ALIGNMENT = 64 / sizeof(float);
+
+    ParameterBuffer() = default;
+
+    /**
+     * Creates a zero-filled buffer for a network
+     * @param layerSizes - number of neurons of each layer, the input layer included
+     */
+    explicit ParameterBuffer(const std::vector<size_t> &layerSizes);
+
+    /**
+     * @return zero-filled buffer with the same layout
+     */
+    ParameterBuffer zerosLike() const;
+
+    /**
+     * @return number of layers (weight matrices)
+     */
+    size_t getNumLayers() const {
+        return layerRows.size();
+    }
+
+    /**
+     * @param layer - index of the layer
+     * @return rows of the weight matrix of the layer (its inputs)
+     */
+    size_t getNumRows(size_t layer) const {
+        return layerRows[layer];
+    }
+
+    /**
+     * @param layer - index of the layer
+     * @return columns of the weight matrix of the layer (its neurons, biases)
+     */
+    size_t getNumCols(size_t layer) const {
+        return layerCols[layer];
+    }
+
+    /**
+     * @param layer - index of the layer
+     * @return row-major weights of the layer
+     */
+    float *weights(size_t layer) {
+        return elements.data() + weightOffsets[layer];
+    }
+
+    const float *weights(size_t layer) const {
+        return elements.data() + weightOffsets[layer];
+    }
+
+    /**
+     * @param layer - index of the layer
+     * @return biases of the layer
+     */
+    float *biases(size_t layer) {
+        return elements.data() + biasOffsets[layer];
+    }
+
+    const float *biases(size_t layer) const {
+        return elements.data() + biasOffsets[layer];
+    }
+
+    /**
+     * @param layer - index of the layer
+     * @return writable matrix view of the weights of the layer
+     */
+    Matrix<float> weightsView(size_t layer) {
+        return Matrix<float>::createView(weights(layer), layerRows[layer], layerCols[layer]);
+    }
+
+    /**
+     * @param layer - index of the layer
+     * @return view of the biases of the layer
+     */
+    std::span<float> biasesView(size_t layer) {
+        return {biases(layer), layerCols[layer]};
+    }
+
+    /**
+     * @return first element of the arena
+     */
+    float *data() {
+        return elements.data();
+    }
+
+    const float *data() const {
+        return elements.data();
+    }
+
+    /**
+     * @return number of elements of the arena (the padding included)
+     */
+    size_t size() const {
+        return elements.size();
+    }
+
+    /**
+     * @return number of elements holding the weights (the biases start behind them)
+     */
+    size_t getWeightsSize() const {
+        return weightsSize;
+    }
+};
+
+#endif //FEEDFORWARDNEURALNET_PARAMETER_BUFFER_H
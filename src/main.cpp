@@ -1,24 +1,46 @@
+#include <filesystem>
 #include <iostream>
+#include <string>
 #include "csv/csv_reader.hpp"
 #include "data_manager/data_manager.hpp"
+#include "data_manager/tensor_file.hpp"
 #include "network/config.hpp"
 #include "optimizers/adam.hpp"
-#include "schedulers/lr_sheduler.hpp"
+#include "schedulers/schedules.hpp"
 #include "network/network.hpp"
 #include "csv/csv_writer.hpp"
 
-int main() {
-    CsvReader<float> trainVectors("./data/fashion_mnist_train_vectors.csv", 784);
-    CsvReader<unsigned int> trainLabels("./data/fashion_mnist_train_labels.csv", 1);
+/**
+ * Loads a part of the dataset from its tensor file (path.bin, created by CsvToBinary) if it exists,
+ * otherwise parses path.csv. Data vectors in the tensor files are expected to be normalized already.
+ * @param path - path of the file without the extension
+ * @param numCols - number of columns
+ * @param normalize - normalize the rows parsed from the CSV file
+ * @return loaded matrix (a view of the mapped tensor file)
+ */
+template<typename T>
+static Matrix<T> loadDataset(const std::string &path, int numCols, bool normalize = false) {
+    std::string binaryPath = path + ".bin";
+    if (std::filesystem::exists(binaryPath)) {
+        return TensorFile::map<T>(binaryPath.c_str());
+    }
+
+    CsvReader<T> reader((path + ".csv").c_str(), numCols);
+    if (normalize) {
+        reader.normalize();
+    }
+    return reader.getDataMatrixRvalRef();
+}
 
-    CsvReader<float> testVectors("./data/fashion_mnist_test_vectors.csv", 784);
-    CsvReader<unsigned int> testLabels("./data/fashion_mnist_test_labels.csv", 1);
+int main() {
+    auto trainVectors = loadDataset<float>("./data/fashion_mnist_train_vectors", 784, true);
+    auto trainLabels = loadDataset<unsigned int>("./data/fashion_mnist_train_labels", 1);
 
-    trainVectors.normalize();
-    testVectors.normalize();
+    auto testVectors = loadDataset<float>("./data/fashion_mnist_test_vectors", 784, true);
+    auto testLabels = loadDataset<unsigned int>("./data/fashion_mnist_test_labels", 1);
 
-    auto trainValSplit = DataManager::trainValidateSplit(trainVectors.getDataMatrixRvalRef(),
-                                                         trainLabels.getDataMatrix().getMatrixCol(0), 9.f / 10);
+    auto trainValSplit = DataManager::trainValidateSplit(std::move(trainVectors), trainLabels.getMatrixCol(0),
+                                                         9.f / 10);
 
     Config config;
     config.addLayer(784)
@@ -29,12 +51,12 @@ int main() {
     AdamOptimizer adam;
     Network network(config, &adam);
 
-    LRScheduler sched(0.001, 0.85, 30000);
+    ExponentialScheduler sched(0.001, 0.85, 30000);
     network.fit(trainValSplit, 30, 64, 0.1, 1e-6, 1, &sched, 5);
 
     std::cout << "\nTest set: ";
-    auto predicted = network.predict(testVectors.getDataMatrix());
-    auto testStats = Stats::getStats(predicted, testLabels.getDataMatrix().getMatrixCol(0));
+    auto predicted = network.predict(testVectors);
+    auto testStats = Stats::getStats(predicted, testLabels.getMatrixCol(0));
     std::cout << "Accuracy: " << testStats.accuracy << "% Loss: " << testStats.crossEntropy << std::endl;
 
     CsvWriter<unsigned int>::writeCsv("./actualPredictions", Stats::argmax(predicted));
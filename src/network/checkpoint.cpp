@@ -0,0 +1,284 @@
+#include "checkpoint.hpp"
+#include "inference_model.hpp"
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <variant>
+
+void Checkpoint::write(const char *path, const Network &network, bool withOptimizerState, LRScheduler *sched) {
+    const auto &layersConfig = network.networkConfig.layersConfig;
+
+    std::vector<std::span<const std::byte>> contents;
+    for (const auto &layerWeights: network.weights) {
+        contents.push_back(std::as_bytes(std::span(std::as_const(layerWeights).data(),
+                                                   layerWeights.getNumRows() * layerWeights.getNumCols())));
+    }
+    for (const auto &layerBiases: network.biases) {
+        contents.push_back(std::as_bytes(std::span(layerBiases)));
+    }
+    std::vector<std::span<std::byte>> state;
+    if (withOptimizerState) {
+        state = network.optimizer->getState();
+        contents.insert(contents.end(), state.begin(), state.end());
+    }
+    std::vector<std::span<std::byte>> schedulerState;
+    if (sched != nullptr) {
+        schedulerState = sched->getState();
+        contents.insert(contents.end(), schedulerState.begin(), schedulerState.end());
+    }
+
+    CheckpointHeader_t header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.numLayers = layersConfig.size();
+    header.mixedPrecision = network.networkConfig.mixedPrecision;
+    header.numOptimizerSections = state.size();
+    if (withOptimizerState) {
+        std::strncpy(header.optimizer, network.optimizer->getName(), sizeof(header.optimizer) - 1);
+    }
+    header.numTrainedSamples = network.numTrainedSamples;
+    header.numSchedulerSections = schedulerState.size();
+
+    std::vector<CheckpointLayer_t> layerRecords;
+    for (const auto &layer: layersConfig) {
+        layerRecords.push_back({.numNeurons=layer.numNeurons,
+                                .activation=static_cast<uint32_t>(layer.activationFunctionType), .reserved=0});
+    }
+
+    std::vector<CheckpointSection_t> sectionRecords;
+    size_t offset = sizeof(header) + layerRecords.size() * sizeof(CheckpointLayer_t) +
+                    contents.size() * sizeof(CheckpointSection_t);
+    for (const auto &section: contents) {
+        offset = (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        sectionRecords.push_back({.offset=offset, .size=section.size()});
+        offset += section.size();
+    }
+
+    std::string temporaryPath = std::string(path) + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(layerRecords.data()),
+                   static_cast<std::streamsize>(layerRecords.size() * sizeof(CheckpointLayer_t)));
+        file.write(reinterpret_cast<const char *>(sectionRecords.data()),
+                   static_cast<std::streamsize>(sectionRecords.size() * sizeof(CheckpointSection_t)));
+
+        const char padding[ALIGNMENT] = {};
+        for (size_t i = 0; i < contents.size(); ++i) {
+            auto position = static_cast<size_t>(file.tellp());
+            file.write(padding, static_cast<std::streamsize>(sectionRecords[i].offset - position));
+            file.write(reinterpret_cast<const char *>(contents[i].data()),
+                       static_cast<std::streamsize>(contents[i].size()));
+        }
+
+        if (!file) {
+            throw CheckpointError();
+        }
+    }
+
+    // Processes that mapped the previous checkpoint keep using it, the rename does not modify it
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        throw CheckpointError();
+    }
+}
+
+Config Checkpoint::readConfig(const char *path) {
+    MappedFile file(path);
+    const auto &header = readHeader(file);
+
+    Config config;
+    const CheckpointLayer_t *layerRecords = layers(header);
+    for (size_t i = 0; i < header.numLayers; ++i) {
+        config.addLayer(layerRecords[i].numNeurons, static_cast<ActivationFunction>(layerRecords[i].activation));
+    }
+    config.setMixedPrecision(header.mixedPrecision != 0);
+    return config;
+}
+
+void Checkpoint::read(const char *path, Network &network, LRScheduler *sched) {
+    MappedFile file(path);
+    restoreCommon(file, network);
+
+    const auto &header = readHeader(file);
+    const CheckpointSection_t *sectionRecords = sections(header);
+    const auto *base = static_cast<const char *>(file.data());
+
+    // Copied into the parameter arena, the weights may have been mapped views before
+    for (size_t i = 0; i < network.weights.size(); ++i) {
+        std::memcpy(network.parameters.weights(i), base + sectionRecords[i].offset, sectionRecords[i].size);
+        network.weights[i] = network.parameters.weightsView(i);
+    }
+
+    if (header.numOptimizerSections != 0 && std::strcmp(header.optimizer, network.optimizer->getName()) == 0) {
+        auto state = network.optimizer->getState();
+        if (state.size() != header.numOptimizerSections) {
+            throw CheckpointError();
+        }
+
+        const CheckpointSection_t *stateRecords = sectionRecords + 2 * network.weights.size();
+        for (size_t i = 0; i < state.size(); ++i) {
+            if (state[i].size() != stateRecords[i].size) {
+                throw CheckpointError();
+            }
+            std::memcpy(state[i].data(), base + stateRecords[i].offset, stateRecords[i].size);
+        }
+    }
+
+    if (sched != nullptr && numSchedulerSections(header) != 0) {
+        auto state = sched->getState();
+        if (state.size() != numSchedulerSections(header)) {
+            throw CheckpointError();
+        }
+
+        const CheckpointSection_t *stateRecords =
+                sectionRecords + 2 * network.weights.size() + header.numOptimizerSections;
+        // All sizes are checked first, a different schedule must not be restored partially
+        for (size_t i = 0; i < state.size(); ++i) {
+            if (state[i].size() != stateRecords[i].size) {
+                throw CheckpointError();
+            }
+        }
+        for (size_t i = 0; i < state.size(); ++i) {
+            std::memcpy(state[i].data(), base + stateRecords[i].offset, stateRecords[i].size);
+        }
+    }
+
+    network.updateGemmWeights();
+}
+
+void Checkpoint::map(const char *path, Network &network) {
+    auto file = std::make_shared<const MappedFile>(path);
+    restoreCommon(*file, network);
+
+    const CheckpointSection_t *sectionRecords = sections(readHeader(*file));
+    const auto *base = static_cast<const char *>(file->data());
+
+    for (size_t i = 0; i < network.weights.size(); ++i) {
+        auto elements = reinterpret_cast<const float *>(base + sectionRecords[i].offset);
+        network.weights[i] = Matrix<float>::createView(elements, network.weights[i].getNumRows(),
+                                                       network.weights[i].getNumCols(), file);
+    }
+
+    network.updateGemmWeights();
+}
+
+void Checkpoint::map(const char *path, InferenceModel &model) {
+    auto file = std::make_shared<const MappedFile>(path);
+    const auto &header = readHeader(*file);
+    const CheckpointLayer_t *layerRecords = layers(header);
+    const CheckpointSection_t *sectionRecords = sections(header);
+    const auto *base = static_cast<const char *>(file->data());
+
+    size_t numWeights = header.numLayers - 1;
+    for (size_t i = 0; i < numWeights; ++i) {
+        size_t numRows = layerRecords[i].numNeurons;
+        size_t numCols = layerRecords[i + 1].numNeurons;
+        const auto &weightsSection = sectionRecords[i];
+        const auto &biasesSection = sectionRecords[numWeights + i];
+        if (weightsSection.size != numRows * numCols * sizeof(float) || biasesSection.size != numCols * sizeof(float)) {
+            throw CheckpointError();
+        }
+
+        auto elements = reinterpret_cast<const float *>(base + weightsSection.offset);
+        model.weights.push_back(Matrix<float>::createView(elements, numRows, numCols, file));
+        auto biases = reinterpret_cast<const float *>(base + biasesSection.offset);
+        model.biases.emplace_back(biases, biases + numCols);
+        model.activations.push_back(
+                Activation::create(static_cast<ActivationFunction>(layerRecords[i + 1].activation)));
+        model.maxLayerSize = std::max(model.maxLayerSize, numCols);
+    }
+}
+
+const CheckpointHeader_t &Checkpoint::readHeader(const MappedFile &file) {
+    if (file.getSize() < offsetof(CheckpointHeader_t, numSchedulerSections)) {
+        throw CheckpointError();
+    }
+
+    // Version 1 headers are shorter, the remaining fields are read only once the version is known
+    const auto &header = *static_cast<const CheckpointHeader_t *>(file.data());
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version < 1 || header.version > VERSION ||
+        file.getSize() < headerSize(header) ||
+        header.numLayers < 2 || std::memchr(header.optimizer, 0, sizeof(header.optimizer)) == nullptr) {
+        throw CheckpointError();
+    }
+
+    size_t numSections = 2 * (header.numLayers - 1) + header.numOptimizerSections + numSchedulerSections(header);
+    size_t recordsSize = header.numLayers * sizeof(CheckpointLayer_t) + numSections * sizeof(CheckpointSection_t);
+    if (file.getSize() - headerSize(header) < recordsSize) {
+        throw CheckpointError();
+    }
+
+    const CheckpointLayer_t *layerRecords = layers(header);
+    for (size_t i = 0; i < header.numLayers; ++i) {
+        if (layerRecords[i].activation >= std::variant_size_v<Activation_t>) {
+            throw CheckpointError();
+        }
+    }
+
+    const CheckpointSection_t *sectionRecords = sections(header);
+    for (size_t i = 0; i < numSections; ++i) {
+        const auto &section = sectionRecords[i];
+        if (section.offset % ALIGNMENT != 0 || section.offset > file.getSize() ||
+            section.size > file.getSize() - section.offset) {
+            throw CheckpointError();
+        }
+    }
+    return header;
+}
+
+size_t Checkpoint::headerSize(const CheckpointHeader_t &header) {
+    return header.version == 1 ? offsetof(CheckpointHeader_t, numSchedulerSections) : sizeof(CheckpointHeader_t);
+}
+
+size_t Checkpoint::numSchedulerSections(const CheckpointHeader_t &header) {
+    return header.version == 1 ? 0 : header.numSchedulerSections;
+}
+
+const CheckpointLayer_t *Checkpoint::layers(const CheckpointHeader_t &header) {
+    return reinterpret_cast<const CheckpointLayer_t *>(reinterpret_cast<const char *>(&header) + headerSize(header));
+}
+
+const CheckpointSection_t *Checkpoint::sections(const CheckpointHeader_t &header) {
+    return reinterpret_cast<const CheckpointSection_t *>(layers(header) + header.numLayers);
+}
+
+void Checkpoint::restoreCommon(const MappedFile &file, Network &network) {
+    const auto &header = readHeader(file);
+    const auto &layersConfig = network.networkConfig.layersConfig;
+
+    if (header.numLayers != layersConfig.size()) {
+        throw CheckpointTopologyMismatch();
+    }
+    const CheckpointLayer_t *layerRecords = layers(header);
+    for (size_t i = 0; i < layersConfig.size(); ++i) {
+        if (layerRecords[i].numNeurons != layersConfig[i].numNeurons ||
+            layerRecords[i].activation != static_cast<uint32_t>(layersConfig[i].activationFunctionType)) {
+            throw CheckpointTopologyMismatch();
+        }
+    }
+
+    // The sizes follow from the topology, so a mismatch means a corrupted file
+    const CheckpointSection_t *sectionRecords = sections(header);
+    size_t numWeights = network.weights.size();
+    for (size_t i = 0; i < numWeights; ++i) {
+        const auto &layerWeights = network.weights[i];
+        if (sectionRecords[i].size != layerWeights.getNumRows() * layerWeights.getNumCols() * sizeof(float) ||
+            sectionRecords[numWeights + i].size != network.biases[i].size() * sizeof(float)) {
+            throw CheckpointError();
+        }
+    }
+
+    const auto *base = static_cast<const char *>(file.data());
+    for (size_t i = 0; i < numWeights; ++i) {
+        std::memcpy(network.biases[i].data(), base + sectionRecords[numWeights + i].offset,
+                    sectionRecords[numWeights + i].size);
+    }
+    network.numTrainedSamples = header.numTrainedSamples;
+}
@@ -0,0 +1,155 @@
+#ifndef FEEDFORWARDNEURALNET_CHECKPOINT_H
+#define FEEDFORWARDNEURALNET_CHECKPOINT_H
+
+#include "network.hpp"
+#include "../utils/mapped_file.hpp"
+#include <cstdint>
+#include <exception>
+
+class InferenceModel;
+
+class CheckpointError : public std::exception {
+};
+
+class CheckpointTopologyMismatch : public std::exception {
+};
+
+/**
+ * Header at the beginning of a checkpoint file. It is followed by numLayers CheckpointLayer_t records and
+ * by the CheckpointSection_t records of the weights and biases of every layer, of the optimizer state
+ * buffers and of the learning rate schedule state buffers (LRScheduler::getState). The sections are stored
+ * at multiples of Checkpoint::ALIGNMENT, in the byte order of the machine that wrote them.
+ * Version 1 headers end before numSchedulerSections (no schedule state).
+ */
+struct CheckpointHeader_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t numLayers;              // Including the input layer
+    uint32_t mixedPrecision;
+    uint32_t numOptimizerSections;   // Zero if saved without the optimizer state
+    char optimizer[16];              // Optimizer::getName of the saved optimizer state
+    uint64_t numTrainedSamples;
+    uint32_t numSchedulerSections;   // Zero if saved without the learning rate schedule state
+    uint32_t reserved;
+};
+
+struct CheckpointLayer_t {
+    uint64_t numNeurons;
+    uint32_t activation;             // ActivationFunction
+    uint32_t reserved;
+};
+
+struct CheckpointSection_t {
+    uint64_t offset;
+    uint64_t size;                   // In bytes
+};
+
+/**
+ * Versioned binary checkpoints of a network: topology, weights, biases and (optionally) the optimizer state
+ * and the state of the learning rate schedule.
+ *
+ * Resuming training:
+ *     Config config = Checkpoint::readConfig(path);
+ *     AdamOptimizer adam;
+ *     Network network(config, &adam);
+ *     PlateauScheduler sched(cosine);
+ *     Checkpoint::read(path, network, &sched);
+ *     network.fit(data, numEpochs, batchSize, eta, lambda, 0, &sched);
+ *
+ * Serving uses InferenceModel::fromCheckpoint (or Checkpoint::map into a network), the weights are then
+ * read-only views of the mapped file.
+ */
+class Checkpoint {
+public:
+    static constexpr char MAGIC[8] = {'F', 'F', 'N', 'N', 'C', 'K', 'P', 'T'};
+    static constexpr uint32_t VERSION = 2;
+    // Alignment of the sections in the file (and so in memory, mappings are page aligned)
+    static constexpr size_t ALIGNMENT = 64;
+
+    /**
+     * Writes a checkpoint. The file is written next to path first and then renamed, so an interrupted
+     * write never leaves a truncated checkpoint behind.
+     * @param path - path of the file
+     * @param network - network to save
+     * @param withOptimizerState - save the optimizer state as well (needed to resume the training)
+     * @param sched - learning rate schedule of the training whose state is saved too, none if nullptr
+     */
+    static void write(const char *path, const Network &network, bool withOptimizerState = true,
+                      LRScheduler *sched = nullptr);
+
+    /**
+     * Reads the topology of a saved network
+     * @param path - path of the file
+     * @return configuration to construct the network with (must outlive the network)
+     */
+    static Config readConfig(const char *path);
+
+    /**
+     * Restores the weights, biases and the number of trained samples of a network constructed from readConfig.
+     * The optimizer state is restored too if it was saved by an optimizer of the same type, the state of the
+     * schedule if it was saved (otherwise the schedule keeps its state, e.g. a PlateauScheduler starts over).
+     * Throws CheckpointTopologyMismatch if the network has a different topology and CheckpointError if the
+     * saved schedule state does not fit sched.
+     * @param path - path of the file
+     * @param network - network to restore
+     * @param sched - learning rate schedule to restore (the same kind of schedule as saved), none if nullptr
+     */
+    static void read(const char *path, Network &network, LRScheduler *sched = nullptr);
+
+    /**
+     * Maps a checkpoint into memory and makes the weights of a network read-only views of it (zero copy).
+     * The file stays mapped while the network uses it. The optimizer state is not restored.
+     * @param path - path of the file
+     * @param network - network to restore
+     */
+    static void map(const char *path, Network &network);
+
+    /**
+     * Maps a checkpoint into memory as an inference model (see InferenceModel::fromCheckpoint). The topology
+     * is taken from the file, the weights are read-only views of it and the biases are copied.
+     * @param path - path of the file
+     * @param model - empty model to fill
+     */
+    static void map(const char *path, InferenceModel &model);
+
+private:
+    /**
+     * Checks the header, the layer and section records of a mapped checkpoint
+     * @param file - mapped file
+     * @return header of the file
+     */
+    static const CheckpointHeader_t &readHeader(const MappedFile &file);
+
+    /**
+     * @param header - header of a checked checkpoint
+     * @return size of the header in the version of the file
+     */
+    static size_t headerSize(const CheckpointHeader_t &header);
+
+    /**
+     * @param header - header of a checked checkpoint
+     * @return number of the learning rate schedule state sections (zero in version 1 files)
+     */
+    static size_t numSchedulerSections(const CheckpointHeader_t &header);
+
+    /**
+     * @param header - header of a checked checkpoint
+     * @return layer records following the header
+     */
+    static const CheckpointLayer_t *layers(const CheckpointHeader_t &header);
+
+    /**
+     * @param header - header of a checked checkpoint
+     * @return section records following the layer records
+     */
+    static const CheckpointSection_t *sections(const CheckpointHeader_t &header);
+
+    /**
+     * Checks that the network has the saved topology and restores the biases and the number of trained samples
+     * @param file - mapped file
+     * @param network - network to restore
+     */
+    static void restoreCommon(const MappedFile &file, Network &network);
+};
+
+#endif //FEEDFORWARDNEURALNET_CHECKPOINT_H
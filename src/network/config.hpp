@@ -1,48 +1,28 @@
 #ifndef FEEDFORWARDNEURALNET_CONFIG_H
 #define FEEDFORWARDNEURALNET_CONFIG_H
 
-#include "../activation_functions/functions_enum.hpp"
-#include "../activation_functions/fast_sigmoid.hpp"
-#include "../activation_functions/relu.hpp"
-#include "../activation_functions/sigmoid.hpp"
-#include "../activation_functions/softmax.hpp"
+#include "../activation_functions/activation.hpp"
 #include <cstdlib>
-#include <memory>
-#include <utility>
 #include <vector>
-#include <functional>
 
 /**
  * Layer configuration
  */
 struct LayerConfig {
-    using ELEMENT_TYPE = float;
-    using ActivationFunction_t = std::function<void(Matrix<ELEMENT_TYPE> &)>;
-
     size_t numNeurons = 1;
-    ActivationFunction_t activationFunction;
-    ActivationFunction_t activationDerivFunction;
+    Activation_t activation;
     ActivationFunction activationFunctionType;
 
-    LayerConfig(size_t numNeurons,
-                ActivationFunction fnType,
-                ActivationFunction_t fn = {},
-                ActivationFunction_t fnDeriv = {}) :
-            numNeurons(numNeurons), activationFunction(std::move(fn)),
-            activationDerivFunction(fnDeriv), activationFunctionType(fnType) {}
-};
-
-class WrongActivationFunction : public std::exception {
+    LayerConfig(size_t numNeurons, ActivationFunction fnType) :
+            numNeurons(numNeurons), activation(Activation::create(fnType)), activationFunctionType(fnType) {}
 };
 
 /**
  * Network configuration
  */
 class Config {
-    using ELEMENT_TYPE = float;
-    using ActivationFunction_t = std::function<void(Matrix<ELEMENT_TYPE> &)>;
-
     std::vector<LayerConfig> layersConfig;
+    bool mixedPrecision = false;
 
 public:
     /**
@@ -53,8 +33,19 @@ public:
      */
     Config &addLayer(size_t nNeurons, ActivationFunction activationFunction = ActivationFunction::Identity);
 
+    /**
+     * Mixed precision training: the GEMMs read bfloat16 copies of the weights, which halves their memory
+     * traffic. The products are accumulated in float and the optimizer updates float master weights.
+     * @param enabled - use bfloat16 weight copies
+     * @return configuration
+     */
+    Config &setMixedPrecision(bool enabled = true);
+
 private:
     friend class Network;
+    friend class QuantizedNetwork;
+    friend class InferenceModel;
+    friend class Checkpoint;
 };
 
 
@@ -0,0 +1,74 @@
+#include "inference_model.hpp"
+#include "checkpoint.hpp"
+#include "../utils/vector_math.hpp"
+#include <algorithm>
+#include <utility>
+#include <variant>
+
+InferenceModel::InferenceModel(const Network &network) {
+    for (size_t l = 0; l < network.weights.size(); ++l) {
+        // The copy of a layer of the parameter arena owns its elements, the copy of a view of a mapped
+        // checkpoint views the same read-only mapping
+        const auto &layerWeights = network.weights[l];
+        weights.push_back(layerWeights);
+        biases.emplace_back(network.biases[l].begin(), network.biases[l].end());
+        activations.push_back(network.networkConfig.layersConfig[l + 1].activation);
+        maxLayerSize = std::max(maxLayerSize, layerWeights.getNumCols());
+    }
+}
+
+InferenceModel InferenceModel::fromCheckpoint(const char *path) {
+    InferenceModel model;
+    Checkpoint::map(path, model);
+    return model;
+}
+
+InferenceModel::Scratch_t InferenceModel::createScratch() const {
+    return {.layerOutputs=std::vector<float>(2 * ROW_BLOCK * maxLayerSize)};
+}
+
+void InferenceModel::predict(const float *data, size_t numRows, float *output, Scratch_t &scratch) const {
+    if (scratch.layerOutputs.size() < 2 * ROW_BLOCK * maxLayerSize) {
+        scratch.layerOutputs.resize(2 * ROW_BLOCK * maxLayerSize);
+    }
+
+    size_t numInputs = getNumInputs();
+    size_t numOutputs = getNumOutputs();
+
+    for (size_t first = 0; first < numRows; first += ROW_BLOCK) {
+        size_t rows = std::min(ROW_BLOCK, numRows - first);
+        const float *input = data + first * numInputs;
+
+        for (size_t i = 0; i < weights.size(); ++i) {
+            size_t layerInputs = weights[i].getNumRows();
+            size_t numNeurons = weights[i].getNumCols();
+            float *hiddenOutput = scratch.layerOutputs.data() + i % 2 * ROW_BLOCK * maxLayerSize;
+            float *layerOutput = i + 1 == weights.size() ? output + first * numOutputs : hiddenOutput;
+
+            LayerEpilogue epilogue{.bias=biases[i].data()};
+            auto layerEpilogue = LayerEpilogue::create(activations[i], epilogue);
+            if (rows <= Gemm::SMALL_M) {
+                Gemm::sgemv(rows, numNeurons, layerInputs, input, layerInputs, weights[i].data(), numNeurons,
+                            layerOutput, numNeurons, layerEpilogue);
+            } else {
+                Gemm::sgemm(false, false, rows, numNeurons, layerInputs, input, layerInputs, weights[i].data(),
+                            numNeurons, 0, layerOutput, numNeurons, layerEpilogue);
+            }
+
+            if (std::holds_alternative<class SoftMax>(activations[i])) {
+                VectorMath::softmax(layerOutput, rows, numNeurons);
+            }
+            input = layerOutput;
+        }
+    }
+}
+
+Matrix<float> InferenceModel::predict(const Matrix<float> &data, Scratch_t &scratch) const {
+    if (data.getNumCols() != getNumInputs()) {
+        throw WrongInputDataDimension();
+    }
+
+    Matrix<float> result(data.getNumRows(), getNumOutputs());
+    predict(data.data(), data.getNumRows(), result.data(), scratch);
+    return result;
+}
@@ -0,0 +1,91 @@
+#ifndef FEEDFORWARDNEURALNET_INFERENCE_MODEL_H
+#define FEEDFORWARDNEURALNET_INFERENCE_MODEL_H
+
+#include "network.hpp"
+#include <vector>
+
+/**
+ * Immutable copy of the weights of a trained network, for inference only.
+ *
+ * Unlike Network it holds no training state (optimizer, per-thread workspaces, thread count), and predict is
+ * const and reentrant: all the intermediate results are kept in a Scratch_t supplied by the caller. Any number
+ * of threads can therefore predict concurrently with one model, each with its own scratch. The rows are
+ * processed in blocks of ROW_BLOCK, so the scratch does not grow with the number of rows and the GEMMs stay
+ * on the calling thread.
+ */
+class InferenceModel {
+    std::vector<Matrix<float>> weights;
+    std::vector<std::vector<float>> biases;
+    std::vector<Activation_t> activations;
+    size_t maxLayerSize = 0;
+
+    friend class Checkpoint;
+
+    InferenceModel() = default;
+
+public:
+    // Rows passed through all the layers at once (sgemm parallelizes only larger blocks)
+    static constexpr size_t ROW_BLOCK = Gemm::MC;
+
+    /**
+     * Intermediate results of predict, owned by the calling thread
+     */
+    struct Scratch_t {
+        std::vector<float> layerOutputs;  // Outputs of the hidden layers, two blocks used alternately
+    };
+
+    /**
+     * Copies the weights of a network. Later training of the network does not change the model.
+     * Weights mapped from a checkpoint (Checkpoint::map) are not copied, the model views the mapping too.
+     * Mixed precision networks are copied with their float weights.
+     * @param network Trained network
+     */
+    explicit InferenceModel(const Network &network);
+
+    /**
+     * Creates a model from a checkpoint without constructing a Network (no parameter arena, gradients or
+     * optimizer). The weights are read-only views of the mapped file, which stays mapped while the model
+     * (or a copy of it) exists.
+     * @param path Path of the checkpoint
+     * @return Model of the saved network
+     */
+    static InferenceModel fromCheckpoint(const char *path);
+
+    /**
+     * @return Scratch large enough for predict, so that predict does not allocate
+     */
+    Scratch_t createScratch() const;
+
+    /**
+     * Predicts the output activations of the samples
+     * @param data    Row-major data vectors (numRows x number of inputs)
+     * @param numRows Number of samples
+     * @param output  Output activations (numRows x number of outputs)
+     * @param scratch Scratch of the calling thread (resized if it is too small)
+     */
+    void predict(const float *data, size_t numRows, float *output, Scratch_t &scratch) const;
+
+    /**
+     * Predicts the output activations of the samples
+     * @param data    Data vectors
+     * @param scratch Scratch of the calling thread (resized if it is too small)
+     * @return Output activations per sample
+     */
+    Matrix<float> predict(const Matrix<float> &data, Scratch_t &scratch) const;
+
+    /**
+     * @return Number of inputs (features of a sample)
+     */
+    size_t getNumInputs() const {
+        return weights.front().getNumRows();
+    }
+
+    /**
+     * @return Number of outputs (neurons of the output layer)
+     */
+    size_t getNumOutputs() const {
+        return weights.back().getNumCols();
+    }
+};
+
+#endif //FEEDFORWARDNEURALNET_INFERENCE_MODEL_H
@@ -1,288 +1,406 @@
+#include <algorithm>
 #include <chrono>
 #include <cassert>
+#include <cstdlib>
+#include <utility>
+#include <omp.h>
 #include "network.hpp"
 #include "../statistics/weights_info.hpp"
+#include "../utils/vector_math.hpp"
 
-void Network::updateWeights(size_t batchSize, float eta) {
-    optimizer->update(weightDeltas, deltaBiases, batchSize, eta);
+size_t Network::resolveNumThreads(size_t requested) {
+    if (requested != 0) {
+        return requested;
+    }
+
+    const char *envThreads = std::getenv("FFNN_NUM_THREADS");
+    if (envThreads != nullptr) {
+        long parsed = std::strtol(envThreads, nullptr, 10);
+        if (parsed > 0) {
+            return static_cast<size_t>(parsed);
+        }
+    }
+
+    return static_cast<size_t>(omp_get_max_threads());
 }
 
-Matrix<Network::ELEMENT_TYPE> Network::predict(const Matrix<float> &data) {
-    auto tmp = data.matmul(weights[0]);
-    tmp += biases[0];
+void Network::updateWeights(size_t batchSize, float eta, float lambda) {
+    // The weight decay is applied by the optimizer in the same pass over the parameters
+    optimizer->update(gradients, batchSize, eta, lambda);
+}
 
-    networkConfig.layersConfig[1].activationFunction(tmp);
+Matrix<Network::ELEMENT_TYPE> Network::predict(const Matrix<float> &data) const {
+    Matrix<ELEMENT_TYPE> tmp;
+    Matrix<ELEMENT_TYPE> next;
+    layerForward(data, 0, tmp, nullptr);
 
     for (size_t i = 1; i < weights.size(); ++i) {
-        tmp = tmp.matmul(weights[i]);
-        tmp += biases[i];
-
-        // i + 1 due to the way we store activation functions.
-        networkConfig.layersConfig[i + 1].activationFunction(tmp);
+        layerForward(tmp, i, next, nullptr);
+        std::swap(tmp, next);
     }
 
     return tmp;
 }
 
-auto Network::forwardPass(const Matrix<ELEMENT_TYPE> &data, const std::vector<unsigned int> &labels,
-                          size_t kthThread) {
+void Network::predictSmallBatch(const float *data, size_t numRows, float *output) const {
+    size_t maxLayerSize = 0;
+    for (const auto &layer: networkConfig.layersConfig) {
+        maxLayerSize = std::max(maxLayerSize, layer.numNeurons);
+    }
 
-    parallelActivationDerivResults[kthThread].clear();
-    parallelActivationResults[kthThread].clear();
+    // Outputs of the hidden layers, used alternately
+    thread_local std::vector<ELEMENT_TYPE> scratch;
+    if (scratch.size() < 2 * Gemm::SMALL_M * maxLayerSize) {
+        scratch.resize(2 * Gemm::SMALL_M * maxLayerSize);
+    }
 
-    parallelActivationResults[kthThread].push_back(data);
+    size_t numInputs = weights.front().getNumRows();
+    size_t numOutputs = weights.back().getNumCols();
 
-    auto tmp = data.matmul(weights[0]);
-    tmp += biases[0];
+    for (size_t first = 0; first < numRows; first += Gemm::SMALL_M) {
+        size_t rows = std::min(Gemm::SMALL_M, numRows - first);
+        const ELEMENT_TYPE *input = data + first * numInputs;
 
-    networkConfig.layersConfig[1].activationFunction(tmp);
-    parallelActivationResults[kthThread].push_back(tmp);
+        for (size_t i = 0; i < weights.size(); ++i) {
+            const auto &activation = networkConfig.layersConfig[i + 1].activation;
+            size_t numNeurons = weights[i].getNumCols();
+            ELEMENT_TYPE *layerOutput = i + 1 == weights.size() ? output + first * numOutputs
+                                                                : scratch.data() + i % 2 * Gemm::SMALL_M * maxLayerSize;
 
-    if (weights.size() == 1) {
-        parallelActivationDerivResults[kthThread].emplace_back();
-    } else {
-        auto tmpCopy = tmp;
-        networkConfig.layersConfig[1].activationDerivFunction(tmpCopy);
-        parallelActivationDerivResults[kthThread].push_back(tmpCopy);
-    }
+            LayerEpilogue epilogue{.bias=biases[i].data()};
+            Gemm::sgemv(rows, numNeurons, weights[i].getNumRows(), input, weights[i].getNumRows(),
+                        weights[i].data(), numNeurons, layerOutput, numNeurons,
+                        LayerEpilogue::create(activation, epilogue));
 
-    for (size_t i = 1; i < weights.size(); ++i) {
-        tmp = tmp.matmul(weights[i]);
-        tmp += biases[i];
-
-        // kthThread + 1 due to the way we store activation functions.
-        networkConfig.layersConfig[i + 1].activationFunction(tmp);
-        parallelActivationResults[kthThread].push_back(tmp);
+            if (std::holds_alternative<class SoftMax>(activation)) {
+                VectorMath::softmax(layerOutput, rows, numNeurons);
+            }
+            input = layerOutput;
+        }
+    }
+}
 
-        if (i == weights.size() - 1) {
-            parallelActivationDerivResults[kthThread].emplace_back();
+void Network::layerForward(const Matrix<ELEMENT_TYPE> &input, size_t layer, Matrix<ELEMENT_TYPE> &output,
+                           ThreadWorkspace_t *workspace) const {
+    // layer + 1 due to the way we store activation functions.
+    const auto &activation = networkConfig.layersConfig[layer + 1].activation;
+    size_t numNeurons = weights[layer].getNumCols();
+    size_t numRows = input.getNumRows();
+
+    LayerEpilogue epilogue{.bias=biases[layer].data()};
+    if (workspace != nullptr && layer < workspace->activationDerivs.size()) {
+        if (std::holds_alternative<class ReLU>(activation)) {
+            auto &mask = workspace->reluMasks[layer];
+            mask.resize(numRows * LayerEpilogue::maskStride(numNeurons));
+            epilogue.reluMask = mask.data();
+            epilogue.reluMaskStride = LayerEpilogue::maskStride(numNeurons);
         } else {
-            auto tmpCopy = tmp;
-            networkConfig.layersConfig[i + 1].activationDerivFunction(tmpCopy);
-            parallelActivationDerivResults[kthThread].push_back(tmpCopy);
+            auto &deriv = workspace->activationDerivs[layer];
+            deriv.resize(numRows, numNeurons);
+            epilogue.derivative = deriv.data();
+            epilogue.derivativeStride = numNeurons;
         }
     }
 
-    return Stats::getStats(tmp, labels);
+    auto multiply = [&](const auto &layerWeights) {
+        input.matmul(layerWeights, output, LayerEpilogue::create(activation, epilogue), numThreads);
+    };
+    if (networkConfig.mixedPrecision) {
+        multiply(gemmWeights[layer]);
+    } else {
+        multiply(weights[layer]);
+    }
+
+    if (std::holds_alternative<class SoftMax>(activation)) {
+        SoftMax::normal(output);
+    }
 }
 
-auto Network::forwardBackwardPass(const std::vector<Matrix<ELEMENT_TYPE>> &data,
-                                  const std::vector<std::vector<unsigned int>> &labels) {
-    float acc = 0;
-    float ce = 0;
-    size_t batchSize = 0;
-    for (auto &subBatch: data) batchSize += subBatch.getNumRows();
-
-    size_t currentStartRows = 0;
-    std::vector<size_t> startRows;
-    for (auto &d: data) {
-        startRows.push_back(currentStartRows);
-        currentStartRows += d.getNumRows();
+void Network::reserveWorkspace(size_t maxBatchSize) {
+    size_t maxRows = (maxBatchSize + numThreads - 1) / numThreads;
+    if (maxRows <= workspaceRows) {
+        return;
+    }
+
+    size_t maxLayerSize = 0;
+    for (const auto &layer: networkConfig.layersConfig) {
+        maxLayerSize = std::max(maxLayerSize, layer.numNeurons);
     }
 
-    deltaBiases.clear();
+    for (auto &workspace: workspaces) {
+        for (size_t i = 0; i < weights.size(); ++i) {
+            workspace.activations[i] = Matrix<ELEMENT_TYPE>(maxRows, weights[i].getNumCols());
+        }
+        for (size_t i = 0; i < workspace.activationDerivs.size(); ++i) {
+            size_t numNeurons = weights[i].getNumCols();
+            if (networkConfig.layersConfig[i + 1].activationFunctionType == ActivationFunction::ReLU) {
+                workspace.reluMasks[i].resize(maxRows * LayerEpilogue::maskStride(numNeurons));
+            } else {
+                workspace.activationDerivs[i] = Matrix<ELEMENT_TYPE>(maxRows, numNeurons);
+            }
+        }
+        workspace.delta = Matrix<ELEMENT_TYPE>(maxRows, maxLayerSize);
+        workspace.nextDelta = Matrix<ELEMENT_TYPE>(maxRows, maxLayerSize);
+    }
 
-    for (auto &weight: weights) {
-        deltaBiases.emplace_back(weight.getNumCols());
+    workspaceRows = maxRows;
+}
 
-        if (weight.getNumCols() == 0) {
-            throw std::exception();
+Stats_t Network::forwardPass(const BatchView_t &batch, ThreadWorkspace_t &workspace) {
+    // Gathered once, the backward pass of the first layer multiplies the same rows
+    if (!batch.rows.empty()) {
+        size_t numCols = batch.data->getNumCols();
+        workspace.input.resize(batch.rows.size(), numCols);
+        for (size_t j = 0; j < batch.rows.size(); ++j) {
+            std::copy_n(batch.data->data() + batch.rows[j] * numCols, numCols, workspace.input.data() + j * numCols);
         }
     }
+    layerForward(batch.rows.empty() ? *batch.data : workspace.input, 0, workspace.activations[0], &workspace);
 
-#pragma omp parallel for default(none) shared(weightDeltas)
-    for (size_t i = 0; i < weightDeltas.size(); ++i) {
-        weightDeltas[i].reset();
-        std::fill(deltaBiases[i].begin(), deltaBiases[i].end(), 0);
+    for (size_t i = 1; i < weights.size(); ++i) {
+        layerForward(workspace.activations[i - 1], i, workspace.activations[i], &workspace);
     }
 
-#pragma omp parallel for default(none) shared(acc, ce, data, labels, startRows, parallelActivationResults, parallelActivationDerivResults, deltaBiases, networkConfig, weightsTransposed)
-    for (size_t k = 0; k < NUM_NET_THREADS; ++k) {
-        if (data.size() - 1 < k)
-            continue;
+    return Stats::getStats(workspace.activations.back(), batch.labels);
+}
 
-        auto stats = forwardPass(data[k], labels[k], k);
+void Network::backwardPass(const BatchView_t &batch, ThreadWorkspace_t &workspace) {
+    auto &delta = workspace.delta;
+    auto &nextDelta = workspace.nextDelta;
+    CrossentropyFunction::costDelta(workspace.activations.back(), batch.labels, delta);
 
-        // Do backprop and then aggregate values into deltaWeights and deltaBiases
-        const auto &lastLayerConf = networkConfig.layersConfig[networkConfig.layersConfig.size() - 1];
-        if (lastLayerConf.activationFunctionType != ActivationFunction::SoftMax) {
-            throw WrongOutputActivationFunction();
+    for (int i = static_cast<int>(weights.size()) - 1; i >= 0; --i) {
+        if (i > 0) {
+            workspace.activations[i - 1].matmulTN(delta, workspace.deltaWeights[i]);
+        } else {
+            (batch.rows.empty() ? *batch.data : workspace.input).matmulTN(delta, workspace.deltaWeights[i]);
         }
 
-        size_t numLayers = networkConfig.layersConfig.size();
-
-        auto lastLayerDelta = CrossentropyFunction::costDelta(parallelActivationResults[k][numLayers - 1],
-                                                              labels[k]);
-        auto *lastDelta = &lastLayerDelta;
-        auto wDelta = parallelActivationResults[k][numLayers - 2].transpose().matmul(lastLayerDelta);
-
-#pragma omp critical
-        {
-            acc += stats.accuracy;
-            ce += stats.crossEntropy;
-            weightDeltas[numLayers - 2] += wDelta;
-        };
-
-        for (int i = static_cast<int>(numLayers) - 2; i > 0; --i) {
-            auto matmuls = lastDelta->matmul(weightsTransposed[i]);
-            matmuls *= parallelActivationDerivResults[k][i - 1];
-            lastLayerDelta = matmuls;
-            lastDelta = &lastLayerDelta;
-            wDelta = parallelActivationResults[k][i - 1].transpose().matmul(matmuls);
-
-#pragma omp critical
-            {
-                weightDeltas[i - 1] += wDelta;
-            };
+        // Bias gradient is the sum of the deltas over the samples
+        auto &deltaBias = workspace.deltaBiases[i];
+        std::fill(deltaBias.begin(), deltaBias.end(), 0);
+        for (size_t j = 0; j < delta.getNumRows(); ++j) {
+#pragma omp simd
+            for (size_t l = 0; l < delta.getNumCols(); ++l) {
+                deltaBias[l] += delta.getItem(j, l);
+            }
         }
 
-        for (size_t i = 0; i < numLayers - 1; ++i) {
-            std::fill(parallelDeltaBiases[k][i].begin(), parallelDeltaBiases[k][i].end(), 0);
-            for (size_t j = 0; j < parallelDeltaWeights[k][i].getNumRows(); ++j) {
-#pragma omp simd
-                for (size_t l = 0; l < parallelDeltaWeights[k][i].getNumCols(); ++l) {
-                    parallelDeltaBiases[k][i][l] += parallelDeltaWeights[k][i].getItem(j, l);
-                }
+        if (i > 0) {
+            if (networkConfig.mixedPrecision) {
+                delta.matmulNT(gemmWeights[i], nextDelta);
+            } else {
+                delta.matmulNT(weights[i], nextDelta);
             }
 
-#pragma omp critical
-            {
-#pragma omp simd
-                for (size_t j = 0; j < deltaBiases[i].size(); ++j) {
-                    deltaBiases[i][j] += parallelDeltaBiases[k][i][j] / static_cast<float>(data[k].getNumRows());
-                }
-            };
+            LayerEpilogue::applyDerivative(networkConfig.layersConfig[i].activation, nextDelta,
+                                           workspace.activationDerivs[i - 1], workspace.reluMasks[i - 1].data());
+
+            std::swap(delta, nextDelta);
         }
     }
-
-    return Stats_t{.accuracy=acc / NUM_NET_THREADS, .crossEntropy=ce / NUM_NET_THREADS};
 }
 
-auto Network::predictParallel(const std::vector<Matrix<float>> &dataBatches,
-                              const std::vector<std::vector<unsigned int>> &labels) {
+auto Network::forwardBackwardPass(const std::vector<BatchView_t> &subBatches) {
     float acc = 0;
     float ce = 0;
 
-#pragma omp parallel for default(none) shared(dataBatches, labels, acc, ce)
-    for (size_t k = 0; k < NUM_NET_THREADS; ++k) {
-        auto &data = dataBatches[k];
-        auto tmp = data.matmul(weights[0]);
-        tmp += biases[0];
+    const auto &lastLayerConf = networkConfig.layersConfig[networkConfig.layersConfig.size() - 1];
+    if (lastLayerConf.activationFunctionType != ActivationFunction::SoftMax) {
+        throw WrongOutputActivationFunction();
+    }
+
+    // Each thread computes the gradients of its sub-batch into its own buffers,
+    // they are summed up afterwards by reduceGradients (no locking needed).
+#pragma omp parallel for num_threads(numThreads) reduction(+:acc, ce) default(none) shared(subBatches)
+    for (size_t k = 0; k < subBatches.size(); ++k) {
+        auto stats = forwardPass(subBatches[k], workspaces[k]);
+        acc += stats.accuracy;
+        ce += stats.crossEntropy;
+
+        backwardPass(subBatches[k], workspaces[k]);
+    }
+
+    auto startReduction = std::chrono::high_resolution_clock::now();
+    reduceGradients(subBatches.size());
+    timings.reductionUs += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - startReduction).count();
+
+    return Stats_t{.accuracy=acc / static_cast<float>(subBatches.size()),
+            .crossEntropy=ce / static_cast<float>(subBatches.size())};
+}
 
-        networkConfig.layersConfig[1].activationFunction(tmp);
+void Network::reduceGradients(size_t numSubBatches) {
+    // The gradients of all layers are one buffer, split into equal blocks across the threads.
+    // A thread sums its blocks over all sub-batches, so each element is written by exactly one thread.
+    size_t size = gradients.size();
+    float *dst = gradients.data();
 
-        for (size_t i = 1; i < weights.size(); ++i) {
-            tmp = tmp.matmul(weights[i]);
-            tmp += biases[i];
+#pragma omp parallel for num_threads(numThreads) schedule(static) default(none) shared(numSubBatches, size, dst)
+    for (size_t first = 0; first < size; first += REDUCTION_BLOCK_SIZE) {
+        size_t n = std::min(REDUCTION_BLOCK_SIZE, size - first);
 
-            // i + 1 due to the way we store activation functions.
-            networkConfig.layersConfig[i + 1].activationFunction(tmp);
+        const float *src = workspaces[0].gradients.data() + first;
+        std::copy(src, src + n, dst + first);
+        for (size_t k = 1; k < numSubBatches; ++k) {
+            src = workspaces[k].gradients.data() + first;
+#pragma omp simd
+            for (size_t j = 0; j < n; ++j) {
+                dst[first + j] += src[j];
+            }
         }
+    }
+}
 
-        auto stats = Stats::getStats(tmp, labels[k]);
+Stats_t Network::trainStep(const std::vector<Matrix<ELEMENT_TYPE>> &data,
+                           const std::vector<std::vector<unsigned int>> &labels,
+                           size_t batchSize, float eta, float lambda) {
+    if (data.size() > numThreads) {
+        throw TooManySubBatches();
+    }
+
+    subBatchViews.clear();
+    for (size_t k = 0; k < data.size(); ++k) {
+        subBatchViews.push_back({.data=&data[k], .rows={}, .labels=labels[k]});
+    }
+    return trainStep(subBatchViews, batchSize, eta, lambda);
+}
+
+Stats_t Network::trainStep(const std::vector<BatchView_t> &subBatches, size_t batchSize, float eta, float lambda) {
+    // Each sub-batch is computed in the workspace of one thread
+    if (subBatches.size() > numThreads) {
+        throw TooManySubBatches();
+    }
+
+    reserveWorkspace(batchSize);
+    attachParameters();
+
+    auto startStep = std::chrono::high_resolution_clock::now();
+    auto stats = forwardBackwardPass(subBatches);
+
+    auto startUpdate = std::chrono::high_resolution_clock::now();
+    updateWeights(batchSize, eta, lambda);
+    updateGemmWeights();
+    auto endStep = std::chrono::high_resolution_clock::now();
+
+    timings.stepUs += std::chrono::duration_cast<std::chrono::microseconds>(endStep - startStep).count();
+    timings.updateUs += std::chrono::duration_cast<std::chrono::microseconds>(endStep - startUpdate).count();
+    ++timings.numSteps;
+    numTrainedSamples += batchSize;
+
+    return stats;
+}
+
+auto Network::predictParallel(const std::vector<Matrix<float>> &dataBatches,
+                              const std::vector<std::vector<unsigned int>> &labels) {
+    float acc = 0;
+    float ce = 0;
 
-#pragma omp critical
-        {
-            acc += stats.accuracy;
-            ce += stats.crossEntropy;
-        };
+#pragma omp parallel for num_threads(numThreads) reduction(+:acc, ce) default(none) shared(dataBatches, labels)
+    for (size_t k = 0; k < dataBatches.size(); ++k) {
+        auto tmp = predict(dataBatches[k]);
+        auto stats = Stats::getStats(tmp, labels[k]);
+        acc += stats.accuracy;
+        ce += stats.crossEntropy;
     }
 
-    return Stats_t{.accuracy = acc / static_cast<float>(NUM_NET_THREADS),
-            .crossEntropy = ce / static_cast<float>(NUM_NET_THREADS)};
+    return Stats_t{.accuracy = acc / static_cast<float>(dataBatches.size()),
+            .crossEntropy = ce / static_cast<float>(dataBatches.size())};
 }
 
-void Network::weightDecay(float lambda) {
-    if (lambda == 0)
+void Network::updateGemmWeights() {
+    if (!networkConfig.mixedPrecision) {
         return;
+    }
 
-    float decayCoeff = 1.f - lambda;
+    gemmWeights.resize(weights.size());
+    for (size_t i = 0; i < weights.size(); ++i) {
+        size_t numRows = weights[i].getNumRows();
+        size_t numCols = weights[i].getNumCols();
+        gemmWeights[i].resize(numRows, numCols);
+
+        const float *source = std::as_const(weights[i]).data();
+        BFloat16_t *destination = gemmWeights[i].data();
+#pragma omp parallel for num_threads(numThreads) default(none) shared(numRows, numCols, source, destination)
+        for (size_t row = 0; row < numRows; ++row) {
+            BFloat16::fromFloat(source + row * numCols, destination + row * numCols, numCols);
+        }
+    }
+}
 
-#pragma omp parallel for default(none) shared(decayCoeff, weights)
+void Network::attachParameters() {
     for (size_t i = 0; i < weights.size(); ++i) {
-        weights[i] *= decayCoeff;
+        const float *layerWeights = std::as_const(weights[i]).data();
+        if (layerWeights != parameters.weights(i)) {
+            std::copy(layerWeights, layerWeights + weights[i].getNumRows() * weights[i].getNumCols(),
+                      parameters.weights(i));
+            weights[i] = parameters.weightsView(i);
+        }
     }
 }
 
 void Network::fit(const TrainValSplit_t &trainValSplit, size_t numEpochs, size_t batchSize, float eta, float lambda,
                   uint8_t verboseLevel, LRScheduler *sched, size_t earlyStopping, long maxTimeMs) {
+    InMemoryDataSource source(trainValSplit);
+    fit(source, numEpochs, batchSize, eta, lambda, verboseLevel, sched, earlyStopping, maxTimeMs);
+}
+
+void Network::fit(DataSource &source, size_t numEpochs, size_t batchSize, float eta, float lambda,
+                  uint8_t verboseLevel, LRScheduler *sched, size_t earlyStopping, long maxTimeMs) {
     if (eta < 0) {
         throw NegativeEtaException();
     }
 
     auto startTime = std::chrono::high_resolution_clock::now();
 
-    auto &train_X = trainValSplit.trainData;
-    auto &train_y = trainValSplit.trainLabels;
-    auto &validation_X = trainValSplit.validationData;
-    auto &validation_y = trainValSplit.validationLabels;
+    auto &validation_X = source.getValidationData();
+    auto &validation_y = source.getValidationLabels();
 
-    auto validationBatches_X = DataManager::generateBatches(validation_X,
-                                                            (validation_X.getNumRows() + NUM_NET_THREADS - 1) / NUM_NET_THREADS);
-    auto validationBatches_y = DataManager::generateVectorBatches(validation_y,
-                                                                  (validation_y.size() + NUM_NET_THREADS - 1) / NUM_NET_THREADS);
-
-    // Copy train data
-    auto shuffledTrain_X = train_X;
-    auto shuffledTrain_y = train_y;
+    // Views of the validation set, one per thread
+    size_t validationBatchSize = (validation_X.getNumRows() + numThreads - 1) / numThreads;
+    std::vector<Matrix<float>> validationBatches_X;
+    for (size_t first = 0; first < validation_X.getNumRows(); first += validationBatchSize) {
+        validationBatches_X.push_back(DataManager::rowRange(
+                validation_X, first, std::min(validationBatchSize, validation_X.getNumRows() - first)));
+    }
+    auto validationBatches_y = DataManager::generateVectorBatches(validation_y, validationBatchSize);
 
-    auto trainBatches_X = DataManager::generateBatches(train_X, batchSize);
-    auto trainBatches_y = DataManager::generateVectorBatches(train_y, batchSize);
+    // Batches are read from the source and split on a background thread while the previous ones train
+    BatchPrefetcher trainBatches(source, batchSize, numThreads, numEpochs);
 
     float accSum = 0;
     float ceSum = 0;
+    timings = {};
+    reserveWorkspace(batchSize);
 
-    size_t numBatches = train_X.getNumRows() / batchSize;
-    size_t t = 0;
+    size_t numBatches = trainBatches.getNumBatches();
+    // A network restored from a checkpoint continues its learning rate schedule
+    size_t t = numTrainedSamples;
 
     float currentBestCE = 10000;
     size_t epochOfBestCE = 0;
 
-    sched->setEta(eta);
+    // Without a scheduler the learning rate stays constant
+    float baseEta = eta;
+    if (sched != nullptr) {
+        sched->setEta(eta);
+    }
 
     for (size_t i = 0; i < numEpochs; ++i) {
-        auto startPrep = std::chrono::high_resolution_clock::now();
-        // Reshuffle data
-        auto shuffledData = DataManager::randomShuffle(std::move(shuffledTrain_X), std::move(shuffledTrain_y));
-        shuffledTrain_X = std::move(shuffledData.data);
-        shuffledTrain_y = std::move(shuffledData.vectorLabels);
-
-        // Create new batches after reshuffling the data
-        trainBatches_X = DataManager::generateBatches(shuffledTrain_X, batchSize);
-        trainBatches_y = DataManager::generateVectorBatches(shuffledTrain_y, batchSize);
-
-        std::vector<std::vector<Matrix<float>>> parallelBatches_X(trainBatches_X.size());
-        std::vector<std::vector<std::vector<unsigned int>>> parallelBatches_y(trainBatches_X.size());
-
-#pragma omp parallel default(none) shared(parallelBatches_X, parallelBatches_y, batchSize, trainBatches_X, trainBatches_y)
-        {
-#pragma omp for nowait
-            for (size_t j = 0; j < trainBatches_X.size(); ++j) {
-                parallelBatches_X[j] = (
-                        DataManager::generateBatches(trainBatches_X[j], (trainBatches_X[j].getNumRows() + NUM_NET_THREADS - 1) / NUM_NET_THREADS));
-            }
-
-#pragma omp for
-            for (size_t k = 0; k < trainBatches_y.size(); ++k) {
-                parallelBatches_y[k] = (
-                        DataManager::generateVectorBatches(trainBatches_y[k], (trainBatches_y[k].size() + NUM_NET_THREADS - 1) / NUM_NET_THREADS));
-            }
-        }
-
         auto start = std::chrono::high_resolution_clock::now();
 
         for (size_t j = 0; j < numBatches; ++j) {
-            eta = sched->exponential(t);
+            eta = sched != nullptr ? sched->getEta(t) : baseEta;
 
-            auto stats = forwardBackwardPass(parallelBatches_X[j], parallelBatches_y[j]);
+            auto stats = trainStep(trainBatches.acquire(), batchSize, eta, lambda);
+            trainBatches.release();
             accSum += stats.accuracy;
             ceSum += stats.crossEntropy;
 
-            weightDecay(lambda);
-            updateWeights(batchSize, eta);
-
             t += batchSize;
         }
+        timings.prepUs = trainBatches.getPrepUs();
+        timings.waitUs = trainBatches.getWaitUs();
 
         auto valStats = predictParallel(validationBatches_X, validationBatches_y);
 
@@ -310,9 +428,19 @@ void Network::fit(const TrainValSplit_t &trainValSplit, size_t numEpochs, size_t
 
             std::cout << "Time taken by function: "
                       << duration.count() << " microseconds" << std::endl;
+            std::cout << "Total step time: " << timings.stepUs << " us (gradient reduction "
+                      << 100.f * static_cast<float>(timings.reductionUs) / static_cast<float>(timings.stepUs)
+                      << "%, weight update "
+                      << 100.f * static_cast<float>(timings.updateUs) / static_cast<float>(timings.stepUs)
+                      << "%), data preparation: " << timings.prepUs << " us (waited for batches: "
+                      << timings.waitUs << " us)" << std::endl;
             std::cout << "ETA: " << eta << std::endl;
         }
 
+        if (sched != nullptr) {
+            sched->epochEnd(valStats.crossEntropy);
+        }
+
         if (earlyStopping != 0) {
             if (valStats.crossEntropy < currentBestCE) {
                 currentBestCE = valStats.crossEntropy;
@@ -1,18 +1,21 @@
 #ifndef FEEDFORWARDNEURALNET_NETWORK_H
 #define FEEDFORWARDNEURALNET_NETWORK_H
 
+#include <algorithm>
+#include <span>
+#include <utility>
 #include <vector>
 #include "../data_structures/matrix.hpp"
+#include "../data_structures/parameter_buffer.hpp"
 #include "config.hpp"
+#include "../activation_functions/layer_epilogue.hpp"
 #include "../statistics/stats.hpp"
 #include "../data_manager/data_manager.hpp"
+#include "../data_manager/batch_prefetcher.hpp"
+#include "../data_manager/data_source.hpp"
 #include "../optimizers/optimizer_template.hpp"
 #include "../schedulers/lr_sheduler.hpp"
 
-#ifndef NUM_NET_THREADS
-#define NUM_NET_THREADS 5
-#endif
-
 class WrongInputDataDimension : public std::exception {
 };
 
@@ -22,31 +25,93 @@ class WrongOutputActivationFunction : public std::exception {
 class NegativeEtaException : public std::exception {
 };
 
+class TooManySubBatches : public std::exception {
+};
+
+/**
+ * Accumulated durations of the training steps (in microseconds)
+ */
+struct StepTimings_t {
+    long stepUs = 0;       // Whole step: forward & backward pass, gradient reduction and weight update
+    long reductionUs = 0;  // Summing the per-thread gradients
+    long updateUs = 0;     // Weight decay and optimizer update
+    long prepUs = 0;       // Reading the batches from the data source (on the prefetch thread, overlaps the steps)
+    long waitUs = 0;       // Steps waiting for the prefetch thread to prepare a batch
+    size_t numSteps = 0;
+};
+
+/**
+ * Per-thread buffers of a training step. They are sized by Network::reserveWorkspace,
+ * so that a training step does not allocate.
+ */
+struct ThreadWorkspace_t {
+    using ELEMENT_TYPE = float;
+
+    Matrix<ELEMENT_TYPE> input;                          // Sub-batch rows gathered from the training set
+    std::vector<Matrix<ELEMENT_TYPE>> activations;       // activations[i] is the output of weights[i]
+    std::vector<Matrix<ELEMENT_TYPE>> activationDerivs;  // Activation derivatives of the hidden layers
+    std::vector<std::vector<LayerEpilogue::Mask_t>> reluMasks;  // Derivatives of the hidden ReLU layers
+    Matrix<ELEMENT_TYPE> delta;                          // Delta of the layer being backpropagated
+    Matrix<ELEMENT_TYPE> nextDelta;                      // Delta of the layer below it
+    ParameterBuffer gradients;                           // Gradients of the sub-batch
+    std::vector<Matrix<ELEMENT_TYPE>> deltaWeights;      // Weight views of gradients
+    std::vector<std::span<ELEMENT_TYPE>> deltaBiases;    // Bias views of gradients
+};
+
 class Network {
     using ELEMENT_TYPE = float;
 
+    // Gradient elements summed by a thread at once in reduceGradients
+    static constexpr size_t REDUCTION_BLOCK_SIZE = 4096;
+
     const Config &networkConfig;
     Optimizer *optimizer;
+    size_t numThreads;
+    // Weights and biases of all layers in one arena, weights and biases are views of it
+    ParameterBuffer parameters;
     std::vector<Matrix<ELEMENT_TYPE>> weights;
-    std::vector<Matrix<ELEMENT_TYPE>> weightsTransposed;
-    std::vector<std::vector<ELEMENT_TYPE>> biases;
+    std::vector<std::span<ELEMENT_TYPE>> biases;
+    // bfloat16 copies of the weights read by the GEMMs in mixed precision mode (empty otherwise)
+    std::vector<Matrix<BFloat16_t>> gemmWeights;
 
-    std::vector<std::vector<Matrix<ELEMENT_TYPE>>> parallelActivationResults;
-    std::vector<std::vector<Matrix<ELEMENT_TYPE>>> parallelActivationDerivResults;
+    std::vector<ThreadWorkspace_t> workspaces;
+    size_t workspaceRows = 0;
+    std::vector<BatchView_t> subBatchViews;
 
-    std::vector<std::vector<ELEMENT_TYPE>> deltaBiases;
+    // Gradients of the whole batch (same layout as parameters), weightDeltas and deltaBiases are views of it
+    ParameterBuffer gradients;
+    std::vector<std::span<ELEMENT_TYPE>> deltaBiases;
     std::vector<Matrix<ELEMENT_TYPE>> weightDeltas;
 
-    std::vector<std::vector<Matrix<ELEMENT_TYPE>>> parallelDeltaWeights;
-    std::vector<std::vector<std::vector<ELEMENT_TYPE>>> parallelDeltaBiases;
+    StepTimings_t timings;
+    // Samples passed through trainStep since the weights were initialized (restored from checkpoints)
+    size_t numTrainedSamples = 0;
+
+    friend class QuantizedNetwork;
+    friend class InferenceModel;
+    friend class Checkpoint;
 
 public:
-    Network(const Config &config, Optimizer *optimizer) : networkConfig(config), optimizer(optimizer) {
-        for (size_t i = 0; i < NUM_NET_THREADS; ++i) {
-            parallelActivationResults.emplace_back(config.layersConfig.size());
-            parallelActivationDerivResults.emplace_back(config.layersConfig.size());
-            parallelDeltaWeights.emplace_back();
-            parallelDeltaBiases.emplace_back();
+    /**
+     * Creates a network with randomly initialized weights.
+     * @param config     Network topology
+     * @param optimizer  Optimizer used to update the weights
+     * @param numThreads Number of threads (and sub-batches each batch is split into). If zero, the value of
+     *                   the FFNN_NUM_THREADS environment variable is used, otherwise omp_get_max_threads().
+     */
+    Network(const Config &config, Optimizer *optimizer, size_t numThreads = 0)
+            : networkConfig(config), optimizer(optimizer), numThreads(resolveNumThreads(numThreads)) {
+        std::vector<size_t> layerSizes;
+        for (const auto &layer: config.layersConfig) {
+            layerSizes.push_back(layer.numNeurons);
+        }
+        parameters = ParameterBuffer(layerSizes);
+        gradients = parameters.zerosLike();
+
+        workspaces.resize(this->numThreads);
+        subBatchViews.reserve(this->numThreads);
+        for (auto &workspace: workspaces) {
+            workspace.gradients = parameters.zerosLike();
         }
 
         // We are initializing weights between each two layers.
@@ -56,88 +121,219 @@ public:
             const auto &layer = config.layersConfig[i];
             const auto &nextLayer = config.layersConfig[i + 1];
 
-            // Uniform HE initialization
-            if (nextLayer.activationFunctionType == ActivationFunction::ReLU) {
-                float limit = 6 / sqrt(layer.numNeurons);
-                weights.push_back(
-                        Matrix<float>::generateRandomUniformMatrix(layer.numNeurons, nextLayer.numNeurons, -limit,
-                                                                   limit));
-            }
-                // Uniform Glorot initialization
-            else {
-                float limit = 6 / sqrt(layer.numNeurons + nextLayer.numNeurons);
-                weights.push_back(
-                        Matrix<float>::generateRandomUniformMatrix(layer.numNeurons, nextLayer.numNeurons, -limit,
-                                                                   limit));
-            }
+            // Uniform HE initialization for ReLU layers, uniform Glorot initialization otherwise
+            float limit = nextLayer.activationFunctionType == ActivationFunction::ReLU
+                          ? 6 / sqrt(layer.numNeurons)
+                          : 6 / sqrt(layer.numNeurons + nextLayer.numNeurons);
+            auto initialWeights = Matrix<float>::generateRandomUniformMatrix(layer.numNeurons, nextLayer.numNeurons,
+                                                                             -limit, limit);
+            const float *initial = std::as_const(initialWeights).data();
+            std::copy(initial, initial + layer.numNeurons * nextLayer.numNeurons, parameters.weights(i));
 
-            weightDeltas.emplace_back(layer.numNeurons, nextLayer.numNeurons, 0);
-            weightsTransposed.push_back(weights[i].transpose());
+            // Biases are initialized as zero (the arena is zero-filled)
+            weights.push_back(parameters.weightsView(i));
+            biases.push_back(parameters.biasesView(i));
+            weightDeltas.push_back(gradients.weightsView(i));
+            deltaBiases.push_back(gradients.biasesView(i));
 
-            // Init biases as zero
-            biases.emplace_back(nextLayer.numNeurons, 0);
-            deltaBiases.emplace_back(nextLayer.numNeurons, 0);
-
-            for (size_t k = 0; k < NUM_NET_THREADS; ++k) {
-                parallelDeltaWeights[k].emplace_back();
-                parallelDeltaBiases[k].emplace_back(nextLayer.numNeurons, 0);
+            for (auto &workspace: workspaces) {
+                workspace.activations.emplace_back();
+                if (i + 2 < config.layersConfig.size()) {
+                    workspace.activationDerivs.emplace_back();
+                    workspace.reluMasks.emplace_back();
+                }
+                workspace.deltaWeights.push_back(workspace.gradients.weightsView(i));
+                workspace.deltaBiases.push_back(workspace.gradients.biasesView(i));
             }
         }
 
-        optimizer->setMatrices(weights, weightsTransposed, biases);
+        optimizer->setParameters(parameters);
+        optimizer->setNumThreads(this->numThreads);
         optimizer->init();
+        updateGemmWeights();
     }
 
+    // The weights are views of the parameters of the network, a copy would share them
+    Network(const Network &) = delete;
+
+    Network &operator=(const Network &) = delete;
+
     /**
      * Trains the network.
      * @param trainValSplit Training and validation datasets
      * @param eta           Learning rate
      * @param numEpochs     Number of loops through the training dataset
      * @param batchSize     Number of samples used for a single weight update
+     * @param sched         Learning rate schedule (see schedules.hpp), constant eta if nullptr. When resuming
+     *                      from a checkpoint, pass it to Checkpoint::read as well to restore its state.
      */
     void fit(const TrainValSplit_t &trainValSplit, size_t numEpochs = 1, size_t batchSize = 32, float eta = 0.1,
              float lambda = 1e-6, uint8_t verboseLevel = 0, LRScheduler *sched = nullptr,
              size_t earlyStopping = 0,
              long maxTimeMs = 0);
 
+    /**
+     * Trains the network on samples read from a data source (e.g. StreamingDataSource for datasets
+     * that do not fit into memory). The other parameters are the same as above.
+     * @param source Training samples and validation set
+     */
+    void fit(DataSource &source, size_t numEpochs = 1, size_t batchSize = 32, float eta = 0.1,
+             float lambda = 1e-6, uint8_t verboseLevel = 0, LRScheduler *sched = nullptr,
+             size_t earlyStopping = 0,
+             long maxTimeMs = 0);
+
     /**
      * Predicts the data labels (should be ran on a trained network, otherwise it's just a random projection).
      * @param data Data vectors
      * @return Predicted labels (output activations per sample).
      */
-    Matrix<ELEMENT_TYPE> predict(const Matrix<float> &data);
+    Matrix<ELEMENT_TYPE> predict(const Matrix<float> &data) const;
+
+    /**
+     * Low-latency prediction of a few samples (e.g. online scoring of single rows). The layers are computed
+     * by Gemm::sgemv in a per-thread scratch buffer, so apart from the first call on a thread nothing is
+     * allocated. Mixed precision networks use the float weights here.
+     * @param data    Row-major data vectors (numRows x number of inputs)
+     * @param numRows Number of samples, processed in chunks of Gemm::SMALL_M
+     * @param output  Output activations (numRows x number of outputs)
+     */
+    void predictSmallBatch(const float *data, size_t numRows, float *output) const;
 
     auto predictParallel(const std::vector<Matrix<float>> &data, const std::vector<std::vector<unsigned int>> &labels);
 
+    /**
+     * Does a single training step: forward & backward pass, weight decay and weight update.
+     * Once the workspace is large enough for the batch, the step does not allocate.
+     * @param data      Batch split into (at most numThreads) sub-batches
+     * @param labels    Labels of the sub-batches
+     * @param batchSize Number of samples in the batch
+     * @param eta       Learning rate
+     * @param lambda    Weight decay rate
+     * @return Batch train stats
+     * @throws TooManySubBatches if there are more sub-batches than threads
+     */
+    Stats_t trainStep(const std::vector<Matrix<ELEMENT_TYPE>> &data,
+                      const std::vector<std::vector<unsigned int>> &labels,
+                      size_t batchSize, float eta, float lambda);
+
+    /**
+     * Does a single training step on a batch given by views of the dataset rows (see BatchPrefetcher),
+     * the rows are gathered once per step and multiplied by both GEMMs of the first layer.
+     * @param subBatches Batch split into (at most numThreads) sub-batches
+     * @param batchSize  Number of samples in the batch
+     * @param eta        Learning rate
+     * @param lambda     Weight decay rate
+     * @return Batch train stats
+     * @throws TooManySubBatches if there are more sub-batches than threads
+     */
+    Stats_t trainStep(const std::vector<BatchView_t> &subBatches, size_t batchSize, float eta, float lambda);
+
+    /**
+     * Preallocates the per-thread buffers for batches of up to maxBatchSize samples.
+     * @param maxBatchSize Maximal batch size
+     */
+    void reserveWorkspace(size_t maxBatchSize);
+
+    /**
+     * @return Number of inputs (features of a sample)
+     */
+    size_t getNumInputs() const {
+        return weights.front().getNumRows();
+    }
+
+    /**
+     * @return Number of outputs (neurons of the output layer)
+     */
+    size_t getNumOutputs() const {
+        return weights.back().getNumCols();
+    }
+
+    /**
+     * @return Number of threads the network trains and predicts with
+     */
+    size_t getNumThreads() const {
+        return numThreads;
+    }
+
+    /**
+     * @return Step timings accumulated during the last call of fit
+     */
+    const StepTimings_t &getTimings() const {
+        return timings;
+    }
+
+    /**
+     * @return Number of samples the network has been trained on, the learning rate schedule continues from it
+     */
+    size_t getNumTrainedSamples() const {
+        return numTrainedSamples;
+    }
+
 private:
+    /**
+     * Picks the number of threads to use
+     * @param requested Requested number of threads, 0 to pick automatically
+     * @return requested if non-zero, FFNN_NUM_THREADS if set, omp_get_max_threads() otherwise
+     */
+    static size_t resolveNumThreads(size_t requested);
+
+    /**
+     * Computes the output of a layer: input * weights + bias passed through the activation function,
+     * all fused into a single GEMM.
+     * @param input     Input of the layer
+     * @param layer     Index of the layer weights
+     * @param output    Matrix the output is stored to
+     * @param workspace If not nullptr, the activation derivative is stored to its buffers
+     */
+    void layerForward(const Matrix<ELEMENT_TYPE> &input, size_t layer, Matrix<ELEMENT_TYPE> &output,
+                      ThreadWorkspace_t *workspace) const;
+
     /**
      * Do single thread forward pass
-     * @param data      Train data vectors
-     * @param labels    Train labels
-     * @param kthThread Thread number
+     * @param batch     Train data vectors and labels of the sub-batch
+     * @param workspace Buffers of the thread
      * @return Single thread batch stats
      */
-    auto forwardPass(const Matrix<float> &data, const std::vector<unsigned int> &labels, size_t kthThread);
+    Stats_t forwardPass(const BatchView_t &batch, ThreadWorkspace_t &workspace);
+
+    /**
+     * Do single thread backward pass, computes the gradients of the sub-batch into the workspace
+     * @param batch     Train data vectors and labels of the sub-batch
+     * @param workspace Buffers of the thread (filled by forwardPass)
+     */
+    void backwardPass(const BatchView_t &batch, ThreadWorkspace_t &workspace);
 
     /**
      * Do parallel forward & backward pass and compute weight deltas
-     * @param data   Train data vectors
-     * @param labels Train labels
+     * @param subBatches Train data vectors and labels of the sub-batches
      * @return Batch train stats
      */
-    auto forwardBackwardPass(const std::vector<Matrix<ELEMENT_TYPE>> &data,
-                             const std::vector<std::vector<unsigned int>> &labels);
+    auto forwardBackwardPass(const std::vector<BatchView_t> &subBatches);
+
+    /**
+     * Sums the per-thread gradients into gradients (weightDeltas and deltaBiases)
+     * @param numSubBatches Number of sub-batches (threads) that computed gradients
+     */
+    void reduceGradients(size_t numSubBatches);
 
     /**
      * Updates weights using selected optimizer
+     * @param batchSize Number of samples the gradients are summed over
+     * @param eta       Learning rate
+     * @param lambda    Weight decay rate
+     */
+    void updateWeights(size_t batchSize, float eta, float lambda);
+
+    /**
+     * Rounds the updated weights to their bfloat16 copies (in mixed precision mode)
      */
-    void updateWeights(size_t batchSize, float eta);
+    void updateGemmWeights();
 
     /**
-     * Calculate weight decay
-     * @param lambda Decay rate
+     * Copies weights that are not views of parameters (e.g. mapped from a checkpoint) into it and makes
+     * them views of it again, so that the optimizer updates them
      */
-    void weightDecay(float lambda);
+    void attachParameters();
 };
 
 #endif //FEEDFORWARDNEURALNET_NETWORK_H
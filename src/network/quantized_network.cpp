@@ -0,0 +1,195 @@
+#include "quantized_network.hpp"
+#include "../utils/vector_math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <variant>
+
+QuantizedNetwork::QuantizedNetwork(const Network &network, const Matrix<float> &calibrationData) {
+    if (calibrationData.getNumCols() != network.weights[0].getNumRows()) {
+        throw WrongInputDataDimension();
+    }
+
+    const Matrix<float> *input = &calibrationData;
+    Matrix<float> outputs[2];
+
+    for (size_t l = 0; l < network.weights.size(); ++l) {
+        const auto &weights = network.weights[l];
+        size_t numInputs = weights.getNumRows();
+        size_t numOutputs = weights.getNumCols();
+
+        QuantizedLayer_t layer;
+        layer.numInputs = numInputs;
+        layer.numOutputs = numOutputs;
+        layer.biases.assign(network.biases[l].begin(), network.biases[l].end());
+        layer.activation = network.networkConfig.layersConfig[l + 1].activation;
+
+        std::vector<float> values(input->data(), input->data() + input->getNumRows() * numInputs);
+        layer.input = calibrate(values);
+
+        // Symmetric quantization of the weights of each neuron (column)
+        const float *w = weights.data();
+        std::vector<float> weightScales(numOutputs, 0);
+        for (size_t i = 0; i < numInputs; ++i) {
+            for (size_t j = 0; j < numOutputs; ++j) {
+                weightScales[j] = std::max(weightScales[j], std::abs(w[i * numOutputs + j]));
+            }
+        }
+        for (auto &scale: weightScales) {
+            scale = scale > 0 ? scale / 127 : 1;
+        }
+
+        std::vector<int8_t> quantizedWeights(numInputs * numOutputs);
+        std::vector<int32_t> columnSums(numOutputs, 0);
+        for (size_t i = 0; i < numInputs; ++i) {
+            for (size_t j = 0; j < numOutputs; ++j) {
+                auto q = static_cast<int8_t>(std::lround(w[i * numOutputs + j] / weightScales[j]));
+                quantizedWeights[i * numOutputs + j] = q;
+                columnSums[j] += q;
+            }
+        }
+        Int8Gemm::packB(quantizedWeights.data(), numInputs, numOutputs, layer.weights);
+
+        for (size_t j = 0; j < numOutputs; ++j) {
+            layer.outputScales.push_back(layer.input.scale * weightScales[j]);
+            layer.zeroPointOffsets.push_back(layer.input.zeroPoint * columnSums[j]);
+        }
+        layers.push_back(std::move(layer));
+
+        // The inputs of the next layer are calibrated on the outputs of the float network
+        network.layerForward(*input, l, outputs[l % 2], nullptr);
+        input = &outputs[l % 2];
+    }
+}
+
+Matrix<float> QuantizedNetwork::predict(const Matrix<float> &data) const {
+    if (data.getNumCols() != layers[0].numInputs) {
+        throw WrongInputDataDimension();
+    }
+
+    size_t numRows = data.getNumRows();
+    size_t numOutputs = layers.back().numOutputs;
+    Matrix<float> result(numRows, numOutputs);
+    const float *input = data.data();
+    float *output = result.data();
+
+    size_t maxInputs = 0;
+    size_t maxOutputs = 0;
+    for (const auto &layer: layers) {
+        maxInputs = std::max(maxInputs, Int8Gemm::paddedK(layer.numInputs));
+        maxOutputs = std::max(maxOutputs, layer.numOutputs);
+    }
+
+#pragma omp parallel default(none) shared(numRows, numOutputs, input, output, maxInputs, maxOutputs, data)
+    {
+        Buffers_t buffers;
+        buffers.quantized[0].resize(ROW_BLOCK * maxInputs);
+        buffers.quantized[1].resize(ROW_BLOCK * maxInputs);
+        buffers.accumulators.resize(ROW_BLOCK * maxOutputs);
+        buffers.row.resize(maxOutputs);
+
+#pragma omp for schedule(static)
+        for (size_t first = 0; first < numRows; first += ROW_BLOCK) {
+            predictBlock(input + first * data.getNumCols(), std::min(ROW_BLOCK, numRows - first),
+                         output + first * numOutputs, buffers);
+        }
+    }
+
+    return result;
+}
+
+void QuantizedNetwork::predictBlock(const float *data, size_t numRows, float *output, Buffers_t &buffers) const {
+    size_t current = 0;
+    {
+        const auto &first = layers[0];
+        size_t stride = Int8Gemm::paddedK(first.numInputs);
+        for (size_t r = 0; r < numRows; ++r) {
+            quantizeRow(data + r * first.numInputs, first.numInputs, first.input,
+                        buffers.quantized[current].data() + r * stride);
+        }
+    }
+
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const auto &layer = layers[l];
+        int32_t *acc = buffers.accumulators.data();
+        Int8Gemm::gemm(numRows, layer.numOutputs, layer.numInputs, buffers.quantized[current].data(),
+                       layer.weights.data(), acc, layer.numOutputs);
+
+        if (l + 1 == layers.size()) {
+            for (size_t r = 0; r < numRows; ++r) {
+                dequantizeRow(layer, acc + r * layer.numOutputs, output + r * layer.numOutputs);
+            }
+            break;
+        }
+
+        // Requantize for the next layer
+        const auto &next = layers[l + 1];
+        size_t nextStride = Int8Gemm::paddedK(next.numInputs);
+        uint8_t *nextInput = buffers.quantized[1 - current].data();
+        for (size_t r = 0; r < numRows; ++r) {
+            dequantizeRow(layer, acc + r * layer.numOutputs, buffers.row.data());
+            quantizeRow(buffers.row.data(), next.numInputs, next.input, nextInput + r * nextStride);
+        }
+        current = 1 - current;
+    }
+}
+
+QuantizationParams_t QuantizedNetwork::calibrate(std::vector<float> &values) {
+    if (values.empty()) {
+        return {};
+    }
+
+    auto outliers = static_cast<size_t>(static_cast<float>(values.size()) * (1 - CALIBRATION_PERCENTILE));
+    std::nth_element(values.begin(), values.begin() + outliers, values.end());
+    float low = values[outliers];
+    std::nth_element(values.begin(), values.end() - 1 - outliers, values.end());
+    float high = values[values.size() - 1 - outliers];
+
+    // Zero has to be representable exactly (ReLU outputs, zero padding)
+    low = std::min(low, 0.f);
+    high = std::max(high, 0.f);
+    if (high == low) {
+        return {};
+    }
+
+    float scale = (high - low) / Int8Gemm::A_MAX;
+    return {.scale=scale, .zeroPoint=static_cast<int32_t>(std::lround(-low / scale))};
+}
+
+void QuantizedNetwork::quantizeRow(const float *x, size_t n, QuantizationParams_t params, uint8_t *q) {
+    float inverseScale = 1 / params.scale;
+    auto zeroPoint = static_cast<float>(params.zeroPoint);
+    auto maxValue = static_cast<float>(Int8Gemm::A_MAX);
+
+#pragma omp simd
+    for (size_t j = 0; j < n; ++j) {
+        float value = std::min(std::max(x[j] * inverseScale + zeroPoint, 0.f), maxValue);
+        q[j] = static_cast<uint8_t>(value + 0.5f);
+    }
+    std::fill(q + n, q + Int8Gemm::paddedK(n), 0);
+}
+
+void QuantizedNetwork::dequantizeRow(const QuantizedLayer_t &layer, const int32_t *acc, float *y) {
+    size_t n = layer.numOutputs;
+    const int32_t *offsets = layer.zeroPointOffsets.data();
+    const float *scales = layer.outputScales.data();
+    const float *biases = layer.biases.data();
+
+#pragma omp simd
+    for (size_t j = 0; j < n; ++j) {
+        y[j] = static_cast<float>(acc[j] - offsets[j]) * scales[j] + biases[j];
+    }
+
+    std::visit([y, n](const auto &function) {
+        using Function_t = std::decay_t<decltype(function)>;
+
+        if constexpr (Function_t::ELEMENTWISE) {
+#pragma omp simd
+            for (size_t j = 0; j < n; ++j) {
+                y[j] = Function_t::apply(y[j]);
+            }
+        } else {
+            VectorMath::softmax(y, n);
+        }
+    }, layer.activation);
+}
@@ -0,0 +1,115 @@
+#ifndef FEEDFORWARDNEURALNET_QUANTIZED_NETWORK_H
+#define FEEDFORWARDNEURALNET_QUANTIZED_NETWORK_H
+
+#include "network.hpp"
+#include "../data_structures/int8_gemm.hpp"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Affine quantization of a value: q = clamp(round(x / scale) + zeroPoint, 0, Int8Gemm::A_MAX)
+ */
+struct QuantizationParams_t {
+    float scale = 1;
+    int32_t zeroPoint = 0;
+};
+
+/**
+ * Layer of a quantized network: int8 weights (one scale per output neuron), quantized input,
+ * float bias and activation function.
+ */
+struct QuantizedLayer_t {
+    size_t numInputs = 0;
+    size_t numOutputs = 0;
+    QuantizationParams_t input;              // Quantization of the layer input
+    Int8Buffer_t weights;                    // Quantized weights packed by Int8Gemm::packB
+    std::vector<float> outputScales;         // input.scale * scale of the weights of the neuron
+    std::vector<int32_t> zeroPointOffsets;   // input.zeroPoint * sum of the quantized weights of the neuron
+    std::vector<float> biases;
+    Activation_t activation;
+};
+
+/**
+ * Post-training quantized copy of a trained network, for inference only.
+ *
+ * The weights are quantized symmetrically to [-127, 127] with a scale per output neuron. The inputs of the
+ * layers are quantized to [0, Int8Gemm::A_MAX] with a scale per layer, calibrated on a sample of the training
+ * data passed through the float network. The layers multiply in 8 bits and accumulate in 32 bits; the results
+ * are dequantized together with the bias and the activation function and requantized for the next layer.
+ * The output layer stays in float (SoftMax is applied to float rows).
+ */
+class QuantizedNetwork {
+    std::vector<QuantizedLayer_t> layers;
+
+    /**
+     * Per-thread buffers of predict
+     */
+    struct Buffers_t {
+        std::vector<uint8_t> quantized[2];  // Quantized inputs of the layers, used alternately
+        std::vector<int32_t> accumulators;  // 32 bit results of a layer
+        std::vector<float> row;             // Dequantized output row of a hidden layer
+    };
+
+public:
+    // Share of the calibration values below the quantization range limits (ignores rare outliers)
+    static constexpr float CALIBRATION_PERCENTILE = 0.9999f;
+    // Rows passed through all the layers at once, so that the intermediate results stay in cache
+    static constexpr size_t ROW_BLOCK = 64;
+
+    /**
+     * Quantizes a trained network.
+     * @param network         Trained network
+     * @param calibrationData Sample of the training data (a few hundred rows are enough)
+     */
+    QuantizedNetwork(const Network &network, const Matrix<float> &calibrationData);
+
+    /**
+     * Predicts the data labels
+     * @param data Data vectors
+     * @return Output activations per sample
+     */
+    Matrix<float> predict(const Matrix<float> &data) const;
+
+    /**
+     * @return Layers of the network (quantization parameters, packed weights, ...)
+     */
+    const std::vector<QuantizedLayer_t> &getLayers() const {
+        return layers;
+    }
+
+private:
+    /**
+     * Picks the quantization range of values (it always contains zero, so that zero is exact)
+     * @param values Calibration values (reordered)
+     * @return quantization parameters
+     */
+    static QuantizationParams_t calibrate(std::vector<float> &values);
+
+    /**
+     * Quantizes a row of a layer input
+     * @param x      Row of floats
+     * @param n      Number of elements of the row
+     * @param params Quantization parameters
+     * @param q      Quantized row (padded with zeros to Int8Gemm::paddedK(n))
+     */
+    static void quantizeRow(const float *x, size_t n, QuantizationParams_t params, uint8_t *q);
+
+    /**
+     * Dequantizes the 32 bit results of a layer, adds the bias and applies the activation function
+     * @param layer  Layer
+     * @param acc    Row of the 32 bit results
+     * @param y      Output row
+     */
+    static void dequantizeRow(const QuantizedLayer_t &layer, const int32_t *acc, float *y);
+
+    /**
+     * Passes a block of rows through all the layers
+     * @param data    First row of the block
+     * @param numRows Number of rows of the block (at most ROW_BLOCK)
+     * @param output  First output row of the block
+     * @param buffers Buffers of the thread
+     */
+    void predictBlock(const float *data, size_t numRows, float *output, Buffers_t &buffers) const;
+};
+
+#endif //FEEDFORWARDNEURALNET_QUANTIZED_NETWORK_H
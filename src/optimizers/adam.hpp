@@ -5,24 +5,39 @@
 #ifndef FEEDFORWARDNEURALNET_ADAM_H
 #define FEEDFORWARDNEURALNET_ADAM_H
 
-#include "../data_structures/matrix.hpp"
-#include "../network/config.hpp"
 #include "optimizer_template.hpp"
+#include <algorithm>
 #include <cmath>
-#include <math.h>
+#include <cstddef>
+#include <span>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
 
 class AdamOptimizer : public Optimizer {
 
     constexpr static float eps = 1e-7; // Small value to avoid dividing by zero
+    // Elements updated by a thread at once (multiple of the vector width)
+    constexpr static size_t BLOCK_SIZE = 16384;
+
+    /**
+     * Constants of a single update step
+     */
+    struct Step_t {
+        float beta1;
+        float beta2;
+        float stepSize;  // Learning rate per sample with the bias corrections folded in
+        float eps;       // Epsilon scaled by the second moment bias correction
+    };
+
     float beta1;
     float beta2;
     float beta1Power;
     float beta2Power;
     size_t t; // Current iteration
-    std::vector<Matrix<float>> mw;
-    std::vector<std::vector<float>> mb;
-    std::vector<Matrix<float>> vw;
-    std::vector<std::vector<float>> vb;
+    ParameterBuffer firstMoments;  // Same layout as the parameters
+    ParameterBuffer secondMoments;
 public:
     /**
      * Creates Adam optimizer with it|s parameters
@@ -33,72 +48,109 @@ public:
             : beta1(beta1), beta2(beta2), beta1Power(beta1), beta2Power(beta2), t(1) {}
 
     void init() override {
-        for (size_t i = 0; i < weights->size(); ++i) {
-            auto rows = (*weights)[i].getNumRows();
-            auto cols = (*weights)[i].getNumCols();
-            mw.push_back(Matrix<float>(rows, cols, 0));
-            vw.push_back(Matrix<float>(rows, cols, 0));
-            mb.push_back(std::vector<float>((*biases)[i].size(), 0));
-            vb.push_back(std::vector<float>((*biases)[i].size(), 0));
-        }
+        firstMoments = parameters->zerosLike();
+        secondMoments = parameters->zerosLike();
     }
 
-    void update(const std::vector<Matrix<float>> &weightDeltas, const std::vector<std::vector<float>> &deltaBiases,
-                size_t batchSize, float eta) override {
-
-        float batchEta = eta / static_cast<float>(batchSize);
-        float beta1Prime = 1 - beta1;
-        float beta2Prime = 1 - beta2;
-        float beta1PrimePower = 1 - beta1Power;
-        float beta2PrimePower = 1 - beta2Power;
-
-#pragma omp parallel default(none) shared(weightDeltas, deltaBiases, batchEta, beta1Prime, beta2Prime, beta1PrimePower, beta2PrimePower)
-        {
-#pragma omp for nowait
-            for (size_t layer = 0; layer < weights->size(); ++layer) {
-                auto &weightDelta = weightDeltas[layer];
-
-                for (size_t i = 0; i < (*weights)[layer].getNumRows(); ++i) {
-#pragma omp simd
-                    for (size_t j = 0; j < (*weights)[layer].getNumCols(); ++j) {
-                        mw[layer].setItem(i, j,
-                                          beta1 * mw[layer].getItem(i, j)
-                                          + beta1Prime * weightDelta.getItem(i, j));
-                        vw[layer].setItem(i, j,
-                                          beta2 * vw[layer].getItem(i, j)
-                                          + beta2Prime * powf(weightDelta.getItem(i, j), 2));
-
-                        auto mw_corr = mw[layer].getItem(i, j) / beta1PrimePower;
-                        auto vw_corr = vw[layer].getItem(i, j) / beta2PrimePower;
-
-                        (*weights)[layer].setItem(i, j,
-                                                  (*weights)[layer].getItem(i, j)
-                                                  - batchEta * (mw_corr / (sqrtf(vw_corr) + eps)));
-                    }
-                }
-
-                (*weights)[layer].transpose((*weightsTransposed)[layer]);
-            }
-
-#pragma omp for
-            for (size_t layer = 0; layer < weights->size(); ++layer) {
-#pragma omp simd
-                for (size_t j = 0; j < (*weights)[layer].getNumCols(); ++j) {
-                    mb[layer][j] = beta1 * mb[layer][j] + beta1Prime * deltaBiases[layer][j];
-                    vb[layer][j] = beta2 * vb[layer][j] + beta2Prime * powf(deltaBiases[layer][j], 2);
-
-                    auto mb_corr = mb[layer][j] / beta1PrimePower;
-                    auto vb_corr = vb[layer][j] / beta2PrimePower;
-
-                    (*biases)[layer][j] -= batchEta * (mb_corr / (sqrtf(vb_corr) + eps));
-                }
-            }
+    void update(const ParameterBuffer &gradients, size_t batchSize, float eta, float lambda) override {
+        // The bias corrections are folded into the step size and epsilon:
+        // m' / (sqrt(v') + eps) = m * sqrt(1 - beta2^t) / (1 - beta1^t) / (sqrt(v) + eps * sqrt(1 - beta2^t))
+        float biasCorrection2 = std::sqrt(1 - beta2Power);
+        Step_t step{.beta1=beta1, .beta2=beta2,
+                    .stepSize=eta / static_cast<float>(batchSize) * biasCorrection2 / (1 - beta1Power),
+                    .eps=eps * biasCorrection2};
+
+        float *w = parameters->data();
+        const float *g = gradients.data();
+        float *m = firstMoments.data();
+        float *v = secondMoments.data();
+        float decayCoeff = 1.f - lambda;
+        size_t numWeights = parameters->getWeightsSize();
+        size_t size = parameters->size();
+
+        // All the layers are a single buffer, split evenly across the threads.
+        // The weights come first and are decayed (AdamW), the biases behind them are not.
+#pragma omp parallel for num_threads(numThreads) schedule(static) default(none) \
+        shared(w, g, m, v, numWeights, size, step, decayCoeff)
+        for (size_t first = 0; first < size; first += BLOCK_SIZE) {
+            size_t end = std::min(first + BLOCK_SIZE, size);
+            size_t split = std::clamp(numWeights, first, end);
+            fusedUpdate(w + first, g + first, m + first, v + first, split - first, decayCoeff, step);
+            fusedUpdate(w + split, g + split, m + split, v + split, end - split, 1, step);
         }
 
         t += 1;
         beta1Power *= beta1;
         beta2Power *= beta2;
     }
+
+    const char *getName() const override {
+        return "adam";
+    }
+
+    std::vector<std::span<std::byte>> getState() override {
+        std::vector<std::span<std::byte>> state;
+        for (size_t i = 0; i < firstMoments.getNumLayers(); ++i) {
+            size_t numWeights = firstMoments.getNumRows(i) * firstMoments.getNumCols(i);
+            size_t numBiases = firstMoments.getNumCols(i);
+            state.push_back(std::as_writable_bytes(std::span(firstMoments.weights(i), numWeights)));
+            state.push_back(std::as_writable_bytes(std::span(secondMoments.weights(i), numWeights)));
+            state.push_back(std::as_writable_bytes(std::span(firstMoments.biases(i), numBiases)));
+            state.push_back(std::as_writable_bytes(std::span(secondMoments.biases(i), numBiases)));
+        }
+        state.push_back(std::as_writable_bytes(std::span(&beta1Power, 1)));
+        state.push_back(std::as_writable_bytes(std::span(&beta2Power, 1)));
+        state.push_back(std::as_writable_bytes(std::span(&t, 1)));
+        return state;
+    }
+
+private:
+    /**
+     * Updates the moments and the parameters in one pass:
+     * m = beta1 * m + (1 - beta1) * g, v = beta2 * v + (1 - beta2) * g^2,
+     * w = decayCoeff * w - stepSize * m / (sqrt(v) + eps)
+     * @param w - parameters
+     * @param g - gradients (summed over the batch)
+     * @param m - first moments
+     * @param v - second moments
+     * @param n - number of elements
+     * @param decayCoeff - weight decay coefficient (1 - lambda, 1 for none)
+     * @param step - constants of the step
+     */
+    static void fusedUpdate(float *w, const float *g, float *m, float *v, size_t n, float decayCoeff,
+                            const Step_t &step) {
+        float beta1Prime = 1 - step.beta1;
+        float beta2Prime = 1 - step.beta2;
+        size_t i = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+        __m256 beta1Vector = _mm256_set1_ps(step.beta1);
+        __m256 beta2Vector = _mm256_set1_ps(step.beta2);
+        __m256 beta1PrimeVector = _mm256_set1_ps(beta1Prime);
+        __m256 beta2PrimeVector = _mm256_set1_ps(beta2Prime);
+        __m256 stepSizeVector = _mm256_set1_ps(step.stepSize);
+        __m256 epsVector = _mm256_set1_ps(step.eps);
+        __m256 decayVector = _mm256_set1_ps(decayCoeff);
+
+        for (; i + 8 <= n; i += 8) {
+            __m256 grad = _mm256_loadu_ps(g + i);
+            __m256 m1 = _mm256_fmadd_ps(beta1Vector, _mm256_loadu_ps(m + i), _mm256_mul_ps(beta1PrimeVector, grad));
+            __m256 v1 = _mm256_fmadd_ps(beta2Vector, _mm256_loadu_ps(v + i),
+                                        _mm256_mul_ps(beta2PrimeVector, _mm256_mul_ps(grad, grad)));
+            __m256 denominator = _mm256_add_ps(_mm256_sqrt_ps(v1), epsVector);
+            __m256 w1 = _mm256_fnmadd_ps(stepSizeVector, _mm256_div_ps(m1, denominator),
+                                        _mm256_mul_ps(decayVector, _mm256_loadu_ps(w + i)));
+            _mm256_storeu_ps(m + i, m1);
+            _mm256_storeu_ps(v + i, v1);
+            _mm256_storeu_ps(w + i, w1);
+        }
+#endif
+#pragma omp simd
+        for (size_t j = i; j < n; ++j) {
+            m[j] = step.beta1 * m[j] + beta1Prime * g[j];
+            v[j] = step.beta2 * v[j] + beta2Prime * g[j] * g[j];
+            w[j] = decayCoeff * w[j] - step.stepSize * m[j] / (std::sqrt(v[j]) + step.eps);
+        }
+    }
 };
 
 #endif //FEEDFORWARDNEURALNET_ADAM_H
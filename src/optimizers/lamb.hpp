@@ -0,0 +1,130 @@
+#ifndef FEEDFORWARDNEURALNET_LAMB_H
+#define FEEDFORWARDNEURALNET_LAMB_H
+
+#include "optimizer_template.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+
+/**
+ * LAMB optimizer (layer-wise adaptive Adam) for large batch training. The update
+ * u = m' / (sqrt(v') + eps) + lambda * w of every weight matrix is scaled by the trust ratio ||w|| / ||u||,
+ * so each layer moves by the same fraction of its weights (eta) regardless of the batch size and of the scale
+ * of its gradients. Unlike in the other optimizers, the weight decay is part of the scaled update, so it is
+ * multiplied by the learning rate and the trust ratio. Biases get the plain Adam update. The moments are
+ * computed from the gradients averaged over the batch.
+ */
+class LambOptimizer : public Optimizer {
+
+    constexpr static float eps = 1e-6; // Small value to avoid dividing by zero
+    constexpr static float MAX_TRUST_RATIO = 10;
+
+    float beta1;
+    float beta2;
+    float beta1Power;
+    float beta2Power;
+    size_t t; // Current iteration
+    ParameterBuffer firstMoments;  // Same layout as the parameters
+    ParameterBuffer secondMoments;
+public:
+    /**
+     * Creates LAMB optimizer
+     * @param beta1 - exponential decay rate for the first moment estimates
+     * @param beta2 - exponential decay rate for the second-moment estimates
+     */
+    LambOptimizer(float beta1 = 0.9, float beta2 = 0.999)
+            : beta1(beta1), beta2(beta2), beta1Power(beta1), beta2Power(beta2), t(1) {}
+
+    void init() override {
+        firstMoments = parameters->zerosLike();
+        secondMoments = parameters->zerosLike();
+    }
+
+    void update(const ParameterBuffer &gradients, size_t batchSize, float eta, float lambda) override {
+        float gradientScale = 1.f / static_cast<float>(batchSize);
+        // The bias corrections are folded into the update scale and epsilon (see AdamOptimizer):
+        // m' / (sqrt(v') + eps) = correction * m / (sqrt(v) + eps * sqrt(1 - beta2^t))
+        float biasCorrection2 = std::sqrt(1 - beta2Power);
+        float correction = biasCorrection2 / (1 - beta1Power);
+        float scaledEps = eps * biasCorrection2;
+
+        for (size_t layer = 0; layer < parameters->getNumLayers(); ++layer) {
+            size_t numWeights = parameters->getNumRows(layer) * parameters->getNumCols(layer);
+            float *w = parameters->weights(layer);
+            const float *g = gradients.weights(layer);
+            float *m = firstMoments.weights(layer);
+            float *v = secondMoments.weights(layer);
+
+            // Updates the moments and measures the weights and the update of the layer
+            float weightNorm = 0;
+            float updateNorm = 0;
+#pragma omp parallel for simd num_threads(numThreads) schedule(static) reduction(+:weightNorm, updateNorm) \
+        default(none) shared(w, g, m, v, numWeights, gradientScale, correction, scaledEps, lambda)
+            for (size_t i = 0; i < numWeights; ++i) {
+                float gradient = gradientScale * g[i];
+                m[i] = beta1 * m[i] + (1 - beta1) * gradient;
+                v[i] = beta2 * v[i] + (1 - beta2) * gradient * gradient;
+                float u = correction * m[i] / (std::sqrt(v[i]) + scaledEps) + lambda * w[i];
+                weightNorm += w[i] * w[i];
+                updateNorm += u * u;
+            }
+
+            weightNorm = std::sqrt(weightNorm);
+            updateNorm = std::sqrt(updateNorm);
+            float trustRatio = weightNorm > 0 && updateNorm > 0
+                               ? std::min(weightNorm / updateNorm, MAX_TRUST_RATIO) : 1;
+            float stepSize = eta * trustRatio;
+
+#pragma omp parallel for simd num_threads(numThreads) schedule(static) default(none) \
+        shared(w, m, v, numWeights, correction, scaledEps, lambda, stepSize)
+            for (size_t i = 0; i < numWeights; ++i) {
+                w[i] -= stepSize * (correction * m[i] / (std::sqrt(v[i]) + scaledEps) + lambda * w[i]);
+            }
+        }
+
+        // Biases of all layers are behind the weights, updated by Adam in one pass
+        size_t numWeights = parameters->getWeightsSize();
+        size_t size = parameters->size();
+        float *w = parameters->data();
+        const float *g = gradients.data();
+        float *m = firstMoments.data();
+        float *v = secondMoments.data();
+        float stepSize = eta * correction;
+
+#pragma omp parallel for simd num_threads(numThreads) schedule(static) default(none) \
+        shared(w, g, m, v, numWeights, size, gradientScale, scaledEps, stepSize)
+        for (size_t i = numWeights; i < size; ++i) {
+            float gradient = gradientScale * g[i];
+            m[i] = beta1 * m[i] + (1 - beta1) * gradient;
+            v[i] = beta2 * v[i] + (1 - beta2) * gradient * gradient;
+            w[i] -= stepSize * m[i] / (std::sqrt(v[i]) + scaledEps);
+        }
+
+        t += 1;
+        beta1Power *= beta1;
+        beta2Power *= beta2;
+    }
+
+    const char *getName() const override {
+        return "lamb";
+    }
+
+    std::vector<std::span<std::byte>> getState() override {
+        std::vector<std::span<std::byte>> state;
+        for (size_t i = 0; i < firstMoments.getNumLayers(); ++i) {
+            size_t numWeights = firstMoments.getNumRows(i) * firstMoments.getNumCols(i);
+            size_t numBiases = firstMoments.getNumCols(i);
+            state.push_back(std::as_writable_bytes(std::span(firstMoments.weights(i), numWeights)));
+            state.push_back(std::as_writable_bytes(std::span(secondMoments.weights(i), numWeights)));
+            state.push_back(std::as_writable_bytes(std::span(firstMoments.biases(i), numBiases)));
+            state.push_back(std::as_writable_bytes(std::span(secondMoments.biases(i), numBiases)));
+        }
+        state.push_back(std::as_writable_bytes(std::span(&beta1Power, 1)));
+        state.push_back(std::as_writable_bytes(std::span(&beta2Power, 1)));
+        state.push_back(std::as_writable_bytes(std::span(&t, 1)));
+        return state;
+    }
+};
+
+#endif //FEEDFORWARDNEURALNET_LAMB_H
@@ -5,16 +5,20 @@
 #ifndef FEEDFORWARDNEURALNET_OPTIMIZER_TEMPLATE_H
 #define FEEDFORWARDNEURALNET_OPTIMIZER_TEMPLATE_H
 
-#include "../data_structures/matrix.hpp"
+#include "../data_structures/parameter_buffer.hpp"
+#include <cstddef>
+#include <omp.h>
+#include <span>
+#include <vector>
 
 /**
  * Class representing optimizer
  */
 class Optimizer {
 protected:
-    std::vector<Matrix<float>> *weights = nullptr;
-    std::vector<Matrix<float>> *weightsTransposed = nullptr;
-    std::vector<std::vector<float>> *biases = nullptr;
+    ParameterBuffer *parameters = nullptr;
+    // Threads the update runs on (the thread count of the network)
+    size_t numThreads = static_cast<size_t>(omp_get_max_threads());
 
 public:
     Optimizer() = default;
@@ -27,28 +31,45 @@ public:
     virtual void init() {}
 
     /**
-     * Sets weights and biases to optimizer
-     * @param weights - Network weights
-     * @param biases - Network biases
-     * @param weightsTransposed - Transposed weights
+     * Sets the parameters (weights and biases) the optimizer updates
+     * @param parameters - Network parameters
      */
-    void setMatrices(std::vector<Matrix<float>> &weights, std::vector<Matrix<float>> &weightsTransposed,
-                     std::vector<std::vector<float>> &biases) {
+    void setParameters(ParameterBuffer &parameters) {
+        this->parameters = &parameters;
+    }
 
-        this->weights = &weights;
-        this->weightsTransposed = &weightsTransposed;
-        this->biases = &biases;
+    /**
+     * Sets the number of threads the update runs on
+     * @param numThreads - Number of threads (the network passes its own thread count)
+     */
+    void setNumThreads(size_t numThreads) {
+        this->numThreads = numThreads;
     }
 
     /**
-     * Updates weights and biases using chosen optimization technique
-     * @param weightDeltas - Derivative of the loss function w.r.t. weights
+     * Updates weights and biases using chosen optimization technique. The decoupled weight decay is fused into
+     * the same pass: the weights (not the biases) are multiplied by 1 - lambda before the step is applied
+     * (LambOptimizer adds lambda * w to its layer-wise scaled update instead).
+     * @param gradients - Derivative of the loss function w.r.t. the parameters (same layout as the parameters)
      * @param batchSize - Data batch size
      * @param eta - Learning rate
+     * @param lambda - Weight decay rate (0 for none)
+     */
+    virtual void update(const ParameterBuffer &gradients, size_t batchSize, float eta, float lambda) = 0;
+
+    /**
+     * @return name of the optimizer, checkpoints restore the state only into an optimizer of the same name
      */
-    virtual void
-    update(const std::vector<Matrix<float>> &weightDeltas, const std::vector<std::vector<float>> &deltaBias,
-           size_t batchSize, float eta) = 0;
+    virtual const char *getName() const = 0;
+
+    /**
+     * Buffers of the optimizer state (moments, step counters, ...), saved into checkpoints and restored from them
+     * in the same order. Valid after init.
+     * @return state buffers
+     */
+    virtual std::vector<std::span<std::byte>> getState() {
+        return {};
+    }
 };
 
 #endif //FEEDFORWARDNEURALNET_OPTIMIZER_TEMPLATE_H
@@ -6,28 +6,109 @@
 #define FEEDFORWARDNEURALNET_SGD_H
 
 #include "optimizer_template.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <span>
 
 class SGDOptimizer : public Optimizer {
+    // Elements updated by a thread at once
+    constexpr static size_t BLOCK_SIZE = 16384;
+
+    /**
+     * Constants of a single update step
+     */
+    struct Step_t {
+        float gradientScale;  // 1 / batch size, the gradients are summed over the batch
+        float eta;
+        float momentum;
+    };
+
+    float momentum;
+    bool nesterov;
+    ParameterBuffer velocities;  // Same layout as the parameters, empty without momentum
 
 public:
-    SGDOptimizer() = default;
+    /**
+     * Creates SGD optimizer, with momentum v = momentum * v + g, w -= eta * v
+     * (w -= eta * (g + momentum * v) with Nesterov momentum), g being the gradient averaged over the batch
+     * @param momentum - decay of the velocity, 0 for plain SGD
+     * @param nesterov - use Nesterov momentum
+     */
+    explicit SGDOptimizer(float momentum = 0, bool nesterov = false) : momentum(momentum), nesterov(nesterov) {}
+
+    void init() override {
+        if (momentum != 0) {
+            velocities = parameters->zerosLike();
+        }
+    }
+
+    virtual void update(const ParameterBuffer &gradients, size_t batchSize, float eta, float lambda) override {
+        Step_t step{.gradientScale=1.f / static_cast<float>(batchSize), .eta=eta, .momentum=momentum};
+        float decayCoeff = 1.f - lambda;
+        float *w = parameters->data();
+        const float *g = gradients.data();
+        float *v = momentum != 0 ? velocities.data() : nullptr;
+        size_t numWeights = parameters->getWeightsSize();
+        size_t size = parameters->size();
 
-    virtual void update(const std::vector<Matrix<float>> &weightDeltas,
-                        const std::vector<std::vector<float>> &deltaBias,
-                        size_t batchSize, float eta) override {
+        // The weights are at the start of the parameters and are decayed, the biases behind them are not
+#pragma omp parallel for num_threads(numThreads) schedule(static) default(none) \
+        shared(w, g, v, numWeights, size, step, decayCoeff)
+        for (size_t first = 0; first < size; first += BLOCK_SIZE) {
+            size_t end = std::min(first + BLOCK_SIZE, size);
+            size_t split = std::clamp(numWeights, first, end);
+            fusedUpdate(w + first, g + first, v ? v + first : nullptr, split - first, decayCoeff, step);
+            fusedUpdate(w + split, g + split, v ? v + split : nullptr, end - split, 1, step);
+        }
+    };
 
-        float batchEta = eta / static_cast<float>(batchSize);
+    const char *getName() const override {
+        // The velocities are only saved with momentum, plain SGD has no state
+        return momentum != 0 ? "sgd_momentum" : "sgd";
+    }
 
-#pragma omp parallel for default(none) shared(weightDeltas, batchEta, deltaBias)
-        for (size_t layer = 0; layer < weights->size(); layer++) {
-            auto &weightDelta = weightDeltas[layer];
-            (*weights)[layer] -= weightDelta * batchEta;
+    std::vector<std::span<std::byte>> getState() override {
+        std::vector<std::span<std::byte>> state;
+        for (size_t i = 0; i < velocities.getNumLayers(); ++i) {
+            size_t numWeights = velocities.getNumRows(i) * velocities.getNumCols(i);
+            state.push_back(std::as_writable_bytes(std::span(velocities.weights(i), numWeights)));
+            state.push_back(std::as_writable_bytes(std::span(velocities.biases(i), velocities.getNumCols(i))));
+        }
+        return state;
+    }
 
-            for (size_t i = 0; i < (*biases)[layer].size(); i++) {
-                (*biases)[layer][i] -= batchEta * deltaBias[layer][i];
+private:
+    /**
+     * Updates the velocities and the parameters in one pass
+     * @param w - parameters
+     * @param g - gradients (summed over the batch)
+     * @param v - velocities, nullptr without momentum
+     * @param n - number of elements
+     * @param decayCoeff - weight decay coefficient (1 - lambda, 1 for none)
+     * @param step - constants of the step
+     */
+    void fusedUpdate(float *w, const float *g, float *v, size_t n, float decayCoeff, const Step_t &step) const {
+        float batchEta = step.eta * step.gradientScale;
+        if (v == nullptr) {
+#pragma omp simd
+            for (size_t i = 0; i < n; ++i) {
+                w[i] = decayCoeff * w[i] - batchEta * g[i];
+            }
+        } else if (!nesterov) {
+#pragma omp simd
+            for (size_t i = 0; i < n; ++i) {
+                v[i] = step.momentum * v[i] + step.gradientScale * g[i];
+                w[i] = decayCoeff * w[i] - step.eta * v[i];
+            }
+        } else {
+#pragma omp simd
+            for (size_t i = 0; i < n; ++i) {
+                float gradient = step.gradientScale * g[i];
+                v[i] = step.momentum * v[i] + gradient;
+                w[i] = decayCoeff * w[i] - step.eta * (gradient + step.momentum * v[i]);
             }
         }
-    };
+    }
 };
 
 #endif //FEEDFORWARDNEURALNET_SGD_H
@@ -5,44 +5,51 @@
 #ifndef FEEDFORWARDNEURALNET_LR_SHEDULER_H
 #define FEEDFORWARDNEURALNET_LR_SHEDULER_H
 
-#include <algorithm>
 #include <cstddef>
+#include <span>
+#include <vector>
 
 /**
- * Class representing LRScheduler
+ * Class representing a learning rate schedule. Network::fit sets the base learning rate (its eta), asks for
+ * the learning rate of every training step and reports the validation loss after every epoch.
+ * Schedules are evaluated in O(1) per step and compose by wrapping each other (see schedules.hpp).
  */
 class LRScheduler {
-    float currentEta;
-    float minEta;
-    float decayRate;
-    unsigned int stepsDecay;
-    unsigned int numSteps = 0;
+protected:
+    float eta = 1e-3;
+
 public:
-    /**
-     *
-     * @param eta        Initial eta
-     * @param minEta     Min learning rate at which the decay stops
-     * @param decayRate  LR change rate (scheduled eta might differ with each scheduler)
-     * @param stepsDecay LR decay occurs after we pass at least stepsDecay examples through the network
-     */
-    LRScheduler(float eta, float minEta, float decayRate, unsigned int stepsDecay)
-            : currentEta(eta), minEta(minEta), decayRate(decayRate), stepsDecay(stepsDecay) {}
+    LRScheduler() = default;
 
-    LRScheduler(float minEta, float decayRate, unsigned int stepsDecay)
-            : currentEta(1e-3), minEta(minEta), decayRate(decayRate), stepsDecay(stepsDecay) {}
+    virtual ~LRScheduler() = default;
 
     /**
-     * Sets eta
+     * Sets the base learning rate
      * @param eta - eta to set
      */
-    void setEta(float eta) { currentEta = eta; }
+    virtual void setEta(float eta) { this->eta = eta; }
 
     /**
-     * Exponential learning rate decay.
      * @param t Time unit (number of examples passed through the network)
-     * @return
+     * @return learning rate of the training step
+     */
+    virtual float getEta(size_t t) = 0;
+
+    /**
+     * Called after every epoch
+     * @param validationLoss - cross entropy on the validation set
+     */
+    virtual void epochEnd([[maybe_unused]] float validationLoss) {}
+
+    /**
+     * Buffers of the state that does not follow from the number of examples (e.g. the scale of a plateau
+     * schedule), saved into checkpoints and restored from them in the same order. Wrapping schedules include
+     * the state of the wrapped ones.
+     * @return state buffers
      */
-    float exponential(unsigned int t);
+    virtual std::vector<std::span<std::byte>> getState() {
+        return {};
+    }
 };
 
 
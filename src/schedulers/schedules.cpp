@@ -0,0 +1,157 @@
+#include "schedules.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <utility>
+
+namespace {
+    /**
+     * @return cosine interpolation between from (progress 0) and to (progress 1)
+     */
+    float cosineInterpolation(float from, float to, float progress) {
+        return to + (from - to) * 0.5f * (1 + std::cos(std::numbers::pi_v<float> * progress));
+    }
+
+    /**
+     * @return part of the schedule of numSamples examples that has passed after t examples, at most 1
+     */
+    float scheduleProgress(size_t t, size_t numSamples) {
+        return numSamples == 0 ? 1 : std::min(static_cast<float>(t) / static_cast<float>(numSamples), 1.f);
+    }
+}
+
+float ConstantScheduler::getEta(size_t) {
+    return eta;
+}
+
+ExponentialScheduler::ExponentialScheduler(float eta, float minEta, float decayRate, size_t stepsDecay)
+        : minEta(minEta), decayRate(decayRate), stepsDecay(stepsDecay) {
+    this->eta = eta;
+}
+
+ExponentialScheduler::ExponentialScheduler(float minEta, float decayRate, size_t stepsDecay)
+        : minEta(minEta), decayRate(decayRate), stepsDecay(stepsDecay) {}
+
+float ExponentialScheduler::getEta(size_t t) {
+    // Computed directly from t, so the training resuming from a checkpoint continues the schedule
+    size_t numDecays = t / stepsDecay;
+    if (numDecays == 0) {
+        return eta;
+    }
+    return std::max(eta * std::pow(decayRate, static_cast<float>(numDecays)), minEta);
+}
+
+CosineScheduler::CosineScheduler(size_t numSamples, float minEta) : numSamples(numSamples), minEta(minEta) {}
+
+float CosineScheduler::getEta(size_t t) {
+    return cosineInterpolation(eta, minEta, scheduleProgress(t, numSamples));
+}
+
+LinearScheduler::LinearScheduler(size_t numSamples, float endEta) : numSamples(numSamples), endEta(endEta) {}
+
+float LinearScheduler::getEta(size_t t) {
+    return eta + (endEta - eta) * scheduleProgress(t, numSamples);
+}
+
+OneCycleScheduler::OneCycleScheduler(size_t numSamples, float peakFraction, float initialDivisor,
+                                     float finalDivisor)
+        : numSamples(numSamples), peakFraction(peakFraction), initialDivisor(initialDivisor),
+          finalDivisor(finalDivisor) {}
+
+float OneCycleScheduler::getEta(size_t t) {
+    auto peakSamples = static_cast<size_t>(peakFraction * static_cast<float>(numSamples));
+    if (t < peakSamples) {
+        return cosineInterpolation(eta / initialDivisor, eta, scheduleProgress(t, peakSamples));
+    }
+    return cosineInterpolation(eta, eta / finalDivisor, scheduleProgress(t - peakSamples, numSamples - peakSamples));
+}
+
+WarmupScheduler::WarmupScheduler(LRScheduler &schedule, size_t warmupSamples)
+        : schedule(schedule), warmupSamples(warmupSamples) {}
+
+void WarmupScheduler::setEta(float eta) {
+    LRScheduler::setEta(eta);
+    schedule.setEta(eta);
+}
+
+float WarmupScheduler::getEta(size_t t) {
+    float scheduled = schedule.getEta(t);
+    if (t >= warmupSamples) {
+        return scheduled;
+    }
+    return static_cast<float>(t + 1) / static_cast<float>(warmupSamples) * scheduled;
+}
+
+void WarmupScheduler::epochEnd(float validationLoss) {
+    schedule.epochEnd(validationLoss);
+}
+
+std::vector<std::span<std::byte>> WarmupScheduler::getState() {
+    return schedule.getState();
+}
+
+PlateauScheduler::PlateauScheduler(LRScheduler &schedule, float factor, size_t patience, float threshold)
+        : schedule(schedule), factor(factor), patience(patience), threshold(threshold) {}
+
+void PlateauScheduler::setEta(float eta) {
+    LRScheduler::setEta(eta);
+    schedule.setEta(eta);
+}
+
+float PlateauScheduler::getEta(size_t t) {
+    return scale * schedule.getEta(t);
+}
+
+void PlateauScheduler::epochEnd(float validationLoss) {
+    schedule.epochEnd(validationLoss);
+
+    if (validationLoss < bestLoss * (1 - threshold)) {
+        bestLoss = validationLoss;
+        numBadEpochs = 0;
+    } else if (++numBadEpochs > patience) {
+        scale *= factor;
+        numBadEpochs = 0;
+    }
+}
+
+std::vector<std::span<std::byte>> PlateauScheduler::getState() {
+    auto state = schedule.getState();
+    state.push_back(std::as_writable_bytes(std::span(&scale, 1)));
+    state.push_back(std::as_writable_bytes(std::span(&bestLoss, 1)));
+    state.push_back(std::as_writable_bytes(std::span(&numBadEpochs, 1)));
+    return state;
+}
+
+SequentialScheduler::SequentialScheduler(std::vector<Phase_t> phases) : phases(std::move(phases)) {}
+
+void SequentialScheduler::setEta(float eta) {
+    LRScheduler::setEta(eta);
+    for (auto &phase: phases) {
+        phase.schedule->setEta(eta);
+    }
+}
+
+float SequentialScheduler::getEta(size_t t) {
+    // There are only a few phases, scanned from the first one
+    size_t start = 0;
+    currentPhase = 0;
+    while (currentPhase + 1 < phases.size() && t - start >= phases[currentPhase].numSamples) {
+        start += phases[currentPhase].numSamples;
+        ++currentPhase;
+    }
+    return phases[currentPhase].schedule->getEta(t - start);
+}
+
+void SequentialScheduler::epochEnd(float validationLoss) {
+    phases[currentPhase].schedule->epochEnd(validationLoss);
+}
+
+std::vector<std::span<std::byte>> SequentialScheduler::getState() {
+    // The current phase follows from the number of examples, only the state of the phases is saved
+    std::vector<std::span<std::byte>> state;
+    for (auto &phase: phases) {
+        auto phaseState = phase.schedule->getState();
+        state.insert(state.end(), phaseState.begin(), phaseState.end());
+    }
+    return state;
+}
@@ -0,0 +1,178 @@
+#ifndef FEEDFORWARDNEURALNET_SCHEDULES_H
+#define FEEDFORWARDNEURALNET_SCHEDULES_H
+
+#include "lr_sheduler.hpp"
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+/**
+ * Constant learning rate
+ */
+class ConstantScheduler : public LRScheduler {
+public:
+    float getEta(size_t t) override;
+};
+
+/**
+ * Exponential step decay: the learning rate is multiplied by decayRate after every stepsDecay examples,
+ * down to minEta
+ */
+class ExponentialScheduler : public LRScheduler {
+    float minEta;
+    float decayRate;
+    size_t stepsDecay;
+public:
+    /**
+     * @param eta        Initial eta
+     * @param minEta     Min learning rate at which the decay stops
+     * @param decayRate  LR change rate
+     * @param stepsDecay LR decay occurs after we pass at least stepsDecay examples through the network
+     */
+    ExponentialScheduler(float eta, float minEta, float decayRate, size_t stepsDecay);
+
+    ExponentialScheduler(float minEta, float decayRate, size_t stepsDecay);
+
+    float getEta(size_t t) override;
+};
+
+/**
+ * Cosine annealing from eta to minEta over numSamples examples (minEta after them)
+ */
+class CosineScheduler : public LRScheduler {
+    size_t numSamples;
+    float minEta;
+public:
+    /**
+     * @param numSamples - length of the schedule (number of examples)
+     * @param minEta - final learning rate
+     */
+    explicit CosineScheduler(size_t numSamples, float minEta = 0);
+
+    float getEta(size_t t) override;
+};
+
+/**
+ * Linear change from eta to endEta over numSamples examples (endEta after them)
+ */
+class LinearScheduler : public LRScheduler {
+    size_t numSamples;
+    float endEta;
+public:
+    /**
+     * @param numSamples - length of the schedule (number of examples)
+     * @param endEta - final learning rate
+     */
+    explicit LinearScheduler(size_t numSamples, float endEta = 0);
+
+    float getEta(size_t t) override;
+};
+
+/**
+ * One-cycle schedule: cosine increase from eta / initialDivisor to eta (the peak) over the first peakFraction
+ * of numSamples examples, then cosine annealing down to eta / finalDivisor
+ */
+class OneCycleScheduler : public LRScheduler {
+    size_t numSamples;
+    float peakFraction;
+    float initialDivisor;
+    float finalDivisor;
+public:
+    /**
+     * @param numSamples - length of the schedule (number of examples)
+     * @param peakFraction - part of the schedule before the peak
+     * @param initialDivisor - ratio of the peak and the initial learning rate
+     * @param finalDivisor - ratio of the peak and the final learning rate
+     */
+    explicit OneCycleScheduler(size_t numSamples, float peakFraction = 0.3, float initialDivisor = 25,
+                               float finalDivisor = 1e4);
+
+    float getEta(size_t t) override;
+};
+
+/**
+ * Linear warmup: scales the learning rate of another schedule from 0 to 1 over the first warmupSamples examples
+ * (needed by large batches, whose first steps diverge at the full learning rate)
+ */
+class WarmupScheduler : public LRScheduler {
+    LRScheduler &schedule;
+    size_t warmupSamples;
+public:
+    /**
+     * @param schedule - schedule being warmed up
+     * @param warmupSamples - number of examples passed through the network during the warmup
+     */
+    WarmupScheduler(LRScheduler &schedule, size_t warmupSamples);
+
+    void setEta(float eta) override;
+
+    float getEta(size_t t) override;
+
+    void epochEnd(float validationLoss) override;
+
+    std::vector<std::span<std::byte>> getState() override;
+};
+
+/**
+ * Scales the learning rate of another schedule by factor whenever the validation loss has not improved
+ * for more than patience epochs
+ */
+class PlateauScheduler : public LRScheduler {
+    LRScheduler &schedule;
+    float factor;
+    size_t patience;
+    float threshold;
+    float scale = 1;
+    float bestLoss = std::numeric_limits<float>::max();
+    size_t numBadEpochs = 0;
+public:
+    /**
+     * @param schedule - scaled schedule (ConstantScheduler for the plain plateau decay)
+     * @param factor - scale applied on a plateau
+     * @param patience - number of epochs without improvement tolerated
+     * @param threshold - relative decrease of the loss counted as an improvement
+     */
+    explicit PlateauScheduler(LRScheduler &schedule, float factor = 0.5, size_t patience = 1, float threshold = 1e-3);
+
+    void setEta(float eta) override;
+
+    float getEta(size_t t) override;
+
+    void epochEnd(float validationLoss) override;
+
+    std::vector<std::span<std::byte>> getState() override;
+};
+
+/**
+ * Runs schedules one after another, each for its number of examples (the last one until the end).
+ * A schedule starts counting its examples from 0 when it is reached.
+ */
+class SequentialScheduler : public LRScheduler {
+public:
+    /**
+     * A schedule and the number of examples it runs for
+     */
+    struct Phase_t {
+        LRScheduler *schedule;
+        size_t numSamples;
+    };
+
+    /**
+     * @param phases - schedules in the order they run (at least one)
+     */
+    explicit SequentialScheduler(std::vector<Phase_t> phases);
+
+    void setEta(float eta) override;
+
+    float getEta(size_t t) override;
+
+    void epochEnd(float validationLoss) override;
+
+    std::vector<std::span<std::byte>> getState() override;
+
+private:
+    std::vector<Phase_t> phases;
+    size_t currentPhase = 0;
+};
+
+#endif //FEEDFORWARDNEURALNET_SCHEDULES_H
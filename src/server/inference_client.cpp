@@ -0,0 +1,31 @@
+#include "inference_client.hpp"
+#include <unistd.h>
+
+InferenceClient::InferenceClient(const ServerAddress_t &address) : fd(Protocol::connect(address)) {}
+
+InferenceClient::~InferenceClient() {
+    close(fd);
+}
+
+void InferenceClient::predict(const float *features, size_t numFeatures, std::vector<float> &outputs) {
+    RequestHeader_t request{.magic=Protocol::MAGIC, .numFeatures=static_cast<uint32_t>(numFeatures)};
+    ResponseHeader_t response{};
+
+    if (!Protocol::writeFully(fd, &request, sizeof(request)) ||
+        !Protocol::writeFully(fd, features, numFeatures * sizeof(float)) ||
+        !Protocol::readFully(fd, &response, sizeof(response))) {
+        throw ServerError();
+    }
+
+    if (response.status == ResponseStatus::WrongDimension) {
+        throw WrongRequestDimension();
+    }
+    if (response.status != ResponseStatus::Ok) {
+        throw ServerError();
+    }
+
+    outputs.resize(response.numOutputs);
+    if (!Protocol::readFully(fd, outputs.data(), outputs.size() * sizeof(float))) {
+        throw ServerError();
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef FEEDFORWARDNEURALNET_INFERENCE_CLIENT_H
+#define FEEDFORWARDNEURALNET_INFERENCE_CLIENT_H
+
+#include "protocol.hpp"
+#include <vector>
+
+class WrongRequestDimension : public std::exception {
+};
+
+/**
+ * Blocking client of an InferenceServer, one connection per client (use a client per thread)
+ */
+class InferenceClient {
+    int fd;
+
+public:
+    /**
+     * Connects to a server, throws ServerError if it fails
+     * @param address - address of the server
+     */
+    explicit InferenceClient(const ServerAddress_t &address);
+
+    InferenceClient(const InferenceClient &) = delete;
+
+    InferenceClient &operator=(const InferenceClient &) = delete;
+
+    ~InferenceClient();
+
+    /**
+     * Sends a feature vector and waits for the output activations. Throws WrongRequestDimension if the network
+     * has a different number of inputs and ServerError if the connection fails or the server is stopping.
+     * @param features - feature vector
+     * @param numFeatures - number of features
+     * @param outputs - output activations (resized)
+     */
+    void predict(const float *features, size_t numFeatures, std::vector<float> &outputs);
+};
+
+#endif //FEEDFORWARDNEURALNET_INFERENCE_CLIENT_H
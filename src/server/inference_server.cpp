@@ -0,0 +1,193 @@
+#include "inference_server.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+
+InferenceServer::InferenceServer(const InferenceModel &model, const ServerConfig_t &config)
+        : model(model), config(config), numInputs(model.getNumInputs()), numOutputs(model.getNumOutputs()) {
+    this->config.maxBatchSize = std::max<size_t>(this->config.maxBatchSize, 1);
+    this->config.numWorkers = std::max<size_t>(this->config.numWorkers, 1);
+
+    listenFd = Protocol::listen(config.address);
+    if (config.address.socketPath.empty()) {
+        port = Protocol::localPort(listenFd);
+    }
+
+    listener = std::thread(&InferenceServer::acceptConnections, this);
+    for (size_t i = 0; i < this->config.numWorkers; ++i) {
+        workers.emplace_back(&InferenceServer::runWorker, this);
+    }
+}
+
+InferenceServer::~InferenceServer() {
+    stop();
+}
+
+void InferenceServer::stop() {
+    if (!listener.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    // Wakes up accept (or the listener backing off)
+    connectionClosed.notify_all();
+    shutdown(listenFd, SHUT_RDWR);
+    listener.join();
+    close(listenFd);
+    if (!config.address.socketPath.empty()) {
+        unlink(config.address.socketPath.c_str());
+    }
+
+    // The workers answer the queued requests before they exit
+    requestQueued.notify_all();
+    for (auto &worker: workers) {
+        worker.join();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (int fd: connections) {
+        shutdown(fd, SHUT_RDWR);
+    }
+    connectionClosed.wait(lock, [this]() { return connections.empty(); });
+}
+
+void InferenceServer::acceptConnections() {
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            int error = errno;
+            std::unique_lock<std::mutex> lock(mutex);
+            if (stopping) {
+                return;
+            }
+            if (error != EINTR && error != ECONNABORTED) {
+                // Out of descriptors or memory (EMFILE, ENFILE, ENOBUFS, ENOMEM), the pending connection stays
+                // in the backlog. Retrying right away would spin, wait until a connection closes, the server
+                // stops or ACCEPT_BACKOFF passes.
+                connectionClosed.wait_for(lock, ACCEPT_BACKOFF);
+            }
+            continue;
+        }
+        Protocol::setNoDelay(fd);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                close(fd);
+                return;
+            }
+            connections.insert(fd);
+        }
+        std::thread(&InferenceServer::serveConnection, this, fd).detach();
+    }
+}
+
+void InferenceServer::serveConnection(int fd) {
+    std::vector<float> features(numInputs);
+    std::vector<float> outputs(numOutputs);
+    RequestHeader_t request{};
+
+    while (Protocol::readFully(fd, &request, sizeof(request)) && request.magic == Protocol::MAGIC) {
+        ResponseHeader_t response{.status=ResponseStatus::Ok, .numOutputs=static_cast<uint32_t>(numOutputs)};
+
+        if (request.numFeatures != numInputs) {
+            // Skip the features, the connection stays usable
+            size_t remaining = request.numFeatures;
+            bool ok = true;
+            while (ok && remaining > 0) {
+                size_t chunk = std::min(remaining, numInputs);
+                ok = Protocol::readFully(fd, features.data(), chunk * sizeof(float));
+                remaining -= chunk;
+            }
+            if (!ok) {
+                break;
+            }
+            response = {.status=ResponseStatus::WrongDimension, .numOutputs=0};
+        } else {
+            if (!Protocol::readFully(fd, features.data(), numInputs * sizeof(float))) {
+                break;
+            }
+
+            PendingRequest_t pending{.features=features.data(), .outputs=outputs.data(),
+                                     .arrival=std::chrono::steady_clock::now()};
+            std::unique_lock<std::mutex> lock(mutex);
+            if (stopping) {
+                response = {.status=ResponseStatus::Stopping, .numOutputs=0};
+            } else {
+                queue.push_back(&pending);
+                if (queue.size() == 1 || batchReady()) {
+                    requestQueued.notify_all();
+                }
+                requestsDone.wait(lock, [&pending]() { return pending.done; });
+            }
+        }
+
+        if (!Protocol::writeFully(fd, &response, sizeof(response)) ||
+            !Protocol::writeFully(fd, outputs.data(), response.numOutputs * sizeof(float))) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    connections.erase(fd);
+    close(fd);
+    // A closed connection may complete a batch (see batchReady)
+    requestQueued.notify_all();
+    connectionClosed.notify_all();
+}
+
+bool InferenceServer::batchReady() const {
+    // Each connection has at most one request in flight, so once all of them are queued no other request can come
+    return queue.size() >= std::min(config.maxBatchSize, connections.size());
+}
+
+void InferenceServer::runWorker() {
+    auto scratch = model.createScratch();
+    std::vector<float> batch(config.maxBatchSize * numInputs);
+    std::vector<float> outputs(config.maxBatchSize * numOutputs);
+    std::vector<PendingRequest_t *> taken;
+    taken.reserve(config.maxBatchSize);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        requestQueued.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+
+        if (!stopping) {
+            auto deadline = queue.front()->arrival + std::chrono::microseconds(config.maxDelayUs);
+            requestQueued.wait_until(lock, deadline, [this]() { return stopping || batchReady(); });
+            // Another worker may have taken the requests meanwhile
+            if (queue.empty()) {
+                continue;
+            }
+        }
+
+        size_t rows = std::min(config.maxBatchSize, queue.size());
+        taken.assign(queue.begin(), queue.begin() + static_cast<long>(rows));
+        queue.erase(queue.begin(), queue.begin() + static_cast<long>(rows));
+        lock.unlock();
+
+        for (size_t i = 0; i < rows; ++i) {
+            std::copy(taken[i]->features, taken[i]->features + numInputs, batch.data() + i * numInputs);
+        }
+        model.predict(batch.data(), rows, outputs.data(), scratch);
+        for (size_t i = 0; i < rows; ++i) {
+            std::copy(outputs.data() + i * numOutputs, outputs.data() + (i + 1) * numOutputs, taken[i]->outputs);
+        }
+
+        lock.lock();
+        for (auto *pending: taken) {
+            pending->done = true;
+        }
+        numRequests += rows;
+        ++numBatches;
+        requestsDone.notify_all();
+    }
+}
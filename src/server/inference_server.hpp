@@ -0,0 +1,136 @@
+#ifndef FEEDFORWARDNEURALNET_INFERENCE_SERVER_H
+#define FEEDFORWARDNEURALNET_INFERENCE_SERVER_H
+
+#include "protocol.hpp"
+#include "../network/inference_model.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+/**
+ * Configuration of an inference server
+ */
+struct ServerConfig_t {
+    ServerAddress_t address;
+    size_t maxBatchSize = 64;   // Requests predicted together at most
+    long maxDelayUs = 1000;     // How long the oldest queued request may wait for the batch to fill up
+    size_t numWorkers = 1;      // Threads running the predictions
+};
+
+/**
+ * Counters of a running server
+ */
+struct ServerStats_t {
+    size_t numRequests = 0;
+    size_t numBatches = 0;
+};
+
+/**
+ * Serves the predictions of a model over a local socket (see Protocol), batching concurrent requests.
+ *
+ * Every connection is read by its own thread, which queues the received feature vectors and waits for their
+ * results. A worker takes the queued requests once maxBatchSize of them are waiting (or every open connection
+ * has a request queued, so no more can come) or once the oldest one has waited maxDelayUs, predicts them as
+ * one batch and wakes up the connections. The workers share one model, each predicts with its own scratch.
+ */
+class InferenceServer {
+    // Time the listener waits before accepting again when the process runs out of descriptors or memory
+    static constexpr std::chrono::milliseconds ACCEPT_BACKOFF{50};
+
+    /**
+     * Request queued by a connection thread, which owns the buffers and waits until done is set
+     */
+    struct PendingRequest_t {
+        const float *features;
+        float *outputs;
+        std::chrono::steady_clock::time_point arrival;
+        bool done = false;
+    };
+
+    const InferenceModel &model;
+    ServerConfig_t config;
+    size_t numInputs;
+    size_t numOutputs;
+
+    int listenFd = -1;
+    uint16_t port = 0;
+
+    std::mutex mutex;
+    std::deque<PendingRequest_t *> queue;
+    std::condition_variable requestQueued;
+    std::condition_variable requestsDone;
+    std::condition_variable connectionClosed;
+    std::set<int> connections;  // Open connections, shut down by stop
+    bool stopping = false;
+
+    std::atomic<size_t> numRequests = 0;
+    std::atomic<size_t> numBatches = 0;
+
+    std::thread listener;
+    std::vector<std::thread> workers;
+
+public:
+    /**
+     * Starts listening and the worker threads. Throws ServerError if the address cannot be listened on.
+     * @param model - model to serve (must outlive the server)
+     * @param config - configuration of the server
+     */
+    InferenceServer(const InferenceModel &model, const ServerConfig_t &config);
+
+    InferenceServer(const InferenceServer &) = delete;
+
+    InferenceServer &operator=(const InferenceServer &) = delete;
+
+    /**
+     * Stops the server
+     */
+    ~InferenceServer();
+
+    /**
+     * Stops accepting connections, answers the queued requests, closes the connections and joins the threads
+     */
+    void stop();
+
+    /**
+     * @return TCP port the server listens on (picked by the system if the configured port is 0)
+     */
+    uint16_t getPort() const {
+        return port;
+    }
+
+    /**
+     * @return number of requests answered and batches predicted so far
+     */
+    ServerStats_t getStats() const {
+        return {.numRequests=numRequests.load(), .numBatches=numBatches.load()};
+    }
+
+private:
+    /**
+     * Accepts the connections, each gets a detached thread running serveConnection
+     */
+    void acceptConnections();
+
+    /**
+     * Reads the requests of a connection and answers them
+     * @param fd - connection
+     */
+    void serveConnection(int fd);
+
+    /**
+     * Takes batches of queued requests and predicts them
+     */
+    void runWorker();
+
+    /**
+     * @return true if the queued requests make a full batch (called with the mutex locked)
+     */
+    bool batchReady() const;
+};
+
+#endif //FEEDFORWARDNEURALNET_INFERENCE_SERVER_H
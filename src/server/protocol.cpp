@@ -0,0 +1,132 @@
+#include "protocol.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    constexpr int LISTEN_BACKLOG = 128;
+
+    /**
+     * Fills a sockaddr for the address
+     * @return size of the filled structure
+     */
+    socklen_t fillAddress(const ServerAddress_t &address, sockaddr_storage &storage) {
+        std::memset(&storage, 0, sizeof(storage));
+
+        if (!address.socketPath.empty()) {
+            auto &unixAddress = reinterpret_cast<sockaddr_un &>(storage);
+            if (address.socketPath.size() >= sizeof(unixAddress.sun_path)) {
+                throw ServerError();
+            }
+            unixAddress.sun_family = AF_UNIX;
+            std::strcpy(unixAddress.sun_path, address.socketPath.c_str());
+            return sizeof(sockaddr_un);
+        }
+
+        auto &inetAddress = reinterpret_cast<sockaddr_in &>(storage);
+        inetAddress.sin_family = AF_INET;
+        inetAddress.sin_port = htons(address.port);
+        inetAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return sizeof(sockaddr_in);
+    }
+}
+
+ServerAddress_t ServerAddress_t::parse(const std::string &address) {
+    if (!address.empty() && std::all_of(address.begin(), address.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return {.socketPath={}, .port=static_cast<uint16_t>(std::stoul(address))};
+    }
+    return {.socketPath=address, .port=0};
+}
+
+int Protocol::listen(const ServerAddress_t &address) {
+    sockaddr_storage storage{};
+    socklen_t size = fillAddress(address, storage);
+
+    int fd = socket(storage.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw ServerError();
+    }
+
+    if (address.socketPath.empty()) {
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    } else {
+        unlink(address.socketPath.c_str());
+    }
+
+    if (bind(fd, reinterpret_cast<sockaddr *>(&storage), size) != 0 || ::listen(fd, LISTEN_BACKLOG) != 0) {
+        close(fd);
+        throw ServerError();
+    }
+    return fd;
+}
+
+uint16_t Protocol::localPort(int fd) {
+    sockaddr_in address{};
+    socklen_t size = sizeof(address);
+    if (getsockname(fd, reinterpret_cast<sockaddr *>(&address), &size) != 0 || address.sin_family != AF_INET) {
+        return 0;
+    }
+    return ntohs(address.sin_port);
+}
+
+int Protocol::connect(const ServerAddress_t &address) {
+    sockaddr_storage storage{};
+    socklen_t size = fillAddress(address, storage);
+
+    int fd = socket(storage.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw ServerError();
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&storage), size) != 0) {
+        close(fd);
+        throw ServerError();
+    }
+
+    setNoDelay(fd);
+    return fd;
+}
+
+bool Protocol::readFully(int fd, void *buffer, size_t size) {
+    auto *position = static_cast<char *>(buffer);
+    while (size > 0) {
+        ssize_t received = recv(fd, position, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        position += received;
+        size -= received;
+    }
+    return true;
+}
+
+bool Protocol::writeFully(int fd, const void *buffer, size_t size) {
+    const auto *position = static_cast<const char *>(buffer);
+    while (size > 0) {
+        // MSG_NOSIGNAL: a closed peer is reported by the return value instead of SIGPIPE
+        ssize_t sent = send(fd, position, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        position += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+void Protocol::setNoDelay(int fd) {
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+}
@@ -0,0 +1,100 @@
+#ifndef FEEDFORWARDNEURALNET_PROTOCOL_H
+#define FEEDFORWARDNEURALNET_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <string>
+
+class ServerError : public std::exception {
+};
+
+/**
+ * Address of an inference server: a Unix domain socket if socketPath is set, TCP on localhost otherwise
+ */
+struct ServerAddress_t {
+    std::string socketPath;
+    uint16_t port = 0;
+
+    /**
+     * @param address - port number or path of a Unix domain socket
+     * @return parsed address
+     */
+    static ServerAddress_t parse(const std::string &address);
+};
+
+/**
+ * Status of a response
+ */
+enum class ResponseStatus : uint32_t {
+    Ok = 0,
+    WrongDimension = 1,   // The number of features does not match the inputs of the network
+    Stopping = 2,         // The server is shutting down
+};
+
+/**
+ * Request: the header followed by numFeatures floats
+ */
+struct RequestHeader_t {
+    uint32_t magic;
+    uint32_t numFeatures;
+};
+
+/**
+ * Response: the header followed by numOutputs floats (none unless the status is Ok)
+ */
+struct ResponseHeader_t {
+    ResponseStatus status;
+    uint32_t numOutputs;
+};
+
+/**
+ * Wire protocol of the inference server. A connection carries any number of requests, each answered by
+ * a response before the next one is read. The values are in the byte order of the machine (the server
+ * only listens on local addresses).
+ */
+class Protocol {
+public:
+    static constexpr uint32_t MAGIC = 0x4e4e4646;  // "FFNN"
+
+    /**
+     * Creates a socket listening on the address (removes a stale Unix domain socket file first)
+     * @param address - address to listen on, port 0 picks a free port
+     * @return file descriptor of the socket
+     */
+    static int listen(const ServerAddress_t &address);
+
+    /**
+     * @param fd - listening TCP socket
+     * @return port the socket listens on
+     */
+    static uint16_t localPort(int fd);
+
+    /**
+     * Connects to a server
+     * @param address - address of the server
+     * @return file descriptor of the connection
+     */
+    static int connect(const ServerAddress_t &address);
+
+    /**
+     * Reads exactly size bytes
+     * @return false if the connection was closed or failed
+     */
+    static bool readFully(int fd, void *buffer, size_t size);
+
+    /**
+     * Writes exactly size bytes
+     * @return false if the connection was closed or failed
+     */
+    static bool writeFully(int fd, const void *buffer, size_t size);
+
+    /**
+     * Disables Nagle's algorithm on TCP connections (no-op for Unix domain sockets), so that small
+     * requests and responses are sent right away
+     * @param fd - connection
+     */
+    static void setNoDelay(int fd);
+};
+
+#endif //FEEDFORWARDNEURALNET_PROTOCOL_H
@@ -6,7 +6,9 @@
 #define FEEDFORWARDNEURALNET_CROSSENTROPY_H
 
 #include "../data_structures/matrix.hpp"
+#include "../utils/vector_math.hpp"
 #include <math.h>
+#include <span>
 
 /**
  * Class containing cross-entropy function and its derivative
@@ -20,16 +22,18 @@ public:
      * @param expected - expected labels
      * @return cross-entropy
      */
-    auto static crossentropy(const Matrix<float> &predicted, const std::vector<unsigned int> &expected) {
-        float crossEntropyRes = 0;
+    auto static crossentropy(const Matrix<float> &predicted, std::span<const unsigned int> expected) {
+        // Sum of log(1 - p + c) over the whole matrix, the expected classes are corrected to log(p + c) afterwards.
+        // The term removed by the correction must be computed exactly like in the sum (1 - p + c is rounded
+        // differently than fma(p, -1, 1 + c), which is off by ~0.2 for p close to 1).
+        const float *probabilities = predicted.data();
+        float crossEntropyRes = -VectorMath::sumLog(probabilities, predicted.getNumRows() * predicted.getNumCols(),
+                                                    -1, 1 + zeroCorrection);
 
         for (size_t i = 0; i < predicted.getNumRows(); i++) {
-            for (size_t j = 0; j < predicted.getNumCols(); j++) {
-                float expectedValue = expected[i] == j ? 1.f : 0.f;
-                float calculatedValue = predicted.getItem(i, j);
-                crossEntropyRes -= expectedValue * logf(calculatedValue + zeroCorrection) +
-                                   (1 - expectedValue) * logf(1 - calculatedValue + zeroCorrection);
-            }
+            const float *expectedProbability = probabilities + i * predicted.getNumCols() + expected[i];
+            crossEntropyRes -= VectorMath::log(*expectedProbability + zeroCorrection) -
+                               VectorMath::sumLog(expectedProbability, 1, -1, 1 + zeroCorrection);
         }
         return crossEntropyRes / static_cast<float>(expected.size());
     }
@@ -42,15 +46,26 @@ public:
      * @param labels
      * @return
      */
-    auto static costDelta(const Matrix<float> &lastLayerActivationResults, const std::vector<unsigned int> &labels) {
-        auto delta = lastLayerActivationResults;
+    auto static costDelta(const Matrix<float> &lastLayerActivationResults, std::span<const unsigned int> labels) {
+        Matrix<float> delta;
+        costDelta(lastLayerActivationResults, labels, delta);
+        return delta;
+    }
+
+    /**
+     * Calculates the derivative CE with SoftMax act. fn in the last layer into an existing matrix.
+     * @param lastLayerActivationResults - output of the network
+     * @param labels - expected labels
+     * @param delta - matrix the derivative is stored to (its storage is reused)
+     */
+    void static costDelta(const Matrix<float> &lastLayerActivationResults, std::span<const unsigned int> labels,
+                          Matrix<float> &delta) {
+        delta = lastLayerActivationResults;
 
         for (size_t i = 0; i < delta.getNumRows(); ++i) {
             auto j = static_cast<size_t>(labels[i]);
             delta.setItem(i, j, delta.getItem(i, j) - 1);
         }
-
-        return delta;
     }
 };
 
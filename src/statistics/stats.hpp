@@ -27,8 +27,15 @@ public:
      * @param expected - expected labels
      * @return stats as a map
      */
-    static Stats_t getStats(const Matrix<float> &predicted, const std::vector<unsigned int> &expected) {
-        float accuracy = AccuracyFunction::accuracy(argmax(predicted), expected);
+    static Stats_t getStats(const Matrix<float> &predicted, std::span<const unsigned int> expected) {
+        // Same as AccuracyFunction::accuracy(argmax(predicted), expected), without allocating the classes
+        float correctPredictions = 0;
+        for (size_t i = 0; i < predicted.getNumRows(); i++) {
+            if (argmaxRow(predicted, i) == expected[i]) {
+                correctPredictions++;
+            }
+        }
+        float accuracy = correctPredictions / static_cast<float>(predicted.getNumRows()) * 100;
         float crossentropy = CrossentropyFunction::crossentropy(predicted, expected);
         return {.accuracy=accuracy, .crossEntropy=crossentropy};
     }
@@ -93,16 +100,28 @@ public:
     static std::vector<unsigned int> argmax(const Matrix<float> &matrix) {
         auto classes = std::vector<unsigned int>(matrix.getNumRows());
         for (size_t i = 0; i < matrix.getNumRows(); i++) {
-            float currentMax = 0;
-            for (size_t j = 0; j < matrix.getNumCols(); j++) {
-                if (matrix.getItem(i, j) > currentMax) {
-                    currentMax = matrix.getItem(i, j);
-                    classes[i] = j;
-                }
-            }
+            classes[i] = argmaxRow(matrix, i);
         }
         return classes;
     }
+
+    /**
+     * Function calculating argmax of a single row in the matrix
+     * @param matrix - matrix to compute argmax on
+     * @param row - row index
+     * @return - class
+     */
+    static unsigned int argmaxRow(const Matrix<float> &matrix, size_t row) {
+        unsigned int res = 0;
+        float currentMax = 0;
+        for (size_t j = 0; j < matrix.getNumCols(); j++) {
+            if (matrix.getItem(row, j) > currentMax) {
+                currentMax = matrix.getItem(row, j);
+                res = j;
+            }
+        }
+        return res;
+    }
 };
 
 #endif //FEEDFORWARDNEURALNET_STATS_H
@@ -0,0 +1,47 @@
+#include "../csv/csv_reader.hpp"
+#include "../data_manager/tensor_file.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+/**
+ * Converts a CSV dataset into a tensor file (see TensorFile), which is then loaded without parsing.
+ *
+ * Usage: CsvToBinary <input.csv> <output> <numCols> [float|uint32] [normalize]
+ *  - float (default) for data vectors, uint32 for labels
+ *  - normalize divides every row by its maximum (the way the network inputs are normalized)
+ *
+ * e.g. CsvToBinary data/fashion_mnist_train_vectors.csv data/fashion_mnist_train_vectors.bin 784 float normalize
+ *      CsvToBinary data/fashion_mnist_train_labels.csv data/fashion_mnist_train_labels.bin 1 uint32
+ */
+int main(int argc, char **argv) {
+    if (argc < 4 || argc > 6) {
+        std::cerr << "Usage: " << argv[0] << " <input.csv> <output> <numCols> [float|uint32] [normalize]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const char *inputPath = argv[1];
+    const char *outputPath = argv[2];
+    int numCols = std::stoi(argv[3]);
+    std::string type = argc > 4 ? argv[4] : "float";
+    bool normalize = argc > 5 && std::strcmp(argv[5], "normalize") == 0;
+
+    if (type == "float") {
+        CsvReader<float> reader(inputPath, numCols);
+        if (normalize) {
+            reader.normalize();
+        }
+        TensorFile::write(outputPath, reader.getDataMatrix());
+    } else if (type == "uint32") {
+        CsvReader<uint32_t> reader(inputPath, numCols);
+        TensorFile::write(outputPath, reader.getDataMatrix());
+    } else {
+        std::cerr << "Unknown element type " << type << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
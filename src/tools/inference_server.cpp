@@ -0,0 +1,70 @@
+#include "../network/checkpoint.hpp"
+#include "../server/inference_server.hpp"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+/**
+ * Serves the predictions of a saved network (see Checkpoint) until SIGINT or SIGTERM.
+ *
+ * Usage: InferenceServer <checkpoint> <socketPath|port> [maxBatchSize] [maxDelayUs] [numWorkers]
+ *  - a number is a TCP port on the loopback, anything else the path of a Unix socket
+ *
+ * e.g. InferenceServer fashion.ckpt /tmp/ffnn.sock 64 1000 1
+ */
+int main(int argc, char **argv) {
+    if (argc < 3 || argc > 6) {
+        std::cerr << "Usage: " << argv[0] << " <checkpoint> <socketPath|port> [maxBatchSize] [maxDelayUs] [numWorkers]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ServerConfig_t serverConfig;
+    serverConfig.address = ServerAddress_t::parse(argv[2]);
+    if (argc > 3) {
+        serverConfig.maxBatchSize = std::stoul(argv[3]);
+    }
+    if (argc > 4) {
+        serverConfig.maxDelayUs = std::stol(argv[4]);
+    }
+    if (argc > 5) {
+        serverConfig.numWorkers = std::stoul(argv[5]);
+    }
+
+    // The signals are blocked before any thread starts, so only sigwait receives them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try {
+        auto model = InferenceModel::fromCheckpoint(argv[1]);
+
+        InferenceServer server(model, serverConfig);
+        std::cout << "Serving " << model.getNumInputs() << " -> " << model.getNumOutputs() << " on "
+                  << (serverConfig.address.socketPath.empty() ? "port " + std::to_string(server.getPort())
+                                                              : serverConfig.address.socketPath)
+                  << std::endl;
+
+        int signal = 0;
+        sigwait(&signals, &signal);
+        server.stop();
+
+        auto stats = server.getStats();
+        std::cout << "Answered " << stats.numRequests << " requests in " << stats.numBatches << " batches"
+                  << std::endl;
+    } catch (const CheckpointError &) {
+        std::cerr << "Cannot read checkpoint " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    } catch (const FileMappingError &) {
+        std::cerr << "Cannot read checkpoint " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    } catch (const ServerError &) {
+        std::cerr << "Cannot listen on " << argv[2] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+#include "../server/inference_client.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Closed-loop load against an InferenceServer: every client thread sends a random feature vector, waits for
+ * the answer and sends the next one. Prints the throughput and the latency percentiles for each number of
+ * concurrent clients.
+ *
+ * Usage: LoadGenerator <socketPath|port> <numFeatures> [seconds] [concurrency,...]
+ *
+ * e.g. LoadGenerator /tmp/ffnn.sock 784 5 1,4,16,64
+ */
+
+/**
+ * Runs the clients for the given time
+ * @return latencies of all answered requests in microseconds
+ */
+static std::vector<double> runClients(const ServerAddress_t &address, size_t numFeatures, size_t concurrency,
+                                      double seconds) {
+    std::vector<std::vector<double>> latencies(concurrency);
+    std::vector<std::thread> clients;
+    std::atomic<bool> failed = false;
+    std::atomic<bool> wrongDimension = false;
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+
+    for (size_t c = 0; c < concurrency; ++c) {
+        clients.emplace_back([&, c]() {
+            std::mt19937 generator(static_cast<unsigned>(c));
+            std::uniform_real_distribution<float> distribution(0, 1);
+            std::vector<float> features(numFeatures);
+            std::vector<float> outputs;
+
+            try {
+                InferenceClient client(address);
+                while (std::chrono::steady_clock::now() < end) {
+                    std::generate(features.begin(), features.end(), [&]() { return distribution(generator); });
+                    auto start = std::chrono::steady_clock::now();
+                    client.predict(features.data(), numFeatures, outputs);
+                    latencies[c].push_back(std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - start).count());
+                }
+            } catch (const WrongRequestDimension &) {
+                wrongDimension = true;
+            } catch (const ServerError &) {
+                failed = true;
+            }
+        });
+    }
+    for (auto &client: clients) {
+        client.join();
+    }
+    if (wrongDimension) {
+        throw WrongRequestDimension();
+    }
+    if (failed) {
+        throw ServerError();
+    }
+
+    std::vector<double> all;
+    for (const auto &clientLatencies: latencies) {
+        all.insert(all.end(), clientLatencies.begin(), clientLatencies.end());
+    }
+    std::sort(all.begin(), all.end());
+    return all;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3 || argc > 5) {
+        std::cerr << "Usage: " << argv[0] << " <socketPath|port> <numFeatures> [seconds] [concurrency,...]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ServerAddress_t address = ServerAddress_t::parse(argv[1]);
+    size_t numFeatures = std::stoul(argv[2]);
+    double seconds = argc > 3 ? std::stod(argv[3]) : 5;
+    std::vector<size_t> concurrencies;
+    std::stringstream list(argc > 4 ? argv[4] : "1,4,16,64");
+    for (std::string item; std::getline(list, item, ',');) {
+        concurrencies.push_back(std::stoul(item));
+    }
+
+    std::cout << std::left << std::setw(8) << "clients" << std::setw(14) << "requests/s" << std::setw(10) << "p50 us"
+              << std::setw(10) << "p95 us" << std::setw(10) << "p99 us" << "max us" << std::endl;
+
+    for (size_t concurrency: concurrencies) {
+        std::vector<double> latencies;
+        try {
+            latencies = runClients(address, numFeatures, concurrency, seconds);
+        } catch (const WrongRequestDimension &) {
+            std::cerr << "The network does not have " << numFeatures << " inputs" << std::endl;
+            return EXIT_FAILURE;
+        } catch (const ServerError &) {
+            std::cerr << "Requests to " << argv[1] << " failed" << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (latencies.empty()) {
+            continue;
+        }
+
+        auto percentile = [&latencies](size_t p) { return latencies[(latencies.size() - 1) * p / 100]; };
+        std::cout << std::fixed << std::setprecision(1) << std::setw(8) << concurrency << std::setw(14)
+                  << static_cast<double>(latencies.size()) / seconds << std::setw(10) << percentile(50)
+                  << std::setw(10) << percentile(95) << std::setw(10) << percentile(99) << latencies.back()
+                  << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
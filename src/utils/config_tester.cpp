@@ -75,7 +75,7 @@ void ConfigTester::testConfigs(std::vector<Configuration> &configurations, size_
 
             AdamOptimizer adam;
             Network network(config, &adam);
-            LRScheduler sched(minEta, decayRate, stepsDecay);
+            ExponentialScheduler sched(minEta, decayRate, stepsDecay);
 
             auto startTime = std::chrono::high_resolution_clock::now();
             network.fit(data, maxEpochs, batchSize, eta, lambda, verbose, &sched, earlyStopping, timeMsLimit);
@@ -122,7 +122,7 @@ ConfigTester::runParallelConfigTest(std::vector<Configuration> &configurations,
             AdamOptimizer adam;
             Network network(config, &adam);
 
-            LRScheduler sched(minEta, decayRate, stepsDecay);
+            ExponentialScheduler sched(minEta, decayRate, stepsDecay);
             auto startTime = std::chrono::high_resolution_clock::now();
             network.fit(data, maxEpochs, batchSize, eta, lambda, verboseLevel,
                         &sched, earlyStopping, timeMsLimit);
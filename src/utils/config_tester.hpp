@@ -7,6 +7,7 @@
 
 #include "../network/config.hpp"
 #include "../network/network.hpp"
+#include "../schedulers/schedules.hpp"
 #include "../activation_functions/functions_enum.hpp"
 #include "../csv/csv_reader.hpp"
 #include "../data_manager/data_manager.hpp"
@@ -0,0 +1,31 @@
+#include "mapped_file.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        throw FileMappingError();
+    }
+
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+        close(fd);
+        throw FileMappingError();
+    }
+    size = fileStat.st_size;
+
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the file is closed
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw FileMappingError();
+    }
+    address = mapped;
+}
+
+MappedFile::~MappedFile() {
+    munmap(const_cast<void *>(address), size);
+}
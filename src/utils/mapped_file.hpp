@@ -0,0 +1,39 @@
+#ifndef FEEDFORWARDNEURALNET_MAPPED_FILE_H
+#define FEEDFORWARDNEURALNET_MAPPED_FILE_H
+
+#include <cstddef>
+#include <exception>
+
+class FileMappingError : public std::exception {
+};
+
+/**
+ * A file mapped into memory (read-only), unmapped when destroyed
+ */
+class MappedFile {
+    const void *address = nullptr;
+    size_t size = 0;
+
+public:
+    /**
+     * Maps the whole file into memory.
+     * @param path - path of the file
+     */
+    explicit MappedFile(const char *path);
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile();
+
+    const void *data() const {
+        return address;
+    }
+
+    size_t getSize() const {
+        return size;
+    }
+};
+
+#endif //FEEDFORWARDNEURALNET_MAPPED_FILE_H
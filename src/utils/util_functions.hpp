@@ -7,6 +7,7 @@
 
 #include "../statistics/stats.hpp"
 #include <iostream>
+#include <tuple>
 
 /**
  * Calculates minimum, maximum and average of values in given vector
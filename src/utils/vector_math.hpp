@@ -0,0 +1,413 @@
+#ifndef FEEDFORWARDNEURALNET_VECTOR_MATH_H
+#define FEEDFORWARDNEURALNET_VECTOR_MATH_H
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// With AVX-512 the compiler vectorizes the scalar versions to wider vectors than the AVX2 kernels
+#if defined(__AVX2__) && defined(__FMA__) && !defined(__AVX512F__)
+#include <immintrin.h>
+#define FFNN_VECTOR_MATH_AVX2
+#endif
+
+/**
+ * Polynomial exp and log (Cephes expf/logf approximations) that vectorize, used by the activation
+ * and loss functions instead of libm.
+ *
+ * The scalar versions are branch-free, so they vectorize inside omp simd loops (floor and the clamping
+ * need -fno-trapping-math, implied by the -Ofast the project builds with). The array versions use
+ * AVX2 + FMA kernels when the compiler targets AVX2 (masked loads for the remainders), otherwise omp simd
+ * loops over the scalar versions (AVX-512 vectors when targeting it, plain scalar code without SIMD).
+ *
+ * Error (checked by MathAccuracyCheck against libm in double precision):
+ *  - exp: at most 2 ULP for results in the normal range, 0 below the denormal range, inf above FLT_MAX
+ *  - log: at most 2 ULP for normal positive inputs, -inf for zero (and negative) inputs
+ */
+class VectorMath {
+    // exp(x) = 2^n * exp(r), where n = round(x / ln 2) and r = x - n * ln 2 (ln 2 split in two parts)
+    static constexpr float EXP_MIN = -104.f;  // exp(-104) underflows even as a denormal
+    static constexpr float EXP_MAX = 89.f;    // exp(89) overflows
+    static constexpr float LOG2E = 1.44269504088896341f;
+    static constexpr float LN2_HI = 0.693359375f;
+    static constexpr float LN2_LO = -2.12194440e-4f;
+    static constexpr float EXP_P0 = 1.9875691500e-4f;
+    static constexpr float EXP_P1 = 1.3981999507e-3f;
+    static constexpr float EXP_P2 = 8.3334519073e-3f;
+    static constexpr float EXP_P3 = 4.1665795894e-2f;
+    static constexpr float EXP_P4 = 1.6666665459e-1f;
+    static constexpr float EXP_P5 = 5.0000001201e-1f;
+
+    // log(x) = e * ln 2 + log(1 + m), where x = 2^e * (1 + m) and 1 + m in [sqrt(0.5), sqrt(2))
+    static constexpr float SQRT_HALF = 0.707106781186547524f;
+    static constexpr float LOG_P0 = 7.0376836292e-2f;
+    static constexpr float LOG_P1 = -1.1514610310e-1f;
+    static constexpr float LOG_P2 = 1.1676998740e-1f;
+    static constexpr float LOG_P3 = -1.2420140846e-1f;
+    static constexpr float LOG_P4 = 1.4249322787e-1f;
+    static constexpr float LOG_P5 = -1.6668057665e-1f;
+    static constexpr float LOG_P6 = 2.0000714765e-1f;
+    static constexpr float LOG_P7 = -2.4999993993e-1f;
+    static constexpr float LOG_P8 = 3.3333331174e-1f;
+
+public:
+    /**
+     * @param x - exponent
+     * @return e^x
+     */
+    static float exp(float x) {
+        x = std::min(std::max(x, EXP_MIN), EXP_MAX);
+        float n = std::floor(x * LOG2E + 0.5f);
+        // x - n * LN2_HI is exact only if it is done first. Fused, the steps cannot be reordered by -ffast-math.
+        float r = fusedMultiplyAdd(-n, LN2_HI, x);
+        r = fusedMultiplyAdd(-n, LN2_LO, r);
+
+        float p = EXP_P0;
+        p = p * r + EXP_P1;
+        p = p * r + EXP_P2;
+        p = p * r + EXP_P3;
+        p = p * r + EXP_P4;
+        p = p * r + EXP_P5;
+        float y = p * (r * r) + r + 1;
+
+        // 2^n is applied in two halves, so that neither of them leaves the normal range. The first one is
+        // added to the exponent bits, so that -ffast-math cannot reassociate the two multiplications.
+        auto exponent = static_cast<int32_t>(n);
+        int32_t half = exponent >> 1;
+        y = std::bit_cast<float>(std::bit_cast<int32_t>(y) + (half << 23));
+        return y * std::bit_cast<float>((exponent - half + 127) << 23);
+    }
+
+    /**
+     * @param x - positive number
+     * @return natural logarithm of x
+     */
+    static float log(float x) {
+        auto bits = std::bit_cast<int32_t>(x);
+        auto e = static_cast<float>((bits >> 23) - 126);
+        // Mantissa in [0.5, 1)
+        float m = std::bit_cast<float>((bits & 0x007fffff) | 0x3f000000);
+
+        bool small = m < SQRT_HALF;
+        e = small ? e - 1 : e;
+        m = (small ? m + m : m) - 1;
+
+        float z = m * m;
+        float p = LOG_P0;
+        p = p * m + LOG_P1;
+        p = p * m + LOG_P2;
+        p = p * m + LOG_P3;
+        p = p * m + LOG_P4;
+        p = p * m + LOG_P5;
+        p = p * m + LOG_P6;
+        p = p * m + LOG_P7;
+        p = p * m + LOG_P8;
+
+        // e * LN2_HI must be added last (fused, so that -ffast-math cannot reorder it)
+        float y = fusedMultiplyAdd(e, LN2_LO, p * m * z - 0.5f * z);
+        y = fusedMultiplyAdd(e, LN2_HI, m + y);
+        return x > 0 ? y : -std::numeric_limits<float>::infinity();
+    }
+
+#ifdef FFNN_VECTOR_MATH_AVX2
+    /**
+     * @param x - exponents
+     * @return e^x of each lane
+     */
+    static __m256 exp(__m256 x) {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP_MIN)), _mm256_set1_ps(EXP_MAX));
+        __m256 n = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(LOG2E), _mm256_set1_ps(0.5f)));
+        __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2_HI), x);
+        r = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2_LO), r);
+
+        __m256 p = _mm256_set1_ps(EXP_P0);
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_P1));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_P2));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_P3));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_P4));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_P5));
+        __m256 y = _mm256_fmadd_ps(p, _mm256_mul_ps(r, r), _mm256_add_ps(r, _mm256_set1_ps(1)));
+
+        __m256i exponent = _mm256_cvtps_epi32(n);
+        __m256i half = _mm256_srai_epi32(exponent, 1);
+        y = _mm256_castsi256_ps(_mm256_add_epi32(_mm256_castps_si256(y), _mm256_slli_epi32(half, 23)));
+        __m256i rest = _mm256_add_epi32(_mm256_sub_epi32(exponent, half), _mm256_set1_epi32(127));
+        return _mm256_mul_ps(y, _mm256_castsi256_ps(_mm256_slli_epi32(rest, 23)));
+    }
+
+    /**
+     * @param x - positive numbers
+     * @return natural logarithm of each lane
+     */
+    static __m256 log(__m256 x) {
+        __m256i bits = _mm256_castps_si256(x);
+        __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+        __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                                                       _mm256_set1_epi32(0x3f000000)));
+
+        __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(SQRT_HALF), _CMP_LT_OQ);
+        e = _mm256_sub_ps(e, _mm256_and_ps(small, _mm256_set1_ps(1)));
+        m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), _mm256_set1_ps(1));
+
+        __m256 z = _mm256_mul_ps(m, m);
+        __m256 p = _mm256_set1_ps(LOG_P0);
+        p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P1));
+        p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P2));
+        p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P3));
+        p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P4));
+        p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P5));
+        p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P6));
+        p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P7));
+        p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P8));
+
+        __m256 y = _mm256_mul_ps(_mm256_mul_ps(p, m), z);
+        y = _mm256_fmadd_ps(e, _mm256_set1_ps(LN2_LO), y);
+        y = _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, y);
+        y = _mm256_fmadd_ps(e, _mm256_set1_ps(LN2_HI), _mm256_add_ps(m, y));
+
+        __m256 positive = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ);
+        return _mm256_blendv_ps(_mm256_set1_ps(-std::numeric_limits<float>::infinity()), y, positive);
+    }
+#endif
+
+    /**
+     * Computes y[i] = e^x[i] (x and y may be the same array)
+     * @param x - input array
+     * @param y - output array
+     * @param n - number of elements
+     */
+    static void exp(const float *x, float *y, size_t n) {
+#ifdef FFNN_VECTOR_MATH_AVX2
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(y + i, exp(_mm256_loadu_ps(x + i)));
+        }
+        if (i < n) {
+            __m256i mask = tailMask(n - i);
+            _mm256_maskstore_ps(y + i, mask, exp(_mm256_maskload_ps(x + i, mask)));
+        }
+#else
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = exp(x[i]);
+        }
+#endif
+    }
+
+    /**
+     * Computes y[i] = log(x[i]) (x and y may be the same array)
+     * @param x - input array
+     * @param y - output array
+     * @param n - number of elements
+     */
+    static void log(const float *x, float *y, size_t n) {
+#ifdef FFNN_VECTOR_MATH_AVX2
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(y + i, log(_mm256_loadu_ps(x + i)));
+        }
+        if (i < n) {
+            __m256i mask = tailMask(n - i);
+            _mm256_maskstore_ps(y + i, mask, log(_mm256_maskload_ps(x + i, mask)));
+        }
+#else
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = log(x[i]);
+        }
+#endif
+    }
+
+    /**
+     * @param x - input array
+     * @param n - number of elements
+     * @param scale - multiplier of the elements
+     * @param offset - added to the scaled elements
+     * @return sum of log(scale * x[i] + offset)
+     */
+    static float sumLog(const float *x, size_t n, float scale, float offset) {
+#ifdef FFNN_VECTOR_MATH_AVX2
+        __m256 scale8 = _mm256_set1_ps(scale);
+        __m256 offset8 = _mm256_set1_ps(offset);
+        __m256 sum8 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            sum8 = _mm256_add_ps(sum8, log(_mm256_fmadd_ps(_mm256_loadu_ps(x + i), scale8, offset8)));
+        }
+        if (i < n) {
+            __m256i mask = tailMask(n - i);
+            __m256 value = _mm256_fmadd_ps(_mm256_maskload_ps(x + i, mask), scale8, offset8);
+            // log(1) = 0 in the unused lanes
+            value = _mm256_blendv_ps(_mm256_set1_ps(1), value, _mm256_castsi256_ps(mask));
+            sum8 = _mm256_add_ps(sum8, log(value));
+        }
+        return horizontalSum(sum8);
+#else
+        float sum = 0;
+#pragma omp simd reduction(+:sum)
+        for (size_t i = 0; i < n; ++i) {
+            sum += log(scale * x[i] + offset);
+        }
+        return sum;
+#endif
+    }
+
+    /**
+     * Replaces the row by its SoftMax, e^(x[i] - max) / sum_j e^(x[j] - max), in a single call while
+     * the row stays in cache (max, exp + sum and normalization).
+     * @param row - row to transform
+     * @param n - number of elements
+     */
+    static void softmax(float *row, size_t n) {
+        if (n == 0) {
+            return;
+        }
+
+#ifdef FFNN_VECTOR_MATH_AVX2
+        size_t numFull = n / 8 * 8;
+        __m256i mask = tailMask(n - numFull);
+
+        __m256 max8 = _mm256_set1_ps(row[0]);
+        for (size_t i = 0; i < numFull; i += 8) {
+            max8 = _mm256_max_ps(max8, _mm256_loadu_ps(row + i));
+        }
+        if (numFull < n) {
+            __m256 value = _mm256_maskload_ps(row + numFull, mask);
+            max8 = _mm256_max_ps(max8, _mm256_blendv_ps(max8, value, _mm256_castsi256_ps(mask)));
+        }
+        max8 = _mm256_set1_ps(horizontalMax(max8));
+
+        __m256 sum8 = _mm256_setzero_ps();
+        for (size_t i = 0; i < numFull; i += 8) {
+            __m256 value = exp(_mm256_sub_ps(_mm256_loadu_ps(row + i), max8));
+            _mm256_storeu_ps(row + i, value);
+            sum8 = _mm256_add_ps(sum8, value);
+        }
+        if (numFull < n) {
+            __m256 value = exp(_mm256_sub_ps(_mm256_maskload_ps(row + numFull, mask), max8));
+            value = _mm256_and_ps(value, _mm256_castsi256_ps(mask));
+            _mm256_maskstore_ps(row + numFull, mask, value);
+            sum8 = _mm256_add_ps(sum8, value);
+        }
+
+        __m256 inverseSum = _mm256_set1_ps(1 / horizontalSum(sum8));
+        for (size_t i = 0; i < numFull; i += 8) {
+            _mm256_storeu_ps(row + i, _mm256_mul_ps(_mm256_loadu_ps(row + i), inverseSum));
+        }
+        if (numFull < n) {
+            __m256 value = _mm256_maskload_ps(row + numFull, mask);
+            _mm256_maskstore_ps(row + numFull, mask, _mm256_mul_ps(value, inverseSum));
+        }
+#else
+        float max = row[0];
+#pragma omp simd reduction(max:max)
+        for (size_t i = 1; i < n; ++i) {
+            max = std::max(max, row[i]);
+        }
+
+        float sum = 0;
+#pragma omp simd reduction(+:sum)
+        for (size_t i = 0; i < n; ++i) {
+            row[i] = exp(row[i] - max);
+            sum += row[i];
+        }
+
+        float inverseSum = 1 / sum;
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i) {
+            row[i] *= inverseSum;
+        }
+#endif
+    }
+
+    /**
+     * Replaces every row of a row-major matrix by its SoftMax. Rows narrower than a vector are processed
+     * in blocks, so that exp runs over whole vectors instead of one partially used vector per row.
+     * @param data - matrix data
+     * @param rows - number of rows
+     * @param cols - number of columns
+     */
+    static void softmax(float *data, size_t rows, size_t cols) {
+        if (cols >= NARROW_ROW_COLS) {
+            for (size_t i = 0; i < rows; ++i) {
+                softmax(data + i * cols, cols);
+            }
+            return;
+        }
+
+        size_t blockRows = std::max<size_t>(1, SOFTMAX_BLOCK_SIZE / std::max<size_t>(1, cols));
+        for (size_t first = 0; first < rows; first += blockRows) {
+            size_t numRows = std::min(blockRows, rows - first);
+            float *block = data + first * cols;
+
+            for (size_t i = 0; i < numRows; ++i) {
+                float *row = block + i * cols;
+                float max = *std::max_element(row, row + cols);
+                for (size_t j = 0; j < cols; ++j) {
+                    row[j] -= max;
+                }
+            }
+
+            exp(block, block, numRows * cols);
+
+            for (size_t i = 0; i < numRows; ++i) {
+                float *row = block + i * cols;
+                float sum = 0;
+                for (size_t j = 0; j < cols; ++j) {
+                    sum += row[j];
+                }
+                float inverseSum = 1 / sum;
+                for (size_t j = 0; j < cols; ++j) {
+                    row[j] *= inverseSum;
+                }
+            }
+        }
+    }
+
+private:
+    // Rows narrower than this are transformed in blocks of SOFTMAX_BLOCK_SIZE elements (fit into L1)
+    static constexpr size_t NARROW_ROW_COLS = 32;
+    static constexpr size_t SOFTMAX_BLOCK_SIZE = 2048;
+
+    /**
+     * @return a * b + c, rounded once if the target has FMA instructions
+     */
+    static float fusedMultiplyAdd(float a, float b, float c) {
+#ifdef __FMA__
+        return std::fma(a, b, c);
+#else
+        // std::fma would be a slow library call
+        return a * b + c;
+#endif
+    }
+
+#ifdef FFNN_VECTOR_MATH_AVX2
+    /**
+     * @param remaining - number of remaining elements (less than 8)
+     * @return mask of the first remaining lanes
+     */
+    static __m256i tailMask(size_t remaining) {
+        return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(remaining)),
+                                  _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    }
+
+    static float horizontalSum(__m256 x) {
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+        return _mm_cvtss_f32(sum);
+    }
+
+    static float horizontalMax(__m256 x) {
+        __m128 max = _mm_max_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+        max = _mm_max_ps(max, _mm_movehl_ps(max, max));
+        max = _mm_max_ss(max, _mm_movehdup_ps(max));
+        return _mm_cvtss_f32(max);
+    }
+#endif
+};
+
+#endif //FEEDFORWARDNEURALNET_VECTOR_MATH_H